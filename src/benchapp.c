@@ -0,0 +1,164 @@
+/** Application for benchmarking the host side overhead of the mme1536
+ *  library on the mod_sim_exp hardware core.
+ *
+ *  Start overhead:
+ *  times the start bit handshake of MME1536_StartSingle_m() and the
+ *  complete single multiplication (start + interrupt wait) for a 512-bit
+ *  modulus, once with the old usleep(1) handshake and once with the
+ *  register-level start pulse.
+ *
+ *  Transfer rate:
+ *  the MB/s each operand memory transfer path (see
+ *  MME1536_SetTransferMode()) achieves when writing and reading a 1536-bit
+ *  operand.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gmp.h"
+
+#include "libmme1536_v1.h"
+
+/***********************************************************************
+ * Required subroutines                                                *
+ **********************************************************************/
+
+double getElapsedNanoSeconds(struct timespec time1, struct timespec time2){
+	return (time2.tv_sec - time1.tv_sec) * 1e9 + (time2.tv_nsec - time1.tv_nsec);
+}
+
+void generate_rand_bin(int * rand_bin, int length, gmp_randstate_t state){
+	mpz_t rand;
+	mpz_init(rand);
+
+	do{
+		mpz_urandomb(rand, state, length);
+	} while(mpz_even_p(rand)!=0); // because the modulus needs to be odd
+	// make sure the top bit is set, so all words are exported
+	mpz_setbit(rand, length-1);
+	mpz_export((void*)rand_bin,NULL,-1,sizeof(int),0,0,rand);
+
+	mpz_clear(rand);
+}
+
+void bench_start(MME1536 * mme_hw, int hold, char * label, int iterations){
+	struct timespec t0, t1, t2;
+	double start_ns = 0, total_ns = 0;
+	int i;
+
+	MME1536_SetStartHold(mme_hw, hold);
+	for(i=0; i<iterations; i++){
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		MME1536_StartSingle_m(mme_hw, OPERAND_3, OPERAND_0, OPERAND_1);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		MME1536_WaitUntilReady(mme_hw);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		start_ns += getElapsedNanoSeconds(t0, t1);
+		total_ns += getElapsedNanoSeconds(t0, t2);
+	}
+
+	printf("%-10s start: %10.1f ns   start+wait: %10.1f ns\n", label,
+	       start_ns / iterations, total_ns / iterations);
+}
+
+void bench_transfer(MME1536 * mme_hw, int mode, char * label, int * data, int iterations){
+	struct timespec t0, t1;
+	double write_ns, read_ns;
+	double bytes = (double)WORDS_TOT * sizeof(int) * iterations;
+	int i;
+
+	if(MME1536_SetTransferMode(mme_hw, mode) != 0){
+		printf("%-10s not available\n", label);
+		return;
+	}
+
+	// change the data each time, else the operand is still resident and the
+	// write is skipped
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i=0; i<iterations; i++){
+		data[i % WORDS_TOT] ^= 1;
+		MME1536_SetOperand(mme_hw, data, OPERAND_0, BITS_TOT);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	write_ns = getElapsedNanoSeconds(t0, t1);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i=0; i<iterations; i++){
+		MME1536_GetOperand(mme_hw, data, OPERAND_0, BITS_TOT);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	read_ns = getElapsedNanoSeconds(t0, t1);
+
+	// bytes/ns * 1000 = MB/s
+	printf("%-10s write: %8.1f MB/s   read: %8.1f MB/s\n", label,
+	       bytes / write_ns * 1e3, bytes / read_ns * 1e3);
+}
+
+void printUsage(){
+	printf("\nUsage: mont_bench [I]\n I:\tthe nr. of iterations per measurement (default 1000)\n");
+}
+
+int main(int argc, char *argv[]){
+	int iterations = 1000;
+	int n = BITS_LOW;
+
+	printf("Benchmark program for the mme1536 library.\n");
+
+	/* Check arguments. */
+	if(argc > 2){
+		printUsage();
+		return 1;
+	}
+	if(argc == 2){
+		iterations = atoi(argv[1]);
+		if(iterations < 1){
+			printUsage();
+			return 1;
+		}
+	}
+
+	/* Generate test variables */
+	gmp_randstate_t state;
+	gmp_randinit_default(state);
+	gmp_randseed_ui(state, 1536);
+
+	int m_bin[WORDS_TOT], x_bin[WORDS_TOT], y_bin[WORDS_TOT];
+	generate_rand_bin(m_bin, n, state);
+	generate_rand_bin(x_bin, n-1, state);
+	generate_rand_bin(y_bin, n-1, state);
+
+	/* Hardware config */
+	MME1536 mme_hw;
+	if(MME1536_Initialize(&mme_hw, NULL) != 0){
+		return 1;
+	}
+	MME1536_UpdateModulus(&mme_hw, m_bin, n);
+	MME1536_SetOperand_m(&mme_hw, x_bin, OPERAND_0);
+	MME1536_SetOperand_m(&mme_hw, y_bin, OPERAND_1);
+
+	/******************************************************************/
+	printf("\nStart overhead (%d-bit multiply, %d iterations)\n", n, iterations);
+	bench_start(&mme_hw, START_HOLD_USLEEP, "usleep(1)", iterations);
+	bench_start(&mme_hw, DEFAULT_START_HOLD, "pulse", iterations);
+
+	/******************************************************************/
+	int default_mode = MME1536_GetTransferMode(&mme_hw);
+	int data_bin[WORDS_TOT];
+	generate_rand_bin(data_bin, BITS_TOT, state);
+
+	printf("\nTransfer rate (%d-bit operand, %d iterations)\n", BITS_TOT, iterations);
+	bench_transfer(&mme_hw, TRANSFER_32, "32-bit", data_bin, iterations);
+	bench_transfer(&mme_hw, TRANSFER_64, "64-bit", data_bin, iterations);
+	bench_transfer(&mme_hw, TRANSFER_NEON, "NEON", data_bin, iterations);
+	MME1536_SetTransferMode(&mme_hw, default_mode);
+
+	/******************************************************************/
+
+	/* Cleanup */
+	MME1536_Clean(&mme_hw);
+	gmp_randclear(state);
+
+	return 0;
+}
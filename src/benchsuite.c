@@ -0,0 +1,388 @@
+/** Non-interactive benchmark suite for the mme1536 library on the
+ *  mod_sim_exp hardware core.
+ *
+ *  Sweeps the operand length n (512, 1024 and 1536 bits), the exponent
+ *  length t and the single (MME1536_Exp_m()) and double (MME1536_MME_m())
+ *  exponent variants over three modes:
+ *   sync:  one blocking call per operation
+ *   batch: MME1536_ExpBatch_m() with SUITE_BATCH operations per call
+ *          (single exponent only)
+ *   async: MME1536_SubmitExp_m()/MME1536_SubmitMME_m() with SUITE_DEPTH
+ *          jobs in flight, buffers borrowed from the job arena
+ *  and the same computations with GMP as baseline (mode gmp).
+ *
+ *  For each point it reports the operations per second, the p50 and p99
+ *  latency (submission to result), the cpu utilisation of the process and
+ *  whether the results matched GMP, as CSV or JSON on stdout. The operands
+ *  come from a fixed seed, so runs can be compared. With the emu option the
+ *  suite runs on the software model of the core (libmme1536_emu.c).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gmp.h"
+
+#include "libmme1536_v1.h"
+#include "libmme1536_emu.h"
+
+// operations per MME1536_ExpBatch_m() call
+#define SUITE_BATCH	8
+// asynchronous jobs in flight
+#define SUITE_DEPTH	8
+// longest exponent in the sweep (#bits)
+#define SUITE_T_MAX	2048
+
+int suite_n[] = {BITS_LOW, BITS_HIGH, BITS_TOT};
+int suite_t[] = {32, 256, 1024, SUITE_T_MAX};
+
+/// operands of one point of the sweep
+typedef struct{
+	int n, t;
+	mpz_t m, g0, g1, e0, e1;
+	mpz_t single, dual; // expected results of the variants
+	int m_bin[WORDS_TOT], g0_bin[WORDS_TOT], g1_bin[WORDS_TOT];
+	int e0_bin[SUITE_T_MAX/32], e1_bin[SUITE_T_MAX/32];
+	int single_bin[WORDS_TOT], dual_bin[WORDS_TOT];
+} suite_operands;
+
+/// measurements of one point
+typedef struct{
+	char * variant;
+	char * mode;
+	int iterations;
+	double * latency_ns;
+	double wall_ns, cpu_ns;
+	int ok;
+} suite_result;
+
+/***********************************************************************
+ * Required subroutines                                                *
+ **********************************************************************/
+
+double getElapsedNanoSeconds(struct timespec time1, struct timespec time2){
+	return (time2.tv_sec - time1.tv_sec) * 1e9 + (time2.tv_nsec - time1.tv_nsec);
+}
+
+double now_ns(clockid_t clock){
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+void export_bin(int * bin, int words, mpz_t x){
+	memset(bin, 0, words * sizeof(int));
+	mpz_export((void*)bin,NULL,-1,sizeof(int),0,0,x);
+}
+
+void generate_operands(suite_operands * op, int n, int t, gmp_randstate_t state){
+	mpz_t r;
+
+	op->n = n;
+	op->t = t;
+	// odd n-bit modulus, bases below it, t-bit exponents
+	do{
+		mpz_urandomb(op->m, state, n);
+		mpz_setbit(op->m, n-1);
+	} while(mpz_even_p(op->m)!=0);
+	mpz_urandomm(op->g0, state, op->m);
+	mpz_urandomm(op->g1, state, op->m);
+	mpz_urandomb(op->e0, state, t);
+	mpz_setbit(op->e0, t-1);
+	mpz_urandomb(op->e1, state, t);
+	mpz_setbit(op->e1, t-1);
+
+	mpz_powm(op->single, op->g0, op->e0, op->m);
+	mpz_init(r);
+	mpz_powm(r, op->g1, op->e1, op->m);
+	mpz_mul(op->dual, op->single, r);
+	mpz_mod(op->dual, op->dual, op->m);
+	mpz_clear(r);
+
+	export_bin(op->m_bin, WORDS_TOT, op->m);
+	export_bin(op->g0_bin, WORDS_TOT, op->g0);
+	export_bin(op->g1_bin, WORDS_TOT, op->g1);
+	export_bin(op->e0_bin, SUITE_T_MAX/32, op->e0);
+	export_bin(op->e1_bin, SUITE_T_MAX/32, op->e1);
+	export_bin(op->single_bin, WORDS_TOT, op->single);
+	export_bin(op->dual_bin, WORDS_TOT, op->dual);
+}
+
+int matches(suite_operands * op, int dual, int * result){
+	return memcmp(result, dual ? op->dual_bin : op->single_bin, (op->n/32) * sizeof(int)) == 0;
+}
+
+int compare_double(const void * a, const void * b){
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+double percentile(double * sorted, int count, double p){
+	int i = (int)(p / 100.0 * count + 0.999999) - 1;
+
+	if(i < 0) i = 0;
+	if(i >= count) i = count - 1;
+	return sorted[i];
+}
+
+/***********************************************************************
+ * Benchmarks                                                          *
+ **********************************************************************/
+
+void bench_gmp(suite_operands * op, int dual, suite_result * res){
+	mpz_t r, r1;
+	double t0;
+	int i;
+
+	mpz_init(r);
+	mpz_init(r1);
+	for(i=0; i<res->iterations; i++){
+		t0 = now_ns(CLOCK_MONOTONIC);
+		mpz_powm(r, op->g0, op->e0, op->m);
+		if(dual){
+			mpz_powm(r1, op->g1, op->e1, op->m);
+			mpz_mul(r, r, r1);
+			mpz_mod(r, r, op->m);
+		}
+		res->latency_ns[i] = now_ns(CLOCK_MONOTONIC) - t0;
+	}
+	res->ok = (mpz_cmp(r, dual ? op->dual : op->single) == 0);
+	mpz_clear(r1);
+	mpz_clear(r);
+}
+
+void bench_sync(MME1536 * mme_hw, suite_operands * op, int dual, suite_result * res){
+	int result_bin[WORDS_TOT];
+	double t0;
+	int i;
+
+	for(i=0; i<res->iterations; i++){
+		t0 = now_ns(CLOCK_MONOTONIC);
+		if(dual) MME1536_MME_m(mme_hw, result_bin, op->g0_bin, op->g1_bin, op->e0_bin, op->e1_bin, op->t);
+		else MME1536_Exp_m(mme_hw, result_bin, op->g0_bin, op->e0_bin, op->t);
+		res->latency_ns[i] = now_ns(CLOCK_MONOTONIC) - t0;
+	}
+	res->ok = matches(op, dual, result_bin);
+}
+
+void bench_batch(MME1536 * mme_hw, suite_operands * op, suite_result * res){
+	int result_bin[SUITE_BATCH][WORDS_TOT];
+	int * results[SUITE_BATCH];
+	int * bases[SUITE_BATCH];
+	int * exps[SUITE_BATCH];
+	double t0, elapsed;
+	int i, j, count;
+
+	for(j=0; j<SUITE_BATCH; j++){
+		results[j] = result_bin[j];
+		bases[j] = op->g0_bin;
+		exps[j] = op->e0_bin;
+	}
+	res->ok = 1;
+	for(i=0; i<res->iterations; i+=count){
+		count = res->iterations - i;
+		if(count > SUITE_BATCH) count = SUITE_BATCH;
+		t0 = now_ns(CLOCK_MONOTONIC);
+		MME1536_ExpBatch_m(mme_hw, results, bases, exps, count, op->t);
+		elapsed = now_ns(CLOCK_MONOTONIC) - t0;
+		// all results of a call become available at its end
+		for(j=0; j<count; j++){
+			res->latency_ns[i+j] = elapsed;
+			if(!matches(op, 0, result_bin[j])) res->ok = 0;
+		}
+	}
+}
+
+void bench_async(MME1536 * mme_hw, suite_operands * op, int dual, suite_result * res){
+	MME1536_JobBuf * buf[SUITE_DEPTH];
+	double submitted[SUITE_DEPTH];
+	int i, slot, depth;
+
+	for(depth=0; depth<SUITE_DEPTH; depth++){
+		buf[depth] = MME1536_ArenaBorrow(mme_hw);
+		if(buf[depth] == NULL) break;
+	}
+	res->ok = (depth > 0);
+	// job i uses slot i % depth, which job i - depth has to leave first
+	for(i=0; (depth > 0) && (i<res->iterations + depth); i++){
+		slot = i % depth;
+		if(i >= depth){
+			MME1536_Complete(mme_hw, &(buf[slot]->job));
+			res->latency_ns[i-depth] = now_ns(CLOCK_MONOTONIC) - submitted[slot];
+			if(!matches(op, dual, buf[slot]->result)) res->ok = 0;
+		}
+		if(i < res->iterations){
+			submitted[slot] = now_ns(CLOCK_MONOTONIC);
+			if(dual) MME1536_SubmitMME_m(mme_hw, &(buf[slot]->job), buf[slot]->result, op->g0_bin, op->g1_bin, op->e0_bin, op->e1_bin, op->t);
+			else MME1536_SubmitExp_m(mme_hw, &(buf[slot]->job), buf[slot]->result, op->g0_bin, op->e0_bin, op->t);
+		}
+	}
+	for(slot=0; slot<depth; slot++){
+		MME1536_ArenaReturn(mme_hw, buf[slot]);
+	}
+}
+
+/***********************************************************************
+ * Output                                                              *
+ **********************************************************************/
+
+void print_header(int json){
+	if(json) printf("[\n");
+	else printf("n,t,variant,mode,iterations,ops_per_s,p50_us,p99_us,cpu_pct,ok\n");
+}
+
+void print_result(int json, int first, suite_operands * op, suite_result * res){
+	double ops_per_s, p50_us, p99_us, cpu_pct;
+
+	qsort(res->latency_ns, res->iterations, sizeof(double), compare_double);
+	ops_per_s = res->iterations / res->wall_ns * 1e9;
+	p50_us = percentile(res->latency_ns, res->iterations, 50) / 1e3;
+	p99_us = percentile(res->latency_ns, res->iterations, 99) / 1e3;
+	cpu_pct = res->cpu_ns / res->wall_ns * 100.0;
+
+	if(json){
+		printf("%s  {\"n\": %d, \"t\": %d, \"variant\": \"%s\", \"mode\": \"%s\", \"iterations\": %d, "
+		       "\"ops_per_s\": %.1f, \"p50_us\": %.2f, \"p99_us\": %.2f, \"cpu_pct\": %.1f, \"ok\": %s}",
+		       first ? "" : ",\n", op->n, op->t, res->variant, res->mode, res->iterations,
+		       ops_per_s, p50_us, p99_us, cpu_pct, res->ok ? "true" : "false");
+	}
+	else{
+		printf("%d,%d,%s,%s,%d,%.1f,%.2f,%.2f,%.1f,%d\n", op->n, op->t, res->variant, res->mode,
+		       res->iterations, ops_per_s, p50_us, p99_us, cpu_pct, res->ok);
+	}
+	fflush(stdout);
+}
+
+void print_footer(int json){
+	if(json) printf("\n]\n");
+}
+
+void printUsage(){
+	printf("\nUsage: mont_suite [F] [I] [emu]\n F:\toutput format, csv (default) or json\n I:\tthe nr. of operations per point (default 100)\n emu:\trun on the software model of the core\n");
+}
+
+/***********************************************************************
+ * Main                                                                *
+ **********************************************************************/
+
+int main(int argc, char *argv[]){
+	int iterations = 100;
+	int json = 0;
+	int first = 1;
+	int ni, ti, dual, mode;
+	int emu = 0;
+	char * modes[] = {"gmp", "sync", "batch", "async"};
+
+	/* Check arguments. */
+	if((argc >= 2) && (strcmp(argv[argc - 1], "emu") == 0)){
+		emu = 1;
+		argc--;
+	}
+	if(argc > 3){
+		printUsage();
+		return 1;
+	}
+	if(argc >= 2){
+		if(strcmp(argv[1], "json") == 0) json = 1;
+		else if(strcmp(argv[1], "csv") != 0){
+			printUsage();
+			return 1;
+		}
+	}
+	if(argc == 3){
+		iterations = atoi(argv[2]);
+		if(iterations < 1){
+			printUsage();
+			return 1;
+		}
+	}
+
+	/* Operands from a fixed seed */
+	gmp_randstate_t state;
+	gmp_randinit_default(state);
+	gmp_randseed_ui(state, 1536);
+
+	suite_operands op;
+	mpz_init(op.m);
+	mpz_init(op.g0);
+	mpz_init(op.g1);
+	mpz_init(op.e0);
+	mpz_init(op.e1);
+	mpz_init(op.single);
+	mpz_init(op.dual);
+
+	suite_result res;
+	res.iterations = iterations;
+	res.latency_ns = (double *)malloc(iterations * sizeof(double));
+	if(res.latency_ns == NULL){
+		printf("Could not allocate memory for the latencies!\n");
+		return 1;
+	}
+
+	/* Hardware config (the UIO device is passed explicitly, so nothing
+	 * but the results is printed on stdout) */
+	MME1536 mme_hw;
+	MME1536_Emu mme_emu;
+	if(emu){
+		if(MME1536_EmuInitialize(&mme_hw, &mme_emu, NULL) != 0){
+			return 1;
+		}
+	}
+	else if(MME1536_Initialize(&mme_hw, DEFAULT_UIO_DEV) != 0){
+		return 1;
+	}
+	if(MME1536_ArenaInit(&mme_hw, SUITE_DEPTH, SUITE_T_MAX) != 0){
+		MME1536_Clean(&mme_hw);
+		return 1;
+	}
+
+	/******************************************************************/
+	print_header(json);
+	for(ni=0; ni<(int)(sizeof(suite_n)/sizeof(int)); ni++){
+		for(ti=0; ti<(int)(sizeof(suite_t)/sizeof(int)); ti++){
+			generate_operands(&op, suite_n[ni], suite_t[ti], state);
+			MME1536_UpdateModulus(&mme_hw, op.m_bin, op.n);
+
+			for(dual=0; dual<=1; dual++){
+				for(mode=0; mode<4; mode++){
+					// there is no batch call for two exponents
+					if(dual && (mode == 2)) continue;
+					res.variant = dual ? "mme" : "exp";
+					res.mode = modes[mode];
+
+					double wall0 = now_ns(CLOCK_MONOTONIC);
+					double cpu0 = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+					switch(mode){
+						case 0: bench_gmp(&op, dual, &res); break;
+						case 1: bench_sync(&mme_hw, &op, dual, &res); break;
+						case 2: bench_batch(&mme_hw, &op, &res); break;
+						case 3: bench_async(&mme_hw, &op, dual, &res); break;
+					}
+					res.wall_ns = now_ns(CLOCK_MONOTONIC) - wall0;
+					res.cpu_ns = now_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu0;
+
+					print_result(json, first, &op, &res);
+					first = 0;
+				}
+			}
+		}
+	}
+	print_footer(json);
+
+	/******************************************************************/
+
+	/* Cleanup */
+	MME1536_Clean(&mme_hw);
+	free(res.latency_ns);
+	mpz_clear(op.m);
+	mpz_clear(op.g0);
+	mpz_clear(op.g1);
+	mpz_clear(op.e0);
+	mpz_clear(op.e1);
+	mpz_clear(op.single);
+	mpz_clear(op.dual);
+	gmp_randclear(state);
+
+	return 0;
+}
@@ -0,0 +1,366 @@
+/** @file libmme1536_dispatch.c This file contains the source code for
+ * spreading g0^e0 * g1^e1 mod m jobs over a core and GMP worker threads.
+ *
+ * Every job goes to the route that is predicted to finish it first: the
+ * predicted run time on the route plus the work already waiting there
+ * (divided over the workers for the software route). The run times follow
+ * a linear model in the exponent length per operand length, fitted at
+ * start-up on an idle core and idle workers. A correction factor per route
+ * and length follows the measured latencies (EWMA), so the model adapts to
+ * the real load, e.g. other users of the core or of the cpus. Short
+ * exponents and a backlogged core end up in software, so both engines are
+ * kept busy.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libmme1536_dispatch.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+void MME1536_DispatchPost(MME1536_Dispatch * dispatch, MME1536_DispatchJob * job, int route, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+void MME1536_DispatchDone(MME1536_MtJob * hw);
+void * MME1536_DispatchWorker(void * arg);
+void MME1536_DispatchSoftware(MME1536_MtJob * op);
+void MME1536_DispatchCalibrate(MME1536_Dispatch * dispatch);
+double MME1536_DispatchMeasure(MME1536_Dispatch * dispatch, int route, int n, int t);
+double MME1536_DispatchElapsedUs(struct timespec * start);
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Start the GMP workers and calibrate the cost model. This runs a few
+ * jobs on both routes, so the owner thread of the core must be running.
+ *
+ * @param dispatch is a pointer to the dispatcher
+ * @param mt is a pointer to the (started) shared core
+ * @param workers is the nr. of GMP worker threads
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_DispatchStart(MME1536_Dispatch * dispatch, MME1536_Mt * mt, int workers){
+	int i;
+
+	if((workers < 1) || (workers > DISPATCH_MAX_WORKERS)){
+		printf("[ERROR] MME1536: DispatchStart() -> wrong nr. of workers (%d)\n", workers);
+		return -1;
+	}
+
+	memset(dispatch, 0, sizeof(MME1536_Dispatch));
+	dispatch->mt = mt;
+	pthread_mutex_init(&(dispatch->lock), NULL);
+	pthread_cond_init(&(dispatch->work), NULL);
+	for(i=0; i<workers; i++){
+		if(pthread_create(&(dispatch->worker[i]), NULL, MME1536_DispatchWorker, dispatch) != 0){
+			printf("[ERROR] MME1536: DispatchStart() -> could not start worker %d\n", i);
+			break;
+		}
+	}
+	dispatch->workers = i;
+	if(i == 0){
+		pthread_mutex_destroy(&(dispatch->lock));
+		pthread_cond_destroy(&(dispatch->work));
+		return -1;
+	}
+
+	MME1536_DispatchCalibrate(dispatch);
+
+	return 0;
+}
+
+/** Finish the waiting software jobs and stop the workers. The shared core
+ * is left running.
+ *
+ * @param dispatch is a pointer to the dispatcher
+ *
+ * @return nothing
+ */
+void MME1536_DispatchStop(MME1536_Dispatch * dispatch){
+	int i;
+
+	pthread_mutex_lock(&(dispatch->lock));
+	dispatch->stop = 1;
+	pthread_cond_broadcast(&(dispatch->work));
+	pthread_mutex_unlock(&(dispatch->lock));
+
+	for(i=0; i<dispatch->workers; i++){
+		pthread_join(dispatch->worker[i], NULL);
+	}
+	pthread_mutex_destroy(&(dispatch->lock));
+	pthread_cond_destroy(&(dispatch->work));
+}
+
+/** Submit the computation of g0^e0 * g1^e1 mod m (see MME1536_MME()) to
+ * the route that is predicted to finish it first. All buffers must stay
+ * valid until the job is done.
+ *
+ * @param dispatch is a pointer to the dispatcher
+ * @param job is a pointer to the job
+ * @param result is a pointer to the buffer where the result will be stored
+ * @param g0, g1, e0, e1, m are arrays containing the bases and exponents
+ *        (e1 may be NULL)
+ * @param n is the length of g0, g1 and m (#bits)
+ * @param t is the length of the exponents (#bits)
+ *
+ * @return 0 upon success
+ *         -1 for a wrong operand length
+ */
+int MME1536_DispatchSubmit(MME1536_Dispatch * dispatch, MME1536_DispatchJob * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	double cost_hw, cost_sw, eta_hw, eta_sw;
+	int size = n / BITS_LOW - 1;
+
+	if((n != BITS_LOW) && (n != BITS_HIGH) && (n != BITS_TOT)){
+		printf("[ERROR] MME1536: DispatchSubmit() -> wrong operand length: %d\n", n);
+		return -1;
+	}
+
+	pthread_mutex_lock(&(dispatch->lock));
+	cost_hw = dispatch->scale[DISPATCH_HW][size] * (dispatch->a_us[DISPATCH_HW][size] + dispatch->b_us[DISPATCH_HW][size] * t);
+	cost_sw = dispatch->scale[DISPATCH_SW][size] * (dispatch->a_us[DISPATCH_SW][size] + dispatch->b_us[DISPATCH_SW][size] * t);
+	eta_hw = dispatch->backlog_us[DISPATCH_HW] + cost_hw;
+	eta_sw = dispatch->backlog_us[DISPATCH_SW] / dispatch->workers + cost_sw;
+	if(eta_sw < eta_hw){
+		job->route = DISPATCH_SW;
+		job->cost_us = cost_sw;
+		job->eta_us = eta_sw;
+	}
+	else{
+		job->route = DISPATCH_HW;
+		job->cost_us = cost_hw;
+		job->eta_us = eta_hw;
+	}
+	dispatch->backlog_us[job->route] += job->cost_us;
+	dispatch->jobs[job->route]++;
+	pthread_mutex_unlock(&(dispatch->lock));
+
+	MME1536_DispatchPost(dispatch, job, job->route, result, g0, g1, m, e0, e1, n, t);
+
+	return 0;
+}
+
+/** Check whether a submitted job is done.
+ *
+ * @return 1 if the job is done
+ *         0 otherwise
+ */
+int MME1536_DispatchTest(MME1536_DispatchJob * job){
+	return MME1536_MtTest(&(job->hw));
+}
+
+/** Wait until a submitted job is done.
+ *
+ * @param job is a pointer to the submitted job
+ *
+ * @return 0 upon success
+ *         -1 if the job failed (see MME1536_MtWait())
+ */
+int MME1536_DispatchWait(MME1536_DispatchJob * job){
+	return MME1536_MtWait(&(job->hw));
+}
+
+/** Get the nr. of jobs sent to each route.
+ *
+ * @param dispatch is a pointer to the dispatcher
+ * @param hw_jobs, sw_jobs are set to the nr. of jobs sent to the core and
+ *        to the GMP workers
+ *
+ * @return nothing
+ */
+void MME1536_DispatchGetStats(MME1536_Dispatch * dispatch, unsigned long * hw_jobs, unsigned long * sw_jobs){
+	pthread_mutex_lock(&(dispatch->lock));
+	*hw_jobs = dispatch->jobs[DISPATCH_HW];
+	*sw_jobs = dispatch->jobs[DISPATCH_SW];
+	pthread_mutex_unlock(&(dispatch->lock));
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** Hand a job to a route.
+ */
+void MME1536_DispatchPost(MME1536_Dispatch * dispatch, MME1536_DispatchJob * job, int route, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	MME1536_MtJob * hw = &(job->hw);
+
+	hw->type = MT_MME;
+	hw->result = result;
+	hw->g0 = g0;
+	hw->g1 = g1;
+	hw->m = m;
+	hw->e0 = e0;
+	hw->e1 = e1;
+	hw->n = n;
+	hw->t = t;
+	hw->on_done = MME1536_DispatchDone;
+	hw->arg = job;
+
+	job->dispatch = dispatch;
+	job->route = route;
+	job->size = n / BITS_LOW - 1;
+	clock_gettime(CLOCK_MONOTONIC, &(job->submitted));
+
+	if(route == DISPATCH_HW){
+		MME1536_MtSubmitJob(dispatch->mt, hw);
+		return;
+	}
+
+	atomic_store_explicit(&(hw->done), MT_PENDING, memory_order_relaxed);
+	hw->error = 0;
+	job->next = NULL;
+	pthread_mutex_lock(&(dispatch->lock));
+	if(dispatch->tail != NULL) dispatch->tail->next = job;
+	else dispatch->head = job;
+	dispatch->tail = job;
+	pthread_cond_signal(&(dispatch->work));
+	pthread_mutex_unlock(&(dispatch->lock));
+}
+
+/** Account for a finished job (called by the thread that finishes it):
+ * remove it from the backlog and correct the model of its route with the
+ * ratio of the measured and predicted latency.
+ */
+void MME1536_DispatchDone(MME1536_MtJob * hw){
+	MME1536_DispatchJob * job = (MME1536_DispatchJob *)hw->arg;
+	MME1536_Dispatch * dispatch = job->dispatch;
+	double * scale;
+
+	job->latency_us = MME1536_DispatchElapsedUs(&(job->submitted));
+
+	pthread_mutex_lock(&(dispatch->lock));
+	dispatch->backlog_us[job->route] -= job->cost_us;
+	if(dispatch->backlog_us[job->route] < 0) dispatch->backlog_us[job->route] = 0;
+	if(job->eta_us > 0){
+		scale = &(dispatch->scale[job->route][job->size]);
+		*scale *= 1 + DISPATCH_ALPHA * (job->latency_us / job->eta_us - 1);
+		// keep one bad measurement from locking a route out
+		if(*scale < 0.05) *scale = 0.05;
+		if(*scale > 20) *scale = 20;
+	}
+	pthread_mutex_unlock(&(dispatch->lock));
+}
+
+void * MME1536_DispatchWorker(void * arg){
+	MME1536_Dispatch * dispatch = (MME1536_Dispatch *)arg;
+	MME1536_DispatchJob * job;
+
+	while(1){
+		pthread_mutex_lock(&(dispatch->lock));
+		while((dispatch->head == NULL) && !dispatch->stop){
+			pthread_cond_wait(&(dispatch->work), &(dispatch->lock));
+		}
+		job = dispatch->head;
+		if(job != NULL){
+			dispatch->head = job->next;
+			if(dispatch->head == NULL) dispatch->tail = NULL;
+		}
+		pthread_mutex_unlock(&(dispatch->lock));
+		if(job == NULL) break;
+
+		MME1536_DispatchSoftware(&(job->hw));
+		MME1536_MtFinish(&(job->hw));
+	}
+
+	return NULL;
+}
+
+/** g0^e0 * g1^e1 mod m with GMP.
+ */
+void MME1536_DispatchSoftware(MME1536_MtJob * op){
+	mpz_t g, e, m, h0, h1;
+	int words = op->n / 32;
+
+	mpz_init(g);
+	mpz_init(e);
+	mpz_init(m);
+	mpz_init(h0);
+	mpz_init(h1);
+	mpz_import(m, words, -1, sizeof(int), 0, 0, op->m);
+
+	mpz_import(g, words, -1, sizeof(int), 0, 0, op->g0);
+	mpz_import(e, op->t / 32, -1, sizeof(int), 0, 0, op->e0);
+	mpz_powm(h0, g, e, m);
+	if(op->e1 != NULL){
+		mpz_import(g, words, -1, sizeof(int), 0, 0, op->g1);
+		mpz_import(e, op->t / 32, -1, sizeof(int), 0, 0, op->e1);
+		mpz_powm(h1, g, e, m);
+		mpz_mul(h0, h0, h1);
+		mpz_mod(h0, h0, m);
+	}
+
+	memset(op->result, 0, words * sizeof(int));
+	mpz_export((void *)op->result, NULL, -1, sizeof(int), 0, 0, h0);
+
+	mpz_clear(g);
+	mpz_clear(e);
+	mpz_clear(m);
+	mpz_clear(h0);
+	mpz_clear(h1);
+}
+
+/** Fit a_us and b_us of both routes and all lengths from one job at
+ * DISPATCH_CAL_T0 and one at DISPATCH_CAL_T1 exponent bits.
+ */
+void MME1536_DispatchCalibrate(MME1536_Dispatch * dispatch){
+	double l0, l1, b;
+	int route, size;
+
+	for(route=DISPATCH_HW; route<=DISPATCH_SW; route++){
+		for(size=0; size<DISPATCH_SIZES; size++){
+			l0 = MME1536_DispatchMeasure(dispatch, route, (size + 1) * BITS_LOW, DISPATCH_CAL_T0);
+			l1 = MME1536_DispatchMeasure(dispatch, route, (size + 1) * BITS_LOW, DISPATCH_CAL_T1);
+			b = (l1 - l0) / (DISPATCH_CAL_T1 - DISPATCH_CAL_T0);
+			if(b < 0) b = 0;
+			dispatch->b_us[route][size] = b;
+			dispatch->a_us[route][size] = (l0 > b * DISPATCH_CAL_T0) ? l0 - b * DISPATCH_CAL_T0 : 0;
+			dispatch->scale[route][size] = 1;
+		}
+	}
+}
+
+/** Latency of one job on an idle route (us).
+ */
+double MME1536_DispatchMeasure(MME1536_Dispatch * dispatch, int route, int n, int t){
+	int m[WORDS_TOT], g0[WORDS_TOT], g1[WORDS_TOT], result[WORDS_TOT];
+	int e0[DISPATCH_CAL_T1 / 32], e1[DISPATCH_CAL_T1 / 32];
+	MME1536_DispatchJob job;
+	int i;
+
+	// fixed operands with all bits in use: odd m, g < m
+	for(i=0; i<n/32; i++){
+		m[i] = (int)(0x9e3779b9u * (i + 1));
+		g0[i] = m[i] ^ 0x5a5a5a5a;
+		g1[i] = m[i] ^ 0x0f0f0f0f;
+	}
+	m[0] |= 1;
+	m[n/32 - 1] |= 0x80000000;
+	g0[n/32 - 1] &= 0x7fffffff;
+	g1[n/32 - 1] &= 0x7fffffff;
+	for(i=0; i<t/32; i++){
+		e0[i] = (int)(0x6b43a9b5u * (i + 3));
+		e1[i] = (int)(0x2545f491u * (i + 5));
+	}
+
+	job.cost_us = 0;
+	job.eta_us = 0;
+	MME1536_DispatchPost(dispatch, &job, route, result, g0, g1, m, e0, e1, n, t);
+	MME1536_DispatchWait(&job);
+
+	return job.latency_us;
+}
+
+double MME1536_DispatchElapsedUs(struct timespec * start){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1e6 + (now.tv_nsec - start->tv_nsec) / 1e3;
+}
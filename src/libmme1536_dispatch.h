@@ -0,0 +1,86 @@
+/** @file libmme1536_dispatch.h Header file for libmme1536_dispatch.c
+ * Contains the definitions and function prototypes for spreading
+ * g0^e0 * g1^e1 mod m jobs over a core and a pool of GMP worker threads.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_DISPATCH_H_
+#define _LIBMME1536_DISPATCH_H_
+
+#include <pthread.h>
+
+#include "gmp.h"
+
+#include "libmme1536_mt.h"
+
+// maximum nr. of GMP worker threads
+#define DISPATCH_MAX_WORKERS	16
+
+// routes
+#define DISPATCH_HW	0 // the core (through the thread-safe queue)
+#define DISPATCH_SW	1 // a GMP worker thread
+
+// nr. of operand lengths in the cost model (512, 1024 and 1536 bits)
+#define DISPATCH_SIZES	3
+
+// exponent lengths used to calibrate the cost model (#bits)
+#define DISPATCH_CAL_T0	64
+#define DISPATCH_CAL_T1	512
+
+// weight of a new latency measurement in the model correction (EWMA)
+#define DISPATCH_ALPHA	0.125
+
+/// a job submitted to the dispatcher
+typedef struct mme1536_dispatch_job_st{
+	/* descriptor for the core, its completion futex is used for both
+	 * routes */
+	MME1536_MtJob hw;
+
+	struct mme1536_dispatch_st * dispatch;
+	int route, size;
+	double cost_us; // predicted run time on the route
+	double eta_us; // predicted latency at submission (0: not predicted)
+	double latency_us; // measured latency
+	struct timespec submitted;
+
+	/* waiting software jobs */
+	struct mme1536_dispatch_job_st * next;
+} MME1536_DispatchJob;
+
+/// a core and a pool of GMP worker threads
+typedef struct mme1536_dispatch_st{
+	MME1536_Mt * mt;
+
+	/* GMP workers and their queue */
+	pthread_t worker[DISPATCH_MAX_WORKERS];
+	int workers;
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	MME1536_DispatchJob * head;
+	MME1536_DispatchJob * tail;
+	int stop;
+
+	/* cost model per route and operand length: latency of a job on an idle
+	 * engine is a_us + b_us.t, times the correction scale that follows the
+	 * measured latencies; backlog_us is the predicted work in each route */
+	double a_us[2][DISPATCH_SIZES];
+	double b_us[2][DISPATCH_SIZES];
+	double scale[2][DISPATCH_SIZES];
+	double backlog_us[2];
+	unsigned long jobs[2];
+} MME1536_Dispatch;
+
+/** Function prototypes
+ */
+
+int MME1536_DispatchStart(MME1536_Dispatch * dispatch, MME1536_Mt * mt, int workers);
+void MME1536_DispatchStop(MME1536_Dispatch * dispatch);
+
+int MME1536_DispatchSubmit(MME1536_Dispatch * dispatch, MME1536_DispatchJob * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+int MME1536_DispatchTest(MME1536_DispatchJob * job);
+int MME1536_DispatchWait(MME1536_DispatchJob * job);
+void MME1536_DispatchGetStats(MME1536_Dispatch * dispatch, unsigned long * hw_jobs, unsigned long * sw_jobs);
+
+#endif /*_LIBMME1536_DISPATCH_H_*/
@@ -0,0 +1,423 @@
+/** @file libmme1536_emu.c This file contains the source code of a software
+ * model of the mod_sim_exp core, to run and profile the driver off-target.
+ *
+ * The model sits under the normal API as a backend (see
+ * MME1536_InitializeBackend()): the driver writes and reads the operand
+ * RAMs, the exponent fifo and the registers as plain memory, and the model
+ * takes over at the start bit, the fifo writes and the interrupt counter.
+ *
+ * It is cycle-approximate: a single montgomery multiplication takes
+ * start_cycles + mult_cycles[part] clock cycles, an auto-run start_cycles
+ * plus, for each fifo entry, 16 squarings and one multiplication per set
+ * bit pair. The fifo holds fifo_depth entries; an entry written while the
+ * auto-run is still busy extends it, a write to a full fifo is dropped and
+ * flagged in IPISR like on the core. The interrupt becomes pending irq_ns
+ * after the last multiplication and is signalled on a timerfd, so the
+ * driver waits on it exactly like on the UIO device.
+ *
+ * The results are computed with the same montgomery multiplication as the
+ * core (R = 2^n, fully reduced) at the moment an operation is started or
+ * an entry is accepted, which costs host time in MME1536_PulseStart() and
+ * the fifo writes. With compute set to 0 only the timing is modelled, for
+ * profiling the scheduling and batching at realistic job rates.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "libmme1536_emu.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+void MME1536_EmuStart(MME1536 * device_instance, unsigned control);
+void MME1536_EmuFifoPush(MME1536 * device_instance, unsigned entry);
+int MME1536_EmuReadInterrupts(MME1536 * device_instance);
+void MME1536_EmuReset(MME1536 * device_instance);
+void MME1536_EmuClean(MME1536 * device_instance);
+void MME1536_EmuFree(MME1536_Emu * emu);
+unsigned long long MME1536_EmuNow(void);
+unsigned long long MME1536_EmuCycles(MME1536_Emu * emu, unsigned long long cycles);
+void MME1536_EmuArm(MME1536_Emu * emu);
+void MME1536_EmuFinish(MME1536_Emu * emu);
+void MME1536_EmuEntry(MME1536_Emu * emu, unsigned entry);
+void MME1536_EmuMont(MME1536_Emu * emu, unsigned * r, unsigned * x, unsigned * y);
+unsigned * MME1536_EmuOperand(MME1536_Emu * emu, int operand);
+
+// hooks of the model
+static const MME1536_Backend emu_backend = {
+	"emu",
+	MME1536_EmuStart,
+	MME1536_EmuFifoPush,
+	MME1536_EmuReadInterrupts,
+	MME1536_EmuReset,
+	MME1536_EmuClean
+};
+
+// memory offset of each operand (OPERAND_0 to MODULUS)
+static const int emu_offsets[5] = {
+	OP0_OFFSET, OP1_OFFSET, OP2_OFFSET, OP3_OFFSET, M_OFFSET};
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Fill in the default timing of the model.
+ *
+ * @param config is the configuration to fill in
+ *
+ * @return nothing
+ */
+void MME1536_EmuDefaults(MME1536_EmuConfig * config){
+	config->clock_mhz = EMU_CLOCK_MHZ;
+	config->mult_cycles[LOW_PART - 1] = EMU_MULT_CYCLES_LOW;
+	config->mult_cycles[HIGH_PART - 1] = EMU_MULT_CYCLES_HIGH;
+	config->mult_cycles[TOT_PIPELINE - 1] = EMU_MULT_CYCLES_TOT;
+	config->start_cycles = EMU_START_CYCLES;
+	config->irq_ns = EMU_IRQ_NS;
+	config->fifo_depth = DEFAULT_FIFO_DEPTH;
+	config->compute = 1;
+}
+
+/** Initialise a handle on the software model of the core. The handle is
+ * used as after MME1536_Initialize() and released with MME1536_Clean().
+ *
+ * @param device_instance is a pointer to a MME1536 variable
+ * @param emu is the state of the model (must stay valid until
+ *        MME1536_Clean())
+ * @param config is the timing of the model (NULL for the defaults, see
+ *        MME1536_EmuDefaults())
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_EmuInitialize(MME1536 * device_instance, MME1536_Emu * emu, const MME1536_EmuConfig * config){
+	void * data;
+	int i;
+
+	memset(emu, 0, sizeof(MME1536_Emu));
+	if(config == NULL) MME1536_EmuDefaults(&(emu->config));
+	else emu->config = *config;
+	if(emu->config.clock_mhz <= 0 || emu->config.fifo_depth < 1 || emu->config.start_cycles < 0 || emu->config.irq_ns < 0){
+		printf("[ERROR] MME1536: EmuInitialize() -> invalid configuration\n");
+		return -1;
+	}
+	for(i=0; i<3; i++){
+		if(emu->config.mult_cycles[i] < 1){
+			printf("[ERROR] MME1536: EmuInitialize() -> invalid nr. of cycles for part %d (%d)\n", i + 1, emu->config.mult_cycles[i]);
+			return -1;
+		}
+	}
+
+	// aligned like the mapped core, for the wide transfers
+	emu->fd = -1;
+	if(posix_memalign(&data, PAGE_SIZE, PAGE_SIZE * 6) != 0) data = NULL;
+	emu->data = (unsigned *)data;
+	emu->ctrl = (unsigned *)calloc(PAGE_SIZE / sizeof(unsigned), sizeof(unsigned));
+	emu->pending = (unsigned *)malloc(emu->config.fifo_depth * sizeof(unsigned));
+	emu->begin_ns = (unsigned long long *)malloc(emu->config.fifo_depth * sizeof(unsigned long long));
+	if(emu->data == NULL || emu->ctrl == NULL || emu->pending == NULL || emu->begin_ns == NULL){
+		printf("[ERROR] MME1536: EmuInitialize() -> could not allocate memory for the model\n");
+		MME1536_EmuFree(emu);
+		return -1;
+	}
+	memset(emu->data, 0, PAGE_SIZE * 6);
+
+	emu->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(emu->fd < 0){
+		perror("[ERROR] MME1536: EmuInitialize() -> could not create the interrupt timer");
+		MME1536_EmuFree(emu);
+		return -1;
+	}
+
+	if(MME1536_InitializeBackend(device_instance, &emu_backend, emu, emu->data, emu->ctrl, emu->fd) != 0){
+		MME1536_EmuFree(emu);
+		return -1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** Start bit: start a single multiplication or an auto-run. An operation
+ * that is still busy is finished first.
+ */
+void MME1536_EmuStart(MME1536 * device_instance, unsigned control){
+	MME1536_Emu * emu = (MME1536_Emu *)device_instance->backend_data;
+	unsigned r[WORDS_TOT];
+	int k;
+
+	if(emu->busy) MME1536_EmuFinish(emu);
+
+	// the start bit reads back cleared
+	emu->ctrl[0] = control & 0xff7fffff;
+
+	emu->part = (control >> P_SEL_BITS) & 0x3;
+	switch(emu->part){
+		case LOW_PART:{
+			emu->words = WORDS_LOW;
+			emu->offset = 0;
+		} break;
+		case HIGH_PART:{
+			emu->words = WORDS_HIGH;
+			emu->offset = WORDS_LOW;
+		} break;
+		default:{
+			emu->part = TOT_PIPELINE;
+			emu->words = WORDS_TOT;
+			emu->offset = 0;
+		} break;
+	}
+	if(emu->config.compute){
+		unsigned m0 = MME1536_EmuOperand(emu, MODULUS)[0];
+		unsigned inv = m0;
+		for(k=0; k<5; k++){
+			inv *= 2 - m0 * inv;
+		}
+		emu->minv = -inv;
+	}
+
+	emu->busy = 1;
+	emu->ops++;
+	emu->run_ns = MME1536_EmuNow() + MME1536_EmuCycles(emu, emu->config.start_cycles);
+	if(control & 0x00400000){
+		emu->type = CMD_AUTO;
+		memcpy(emu->acc, MME1536_EmuOperand(emu, OPERAND_3), emu->words * sizeof(unsigned));
+		emu->begin_head = 0;
+		emu->begin_count = 0;
+		for(k=0; k<emu->pending_count; k++){
+			MME1536_EmuEntry(emu, emu->pending[k]);
+		}
+		emu->pending_count = 0;
+	}
+	else{
+		emu->type = CMD_SINGLE;
+		emu->run_ns += MME1536_EmuCycles(emu, emu->config.mult_cycles[emu->part - 1]);
+		if(emu->config.compute){
+			MME1536_EmuMont(emu, r, MME1536_EmuOperand(emu, (control >> X_OP_BITS) & 0x3),
+			                MME1536_EmuOperand(emu, (control >> Y_OP_BITS) & 0x3));
+			memcpy(MME1536_EmuOperand(emu, (control >> DEST_BITS) & 0x3), r, emu->words * sizeof(unsigned));
+		}
+	}
+	MME1536_EmuArm(emu);
+}
+
+/** Exponent fifo write: the running auto-run takes the entry if it has not
+ * run out of entries yet, else it waits in the fifo for the next one. The
+ * IPISR fifo flag tells whether the entry was dropped.
+ */
+void MME1536_EmuFifoPush(MME1536 * device_instance, unsigned entry){
+	MME1536_Emu * emu = (MME1536_Emu *)device_instance->backend_data;
+	volatile unsigned * isr = emu->ctrl + MME1536_INTR_IPISR_OFFSET / sizeof(unsigned);
+	unsigned long long now = MME1536_EmuNow();
+	int dropped = 0;
+
+	if(emu->busy && (emu->type == CMD_AUTO) && (now <= emu->run_ns)){
+		// entries the core has already read left the fifo
+		while((emu->begin_count > 0) && (emu->begin_ns[emu->begin_head] <= now)){
+			emu->begin_head = (emu->begin_head + 1) % emu->config.fifo_depth;
+			emu->begin_count--;
+		}
+		if(emu->begin_count >= emu->config.fifo_depth){
+			dropped = 1;
+		}
+		else{
+			MME1536_EmuEntry(emu, entry);
+			MME1536_EmuArm(emu);
+		}
+	}
+	else if(emu->pending_count >= emu->config.fifo_depth){
+		dropped = 1;
+	}
+	else{
+		emu->pending[emu->pending_count++] = entry;
+	}
+
+	if(dropped){
+		emu->dropped++;
+		*isr |= IPISR_FIFO_NOPUSH;
+	}
+	else{
+		*isr &= ~IPISR_FIFO_NOPUSH;
+	}
+}
+
+/** Interrupt counter: the operation in progress ends once its interrupt
+ * is due.
+ */
+int MME1536_EmuReadInterrupts(MME1536 * device_instance){
+	MME1536_Emu * emu = (MME1536_Emu *)device_instance->backend_data;
+
+	if(emu->busy && (MME1536_EmuNow() >= emu->irq_ns)){
+		MME1536_EmuFinish(emu);
+	}
+
+	return emu->ints;
+}
+
+/** Soft reset: the operation in progress ends without an interrupt and the
+ * fifo is emptied.
+ */
+void MME1536_EmuReset(MME1536 * device_instance){
+	MME1536_Emu * emu = (MME1536_Emu *)device_instance->backend_data;
+	struct itimerspec timer;
+
+	emu->busy = 0;
+	emu->pending_count = 0;
+	emu->begin_count = 0;
+	emu->ctrl[MME1536_INTR_IPISR_OFFSET / sizeof(unsigned)] = 0;
+	memset(&timer, 0, sizeof(timer));
+	timerfd_settime(emu->fd, 0, &timer, NULL);
+}
+
+/** Free the model resources (see MME1536_Clean()).
+ */
+void MME1536_EmuClean(MME1536 * device_instance){
+	MME1536_EmuFree((MME1536_Emu *)device_instance->backend_data);
+}
+
+void MME1536_EmuFree(MME1536_Emu * emu){
+	free(emu->data);
+	free(emu->ctrl);
+	free(emu->pending);
+	free(emu->begin_ns);
+	emu->data = NULL;
+	emu->ctrl = NULL;
+	emu->pending = NULL;
+	emu->begin_ns = NULL;
+	if(emu->fd >= 0) close(emu->fd);
+	emu->fd = -1;
+}
+
+unsigned long long MME1536_EmuNow(void){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/** Duration of a nr. of clock cycles (ns).
+ */
+unsigned long long MME1536_EmuCycles(MME1536_Emu * emu, unsigned long long cycles){
+	return (unsigned long long)(cycles * 1000.0 / emu->config.clock_mhz);
+}
+
+/** Set the interrupt timer to irq_ns after the last multiplication.
+ */
+void MME1536_EmuArm(MME1536_Emu * emu){
+	struct itimerspec timer;
+
+	emu->irq_ns = emu->run_ns + emu->config.irq_ns;
+	memset(&timer, 0, sizeof(timer));
+	timer.it_value.tv_sec = emu->irq_ns / 1000000000ULL;
+	timer.it_value.tv_nsec = emu->irq_ns % 1000000000ULL;
+	timerfd_settime(emu->fd, TFD_TIMER_ABSTIME, &timer, NULL);
+}
+
+/** End the operation in progress: write the auto-run result to OP3 and
+ * raise the interrupt. Disarming the timer also clears its expirations.
+ */
+void MME1536_EmuFinish(MME1536_Emu * emu){
+	struct itimerspec timer;
+
+	if((emu->type == CMD_AUTO) && emu->config.compute){
+		memcpy(MME1536_EmuOperand(emu, OPERAND_3), emu->acc, emu->words * sizeof(unsigned));
+	}
+	emu->busy = 0;
+	emu->ints++;
+	memset(&timer, 0, sizeof(timer));
+	timerfd_settime(emu->fd, 0, &timer, NULL);
+}
+
+/** Append one fifo entry to the running auto-run: per bit pair (e1, e0),
+ * most significant first, square the accumulator and multiply it by OP0
+ * (0, 1), OP1 (1, 0) or OP2 (1, 1).
+ */
+void MME1536_EmuEntry(MME1536_Emu * emu, unsigned entry){
+	unsigned bits = (entry | (entry >> 16)) & 0xffff;
+	int mults = 16 + __builtin_popcount(bits);
+	int bit, b0, b1;
+
+	emu->begin_ns[(emu->begin_head + emu->begin_count) % emu->config.fifo_depth] = emu->run_ns;
+	emu->begin_count++;
+	emu->run_ns += MME1536_EmuCycles(emu, (unsigned long long)mults * emu->config.mult_cycles[emu->part - 1]);
+	emu->entries++;
+
+	if(!emu->config.compute) return;
+	for(bit=15; bit>=0; bit--){
+		MME1536_EmuMont(emu, emu->acc, emu->acc, emu->acc);
+		b0 = (entry >> bit) & 1;
+		b1 = (entry >> (16 + bit)) & 1;
+		if(b0 | b1){
+			MME1536_EmuMont(emu, emu->acc, emu->acc, MME1536_EmuOperand(emu, b1 ? (b0 ? OPERAND_2 : OPERAND_1) : OPERAND_0));
+		}
+	}
+}
+
+/** Montgomery multiplication r = x.y.2^-n mod m on the part in use (CIOS,
+ * 32-bit words), fully reduced. r may be x or y.
+ */
+void MME1536_EmuMont(MME1536_Emu * emu, unsigned * r, unsigned * x, unsigned * y){
+	unsigned * m = MME1536_EmuOperand(emu, MODULUS);
+	unsigned t[WORDS_TOT + 2];
+	unsigned long long s, c;
+	unsigned q;
+	int w = emu->words;
+	int i, j;
+
+	memset(t, 0, sizeof(t));
+	for(i=0; i<w; i++){
+		c = 0;
+		for(j=0; j<w; j++){
+			s = (unsigned long long)t[j] + (unsigned long long)x[j] * y[i] + c;
+			t[j] = (unsigned)s;
+			c = s >> 32;
+		}
+		s = (unsigned long long)t[w] + c;
+		t[w] = (unsigned)s;
+		t[w + 1] = (unsigned)(s >> 32);
+
+		q = t[0] * emu->minv;
+		s = (unsigned long long)t[0] + (unsigned long long)q * m[0];
+		c = s >> 32;
+		for(j=1; j<w; j++){
+			s = (unsigned long long)t[j] + (unsigned long long)q * m[j] + c;
+			t[j - 1] = (unsigned)s;
+			c = s >> 32;
+		}
+		s = (unsigned long long)t[w] + c;
+		t[w - 1] = (unsigned)s;
+		t[w] = t[w + 1] + (unsigned)(s >> 32);
+	}
+
+	// t < 2m: subtract m once if t >= m
+	if(t[w] == 0){
+		for(j=w-1; (j>=0) && (t[j] == m[j]); j--);
+		if((j >= 0) && (t[j] < m[j])){
+			memcpy(r, t, w * sizeof(unsigned));
+			return;
+		}
+	}
+	c = 0;
+	for(j=0; j<w; j++){
+		s = (unsigned long long)t[j] - m[j] - c;
+		r[j] = (unsigned)s;
+		c = (s >> 63);
+	}
+}
+
+/** Words of an operand in the part in use.
+ */
+unsigned * MME1536_EmuOperand(MME1536_Emu * emu, int operand){
+	return emu->data + (emu_offsets[operand] / sizeof(unsigned)) + emu->offset;
+}
@@ -0,0 +1,77 @@
+/** @file libmme1536_emu.h Header file for libmme1536_emu.c
+ * Contains the definitions and function prototypes for running the driver
+ * on a software model of the mod_sim_exp core instead of the hardware.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_EMU_H_
+#define _LIBMME1536_EMU_H_
+
+#include "libmme1536_v1.h"
+
+// default clock of the modelled core (MHz)
+#define EMU_CLOCK_MHZ	100.0
+
+// default nr. of clock cycles of one montgomery multiplication, per part
+// of the pipeline (LOW_PART, HIGH_PART, TOT_PIPELINE)
+#define EMU_MULT_CYCLES_LOW	570
+#define EMU_MULT_CYCLES_HIGH	1090
+#define EMU_MULT_CYCLES_TOT	1610
+
+// default nr. of clock cycles from the start bit to the first multiplication
+#define EMU_START_CYCLES	20
+
+// default delay from the end of an operation to the interrupt (ns)
+#define EMU_IRQ_NS	2000
+
+/// timing and behaviour of the modelled core
+typedef struct mme1536_emu_config_st{
+	double clock_mhz;
+	int mult_cycles[3]; // indexed by p_sel - 1
+	int start_cycles;
+	int irq_ns;
+	int fifo_depth; // nr. of exponent fifo entries
+	int compute; // 0: timing only, the operand memories are not updated
+} MME1536_EmuConfig;
+
+/// state of the modelled core (see MME1536_EmuInitialize())
+typedef struct mme1536_emu_st{
+	MME1536_EmuConfig config;
+
+	/* memories seen by the driver: operand RAMs and fifo, registers */
+	unsigned * data;
+	unsigned * ctrl;
+	// timerfd, readable when an interrupt is pending
+	int fd;
+	int ints;
+
+	/* operation in progress */
+	int busy;
+	int type; // CMD_SINGLE or CMD_AUTO
+	int part, words, offset; // part of the pipeline in use
+	unsigned long long run_ns; // end of the multiplications so far
+	unsigned long long irq_ns; // time of the interrupt
+	unsigned minv; // -m^-1 mod 2^32
+	unsigned acc[WORDS_TOT]; // auto-run accumulator
+
+	/* exponent fifo: entries written before the auto-run starts, and
+	 * the start times of the entries the running auto-run still has to
+	 * read */
+	unsigned * pending;
+	int pending_count;
+	unsigned long long * begin_ns;
+	int begin_head, begin_count;
+
+	/* counters */
+	unsigned long long ops, entries, dropped;
+} MME1536_Emu;
+
+/** Function prototypes
+ */
+
+void MME1536_EmuDefaults(MME1536_EmuConfig * config);
+int MME1536_EmuInitialize(MME1536 * device_instance, MME1536_Emu * emu, const MME1536_EmuConfig * config);
+
+#endif /*_LIBMME1536_EMU_H_*/
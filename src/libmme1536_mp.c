@@ -0,0 +1,479 @@
+/** @file libmme1536_mp.c This file contains the source code for modular
+ * exponentiation with moduli that are longer than the core.
+ *
+ * Moduli up to BITS_TOT bits go to the core directly. Longer (odd) moduli
+ * use montgomery multiplication on the host, of which the multi-precision
+ * products are built from limb products on the core: with the product
+ * modulus P = 2^n - 1 the montgomery factor R = 2^n is 1 mod P, so one
+ * single multiplication of two n/2-bit limbs gives their exact product.
+ * The exponentiation itself is a fixed-window method on the host.
+ *
+ * Whether this hybrid path beats mpz_powm() depends on the bus and the
+ * cpu, so both are timed for each modulus size the first time it is used
+ * and the faster one is kept.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libmme1536_mp.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+int MME1536_MpPowmNative(MME1536_Mp * mp, mpz_t result, mpz_t g, mpz_t e, mpz_t m);
+int MME1536_MpPowmHybrid(MME1536_Mp * mp, mpz_t result, mpz_t g, mpz_t e, mpz_t m);
+int MME1536_MpMontInit(MME1536_Mp * mp, MME1536_MpMont * mont, mpz_t m);
+void MME1536_MpMontClear(MME1536_MpMont * mont);
+int MME1536_MpMontMul(MME1536_Mp * mp, MME1536_MpMont * mont, mpz_t r, mpz_t a, mpz_t b);
+int MME1536_MpHwMul(MME1536_Mp * mp, mpz_t r, mpz_t a, mpz_t b, int low);
+int MME1536_MpSplit(MME1536_Mp * mp, int limbs[][WORDS_TOT], int * zero, mpz_t x);
+int MME1536_MpLimbs(MME1536_Mp * mp, mpz_t m);
+int MME1536_MpWindow(int t);
+void MME1536_MpCalibrate(MME1536_Mp * mp, mpz_t m, int k);
+double MME1536_MpElapsedUs(struct timespec * start);
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Set up the multi-precision layer of a core.
+ *
+ * @param mp is a pointer to the state to initialise
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param hw_bits is the operand length used for the limb products on the
+ *        core (BITS_HIGH or BITS_TOT)
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_MpInit(MME1536_Mp * mp, MME1536 * device_instance, int hw_bits){
+	if((hw_bits != BITS_HIGH) && (hw_bits != BITS_TOT)){
+		printf("[ERROR] MME1536: MpInit() -> wrong limb product length: %d\n", hw_bits);
+		return -1;
+	}
+
+	memset(mp, 0, sizeof(MME1536_Mp));
+	mp->dev = device_instance;
+	mp->hw_bits = hw_bits;
+	mp->limb_bits = hw_bits / 2;
+	mp->mode = MP_AUTO;
+	memset(mp->P, 0xff, (hw_bits / 32) * sizeof(int));
+
+	return 0;
+}
+
+/** Select the path for moduli longer than the core.
+ *
+ * @param mp is a pointer to the state of the core
+ * @param mode is MP_AUTO (cost model), MP_HYBRID or MP_GMP
+ *
+ * @return 0 upon success
+ *         -1 for a wrong mode
+ */
+int MME1536_MpSetMode(MME1536_Mp * mp, int mode){
+	if((mode != MP_AUTO) && (mode != MP_HYBRID) && (mode != MP_GMP)){
+		printf("[ERROR] MME1536: MpSetMode() -> wrong mode: %d\n", mode);
+		return -1;
+	}
+	mp->mode = mode;
+
+	return 0;
+}
+
+/** Get the path MME1536_MpPowm() takes for a modulus. The first call for
+ * a modulus size times both paths, which uses the core.
+ *
+ * @param mp is a pointer to the state of the core
+ * @param m is the modulus
+ *
+ * @return MP_HYBRID when the core is used (directly or for limb products)
+ *         MP_GMP when mpz_powm() is used
+ */
+int MME1536_MpChoose(MME1536_Mp * mp, mpz_t m){
+	int k;
+
+	// montgomery needs an odd modulus
+	if(mpz_even_p(m)) return MP_GMP;
+	if(mpz_sizeinbase(m, 2) <= BITS_TOT) return MP_HYBRID;
+
+	k = MME1536_MpLimbs(mp, m);
+	if(k > MP_MAX_LIMBS) return MP_GMP;
+	if(mp->mode != MP_AUTO) return mp->mode;
+
+	if(mp->hybrid_us[k] == 0) MME1536_MpCalibrate(mp, m, k);
+
+	return (mp->hybrid_us[k] < mp->gmp_us[k]) ? MP_HYBRID : MP_GMP;
+}
+
+/** Compute g^e mod m for a modulus of any length.
+ *
+ * @param mp is a pointer to the state of the core
+ * @param result is set to g^e mod m
+ * @param g is the base
+ * @param e is the exponent (e >= 0)
+ * @param m is the modulus (m > 0)
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ *
+ * @warning the hybrid path replaces the modulus set by
+ *          MME1536_UpdateModulus(), call it again before using the _m
+ *          functions
+ */
+int MME1536_MpPowm(MME1536_Mp * mp, mpz_t result, mpz_t g, mpz_t e, mpz_t m){
+	if((mpz_sgn(m) <= 0) || (mpz_sgn(e) < 0)){
+		printf("[ERROR] MME1536: MpPowm() -> modulus and exponent must be positive\n");
+		return -1;
+	}
+	if(mpz_sgn(e) == 0){
+		mpz_set_ui(result, 1);
+		mpz_mod(result, result, m);
+		return 0;
+	}
+
+	if(MME1536_MpChoose(mp, m) == MP_GMP){
+		mpz_powm(result, g, e, m);
+		return 0;
+	}
+	if(mpz_sizeinbase(m, 2) <= BITS_TOT){
+		return MME1536_MpPowmNative(mp, result, g, e, m);
+	}
+
+	return MME1536_MpPowmHybrid(mp, result, g, e, m);
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** g^e mod m on the core, for (odd) moduli up to BITS_TOT bits.
+ */
+int MME1536_MpPowmNative(MME1536_Mp * mp, mpz_t result, mpz_t g, mpz_t e, mpz_t m){
+	int g_bin[WORDS_TOT], m_bin[WORDS_TOT], r_bin[WORDS_TOT];
+	int bits = mpz_sizeinbase(m, 2);
+	int t = (mpz_sizeinbase(e, 2) + 31) / 32 * 32;
+	MME1536_JobBuf * buf = NULL;
+	int * e_bin;
+	int ret;
+	int n;
+	mpz_t x;
+
+	if(bits <= BITS_LOW) n = BITS_LOW;
+	else if(bits <= BITS_HIGH) n = BITS_HIGH;
+	else n = BITS_TOT;
+
+	// the exponent goes into a job buffer of the core when it fits
+	if(t <= mp->dev->arena.t) buf = MME1536_ArenaBorrow(mp->dev);
+	if(buf != NULL){
+		e_bin = buf->e0;
+		memset(e_bin, 0, (t / 32) * sizeof(int));
+	}
+	else{
+		e_bin = (int *)calloc(t / 32, sizeof(int));
+		if(e_bin == NULL){
+			printf("[ERROR] MME1536: MpPowmNative() -> out of memory\n");
+			return -1;
+		}
+	}
+	mpz_export((void *)e_bin, NULL, -1, sizeof(int), 0, 0, e);
+
+	mpz_init(x);
+	mpz_mod(x, g, m);
+	memset(g_bin, 0, sizeof(g_bin));
+	mpz_export((void *)g_bin, NULL, -1, sizeof(int), 0, 0, x);
+	memset(m_bin, 0, sizeof(m_bin));
+	mpz_export((void *)m_bin, NULL, -1, sizeof(int), 0, 0, m);
+	mpz_clear(x);
+
+	ret = MME1536_MME(mp->dev, r_bin, g_bin, g_bin, m_bin, e_bin, NULL, n, t);
+	if(buf != NULL) MME1536_ArenaReturn(mp->dev, buf);
+	else free(e_bin);
+	if(ret != 0) return -1;
+
+	mpz_import(result, n / 32, -1, sizeof(int), 0, 0, r_bin);
+	mpz_mod(result, result, m);
+
+	return 0;
+}
+
+/** g^e mod m with host montgomery multiplications on hardware limb
+ * products (fixed window).
+ */
+int MME1536_MpPowmHybrid(MME1536_Mp * mp, mpz_t result, mpz_t g, mpz_t e, mpz_t m){
+	mpz_t table[1 << MP_MAX_WINDOW];
+	MME1536_MpMont mont;
+	mpz_t acc;
+	int t = mpz_sizeinbase(e, 2);
+	int w = MME1536_MpWindow(t);
+	int pos, digit, first = 1;
+	int ret = 0;
+	int i, s;
+
+	if(MME1536_MpMontInit(mp, &mont, m) != 0) return -1;
+
+	// table[i] = g^i.R mod m
+	for(i=0; i<(1 << w); i++) mpz_init(table[i]);
+	mpz_set_ui(table[0], 1);
+	mpz_mul_2exp(table[0], table[0], mont.bits);
+	mpz_mod(table[0], table[0], m);
+	mpz_mod(table[1], g, m);
+	mpz_mul_2exp(table[1], table[1], mont.bits);
+	mpz_mod(table[1], table[1], m);
+	for(i=2; (i<(1 << w)) && (ret == 0); i++){
+		ret = MME1536_MpMontMul(mp, &mont, table[i], table[i-1], table[1]);
+	}
+
+	// the exponent in windows of w bits, most significant first
+	mpz_init_set(acc, table[0]);
+	for(pos=(t + w - 1) / w * w - w; (pos >= 0) && (ret == 0); pos-=w){
+		digit = 0;
+		for(s=w-1; s>=0; s--){
+			digit = (digit << 1) | mpz_tstbit(e, pos + s);
+		}
+		if(first){
+			mpz_set(acc, table[digit]);
+			first = 0;
+			continue;
+		}
+		for(s=0; (s<w) && (ret == 0); s++){
+			ret = MME1536_MpMontMul(mp, &mont, acc, acc, acc);
+		}
+		if(digit && (ret == 0)){
+			ret = MME1536_MpMontMul(mp, &mont, acc, acc, table[digit]);
+		}
+	}
+
+	// leave the montgomery domain: (acc.1).R^(-1)
+	if(ret == 0){
+		mpz_set_ui(table[0], 1);
+		ret = MME1536_MpMontMul(mp, &mont, result, acc, table[0]);
+	}
+
+	mpz_clear(acc);
+	for(i=0; i<(1 << w); i++) mpz_clear(table[i]);
+	MME1536_MpMontClear(&mont);
+
+	return ret;
+}
+
+/** Set up the host montgomery context of m and the product modulus on the
+ * core.
+ */
+int MME1536_MpMontInit(MME1536_Mp * mp, MME1536_MpMont * mont, mpz_t m){
+	mpz_t R;
+
+	mont->k = MME1536_MpLimbs(mp, m);
+	if(mont->k > MP_MAX_LIMBS){
+		printf("[ERROR] MME1536: MpMontInit() -> modulus of %d bits is too long\n", (int)mpz_sizeinbase(m, 2));
+		return -1;
+	}
+	if(MME1536_UpdateModulus(mp->dev, mp->P, mp->hw_bits) != 0){
+		return -1;
+	}
+	mont->bits = mont->k * mp->limb_bits;
+
+	// Ninv = R - m^(-1) mod R
+	mpz_init_set(mont->N, m);
+	mpz_init_set_ui(mont->Ninv, 1);
+	mpz_mul_2exp(mont->Ninv, mont->Ninv, mont->bits);
+	mpz_init_set(R, mont->Ninv);
+	mpz_invert(mont->Ninv, m, R);
+	mpz_sub(mont->Ninv, R, mont->Ninv);
+	mpz_clear(R);
+
+	return 0;
+}
+
+void MME1536_MpMontClear(MME1536_MpMont * mont){
+	mpz_clear(mont->N);
+	mpz_clear(mont->Ninv);
+}
+
+/** r = a.b.R^(-1) mod N for a, b < N, with all products on the core.
+ * r may be a or b.
+ */
+int MME1536_MpMontMul(MME1536_Mp * mp, MME1536_MpMont * mont, mpz_t r, mpz_t a, mpz_t b){
+	mpz_t T, q;
+	int ret;
+
+	mpz_init(T);
+	mpz_init(q);
+
+	// T = a.b, q = (T mod R).Ninv mod R
+	ret = MME1536_MpHwMul(mp, T, a, b, 0);
+	if(ret == 0){
+		mpz_tdiv_r_2exp(q, T, mont->bits);
+		ret = MME1536_MpHwMul(mp, q, q, mont->Ninv, mont->k);
+		mpz_tdiv_r_2exp(q, q, mont->bits);
+	}
+	// r = (T + q.N)/R
+	if(ret == 0){
+		ret = MME1536_MpHwMul(mp, q, q, mont->N, 0);
+		mpz_add(T, T, q);
+		mpz_tdiv_q_2exp(r, T, mont->bits);
+		if(mpz_cmp(r, mont->N) >= 0) mpz_sub(r, r, mont->N);
+	}
+
+	mpz_clear(T);
+	mpz_clear(q);
+
+	return ret;
+}
+
+/** r = a.b from limb products on the core. With low > 0 only the limb
+ * products below limb position low are summed (r is only valid mod
+ * 2^(low.limb_bits)). Squares (a == b) skip the mirrored products.
+ */
+int MME1536_MpHwMul(MME1536_Mp * mp, mpz_t r, mpz_t a, mpz_t b, int low){
+	int a_bin[MP_MAX_LIMBS][WORDS_TOT], b_bin[MP_MAX_LIMBS][WORDS_TOT];
+	int a_zero[MP_MAX_LIMBS], b_zero[MP_MAX_LIMBS];
+	int prod[MP_BATCH][WORDS_TOT];
+	int shift[MP_BATCH];
+	int square = (a == b);
+	int (* y_bin)[WORDS_TOT] = square ? a_bin : b_bin;
+	int * y_zero = square ? a_zero : b_zero;
+	int ka, kb, i, j, c, operand;
+	MME1536_CmdList list;
+	mpz_t p;
+
+	ka = MME1536_MpSplit(mp, a_bin, a_zero, a);
+	kb = square ? ka : MME1536_MpSplit(mp, b_bin, b_zero, b);
+	if((ka < 0) || (kb < 0)) return -1;
+	if((low > 0) && (kb > low)) kb = low;
+
+	mpz_init(p);
+	mpz_set_ui(r, 0);
+	for(i=0; i<ka; i++){
+		if(a_zero[i]) continue;
+		j = square ? i : 0;
+		while((j < kb) && ((low == 0) || (i + j < low))){
+			// x limb stays in OP0, y limbs alternate between OP1 and OP2 so
+			// the next upload overlaps the multiplication
+			MME1536_CmdInit(&list);
+			MME1536_CmdLoad(&list, a_bin[i], OPERAND_0, mp->hw_bits);
+			for(c=0; (c < MP_BATCH) && (j < kb) && ((low == 0) || (i + j < low)); j++){
+				if(y_zero[j]) continue;
+				operand = (c & 1) ? OPERAND_2 : OPERAND_1;
+				MME1536_CmdLoad(&list, y_bin[j], operand, mp->hw_bits);
+				MME1536_CmdSingle(&list, mp->dev->part, OPERAND_3, OPERAND_0, operand);
+				MME1536_CmdRead(&list, prod[c], OPERAND_3, mp->hw_bits);
+				shift[c] = mp->limb_bits * (i + j) + ((square && (j != i)) ? 1 : 0);
+				c++;
+			}
+			if(c == 0) continue;
+			if(MME1536_CmdSubmit(mp->dev, &list) != 0){
+				mpz_clear(p);
+				return -1;
+			}
+			while(c-- > 0){
+				mpz_import(p, mp->hw_bits / 32, -1, sizeof(int), 0, 0, prod[c]);
+				mpz_mul_2exp(p, p, shift[c]);
+				mpz_add(r, r, p);
+			}
+		}
+	}
+	mpz_clear(p);
+
+	return 0;
+}
+
+/** Split x into limbs of limb_bits, each in an operand of hw_bits.
+ *
+ * @return the nr. of limbs
+ *         -1 when x is too long
+ */
+int MME1536_MpSplit(MME1536_Mp * mp, int limbs[][WORDS_TOT], int * zero, mpz_t x){
+	int words[MP_MAX_LIMBS * WORDS_TOT / 2];
+	int limb_words = mp->limb_bits / 32;
+	size_t count;
+	int k, i, j;
+
+	if(mpz_sizeinbase(x, 2) > (size_t)(MP_MAX_LIMBS * mp->limb_bits)){
+		printf("[ERROR] MME1536: MpSplit() -> operand is too long\n");
+		return -1;
+	}
+	mpz_export((void *)words, &count, -1, sizeof(int), 0, 0, x);
+
+	k = (count + limb_words - 1) / limb_words;
+	for(i=0; i<k; i++){
+		memset(limbs[i], 0, WORDS_TOT * sizeof(int));
+		zero[i] = 1;
+		for(j=0; (j < limb_words) && (i * limb_words + j < (int)count); j++){
+			limbs[i][j] = words[i * limb_words + j];
+			if(limbs[i][j] != 0) zero[i] = 0;
+		}
+	}
+
+	return k;
+}
+
+/** Nr. of limbs of a modulus.
+ */
+int MME1536_MpLimbs(MME1536_Mp * mp, mpz_t m){
+	return (mpz_sizeinbase(m, 2) + mp->limb_bits - 1) / mp->limb_bits;
+}
+
+/** Window size for an exponent of t bits.
+ */
+int MME1536_MpWindow(int t){
+	if(t <= 256) return 3;
+	if(t <= 1024) return 4;
+	if(t <= 4096) return 5;
+	return MP_MAX_WINDOW;
+}
+
+/** Time one modular multiplication of k limbs on both paths. GMP is timed
+ * over more repetitions as it is much shorter than the timer resolution
+ * would like.
+ */
+void MME1536_MpCalibrate(MME1536_Mp * mp, mpz_t m, int k){
+	MME1536_MpMont mont;
+	struct timespec start;
+	mpz_t a, b, r;
+	int i, ret = 0;
+
+	mpz_init(a);
+	mpz_init(b);
+	mpz_init(r);
+	mpz_sub_ui(a, m, 1);
+	mpz_sub_ui(b, m, 2);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i=0; i<MP_CALIBRATE_REPS * 16; i++){
+		mpz_mul(r, a, b);
+		mpz_mod(r, r, m);
+	}
+	mp->gmp_us[k] = MME1536_MpElapsedUs(&start) / (MP_CALIBRATE_REPS * 16);
+
+	if(MME1536_MpMontInit(mp, &mont, m) == 0){
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i=0; (i<MP_CALIBRATE_REPS) && (ret == 0); i++){
+			ret = MME1536_MpMontMul(mp, &mont, r, a, b);
+		}
+		mp->hybrid_us[k] = MME1536_MpElapsedUs(&start) / MP_CALIBRATE_REPS;
+		MME1536_MpMontClear(&mont);
+	}
+	else ret = -1;
+
+	// never pick a path that doesn't work
+	if(ret != 0) mp->hybrid_us[k] = 1e12;
+
+	mpz_clear(a);
+	mpz_clear(b);
+	mpz_clear(r);
+}
+
+double MME1536_MpElapsedUs(struct timespec * start){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1e6 + (now.tv_nsec - start->tv_nsec) / 1e3;
+}
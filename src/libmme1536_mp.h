@@ -0,0 +1,66 @@
+/** @file libmme1536_mp.h Header file for libmme1536_mp.c
+ * Contains the definitions and function prototypes for modular
+ * exponentiation with moduli longer than the core (e.g. 3072 or 4096 bits).
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_MP_H_
+#define _LIBMME1536_MP_H_
+
+#include "gmp.h"
+
+#include "libmme1536_v1.h"
+
+// maximum nr. of limbs (hardware half words) in a modulus
+#define MP_MAX_LIMBS	16
+
+// limb products per command list (1 + 3 steps each, see CMD_LIST_MAX)
+#define MP_BATCH	5
+
+// nr. of montgomery multiplications timed per size by the cost model
+#define MP_CALIBRATE_REPS	4
+
+// largest exponentiation window (the table has 2^MP_MAX_WINDOW entries)
+#define MP_MAX_WINDOW	6
+
+// exponentiation paths (see MME1536_MpSetMode())
+#define MP_AUTO	0 // cost model decides per modulus size
+#define MP_HYBRID	1 // host montgomery on hardware limb products
+#define MP_GMP	2 // mpz_powm()
+
+/// state of the multi-precision layer of one core
+typedef struct mme1536_mp_st{
+	MME1536 * dev;
+	int hw_bits; // operand length used on the core (BITS_HIGH or BITS_TOT)
+	int limb_bits; // hw_bits/2
+	int mode;
+
+	/* product modulus 2^hw_bits - 1 (R = 1 mod P, so a single
+	 * montgomery multiplication gives the plain product of two limbs) */
+	int P[WORDS_TOT];
+
+	/* cost model, per nr. of limbs of the modulus: measured time of one
+	 * modular multiplication (us, 0 when not measured yet) */
+	double hybrid_us[MP_MAX_LIMBS + 1];
+	double gmp_us[MP_MAX_LIMBS + 1];
+} MME1536_Mp;
+
+/// host montgomery context of a long modulus (see MME1536_MpMontMul())
+typedef struct mme1536_mp_mont_st{
+	int k; // nr. of limbs
+	int bits; // k * limb_bits, R = 2^bits
+	mpz_t N;
+	mpz_t Ninv; // -N^(-1) mod R
+} MME1536_MpMont;
+
+/** Function prototypes
+ */
+
+int MME1536_MpInit(MME1536_Mp * mp, MME1536 * device_instance, int hw_bits);
+int MME1536_MpSetMode(MME1536_Mp * mp, int mode);
+int MME1536_MpChoose(MME1536_Mp * mp, mpz_t m);
+int MME1536_MpPowm(MME1536_Mp * mp, mpz_t result, mpz_t g, mpz_t e, mpz_t m);
+
+#endif /*_LIBMME1536_MP_H_*/
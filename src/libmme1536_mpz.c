@@ -0,0 +1,211 @@
+/** @file libmme1536_mpz.c This file contains the source code for calling
+ * the core directly on GMP integers.
+ *
+ * The operands are passed to the driver as pointers into the limbs of the
+ * integers (see MPZ_ZERO_COPY): the integers are zero padded in place up
+ * to the operand length, which leaves their values unchanged, and the
+ * result is written straight into the limbs of the result. When the limb
+ * layout does not match the words of the core, the words are converted to
+ * and from buffers on the stack. No heap buffers are used in either case.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libmme1536_mpz.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+int MME1536_MpzLength(mpz_t m);
+int MME1536_MpzExpLength(mpz_t e);
+int MME1536_MpzCheck(mpz_t x, mpz_t m, int n);
+int * MME1536_MpzWords(mpz_t x);
+void MME1536_MpzPad(mpz_t x, int words);
+void MME1536_MpzExport(int * bin, mpz_t x, int words);
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Compute g0^e0 * g1^e1 mod m on GMP integers.
+ *
+ * The operand length (512, 1024 or 1536 bits) follows from the length of
+ * m, the exponent length from the longest exponent. The inputs keep their
+ * values but may have their limbs reallocated (see MME1536_MpzPad()).
+ *
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is set to g0^e0 * g1^e1 mod m (may be one of the inputs)
+ * @param g0, g1 are the bases (0 <= g < m)
+ * @param m is the modulus (odd, at most BITS_TOT bits)
+ * @param e0, e1 are the exponents (e1 may be NULL to compute g0^e0 mod m)
+ *
+ * @return 0 upon success
+ *         -1 upon failure (result is undefined when the core timed out)
+ */
+int MME1536_MME_mpz(MME1536 * device_instance, mpz_t result, mpz_t g0, mpz_t g1, mpz_t m, mpz_t e0, mpz_t e1){
+	int n, t, words, ewords, ret;
+	int * g0_w, * g1_w, * m_w, * e0_w, * e1_w, * r_w;
+	int r_buf[WORDS_TOT];
+
+	n = MME1536_MpzLength(m);
+	if(n == 0){
+		printf("[ERROR] MME1536: MME_mpz() -> modulus of %d bits is too long\n", (int)mpz_sizeinbase(m, 2));
+		return -1;
+	}
+	if(mpz_even_p(m)){
+		printf("[ERROR] MME1536: MME_mpz() -> the modulus must be odd\n");
+		return -1;
+	}
+	if(MME1536_MpzCheck(g0, m, n) != 0 || MME1536_MpzCheck(g1, m, n) != 0){
+		printf("[ERROR] MME1536: MME_mpz() -> the bases must be in [0, m)\n");
+		return -1;
+	}
+	if(mpz_sgn(e0) < 0 || (e1 != NULL && mpz_sgn(e1) < 0)){
+		printf("[ERROR] MME1536: MME_mpz() -> negative exponent\n");
+		return -1;
+	}
+
+	t = MME1536_MpzExpLength(e0);
+	if(e1 != NULL && MME1536_MpzExpLength(e1) > t) t = MME1536_MpzExpLength(e1);
+	words = n / 32;
+	ewords = t / 32;
+
+#if MPZ_ZERO_COPY
+	{
+		// the result can only be written in place when no input shares its limbs
+		int aliased = (result == g0 || result == g1 || result == m || result == e0 || result == e1);
+
+		/* pad all inputs before taking any pointer: padding an integer
+		 * that is passed twice may move its limbs */
+		MME1536_MpzPad(g0, words);
+		MME1536_MpzPad(g1, words);
+		MME1536_MpzPad(m, words);
+		MME1536_MpzPad(e0, ewords);
+		if(e1 != NULL) MME1536_MpzPad(e1, ewords);
+
+		g0_w = MME1536_MpzWords(g0);
+		g1_w = MME1536_MpzWords(g1);
+		m_w = MME1536_MpzWords(m);
+		e0_w = MME1536_MpzWords(e0);
+		e1_w = (e1 != NULL) ? MME1536_MpzWords(e1) : NULL;
+		r_w = aliased ? r_buf : (int *)mpz_limbs_write(result, words * 32 / GMP_LIMB_BITS);
+
+		ret = MME1536_MME(device_instance, r_w, g0_w, g1_w, m_w, e0_w, e1_w, n, t);
+	}
+#else
+	{
+		int g0_buf[WORDS_TOT], g1_buf[WORDS_TOT], m_buf[WORDS_TOT];
+		int e0_buf[ewords], e1_buf[ewords];
+
+		MME1536_MpzExport(g0_buf, g0, words);
+		MME1536_MpzExport(g1_buf, g1, words);
+		MME1536_MpzExport(m_buf, m, words);
+		MME1536_MpzExport(e0_buf, e0, ewords);
+		if(e1 != NULL) MME1536_MpzExport(e1_buf, e1, ewords);
+		g0_w = g0_buf;
+		g1_w = g1_buf;
+		m_w = m_buf;
+		e0_w = e0_buf;
+		e1_w = (e1 != NULL) ? e1_buf : NULL;
+		r_w = r_buf;
+
+		ret = MME1536_MME(device_instance, r_w, g0_w, g1_w, m_w, e0_w, e1_w, n, t);
+	}
+#endif
+
+	if(r_w == r_buf){
+		mpz_import(result, words, -1, sizeof(int), 0, 0, r_buf);
+	}
+	else{
+		// strips the leading zero limbs
+		mpz_limbs_finish(result, words * 32 / GMP_LIMB_BITS);
+	}
+
+	return ret;
+}
+
+/** Compute g^e mod m on GMP integers (see MME1536_MME_mpz()).
+ *
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is set to g^e mod m (may be one of the inputs)
+ * @param g is the base (0 <= g < m)
+ * @param e is the exponent
+ * @param m is the modulus (odd, at most BITS_TOT bits)
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_Exp_mpz(MME1536 * device_instance, mpz_t result, mpz_t g, mpz_t e, mpz_t m){
+	return MME1536_MME_mpz(device_instance, result, g, g, m, e, NULL);
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** Operand length for a modulus (#bits, 0 when it is too long).
+ */
+int MME1536_MpzLength(mpz_t m){
+	size_t bits = mpz_sizeinbase(m, 2);
+
+	if(bits <= BITS_LOW) return BITS_LOW;
+	if(bits <= BITS_HIGH) return BITS_HIGH;
+	if(bits <= BITS_TOT) return BITS_TOT;
+	return 0;
+}
+
+/** Length of an exponent as passed to the core (#bits). A multiple of the
+ * limb size, so that the padded limbs cover exactly t/32 words.
+ */
+int MME1536_MpzExpLength(mpz_t e){
+	int step = (GMP_LIMB_BITS > 32) ? GMP_LIMB_BITS : 32;
+	int t = (mpz_sizeinbase(e, 2) + step - 1) / step * step;
+
+	return (t == 0) ? step : t;
+}
+
+/** Check that a base fits the operand: 0 <= x < m.
+ */
+int MME1536_MpzCheck(mpz_t x, mpz_t m, int n){
+	if(mpz_sgn(x) < 0 || mpz_sizeinbase(x, 2) > (size_t)n) return -1;
+	if(mpz_cmp(x, m) >= 0) return -1;
+	return 0;
+}
+
+/** Pointer to the limbs of x as words of the core. x must have been padded
+ * to the operand length with MME1536_MpzPad() first.
+ */
+int * MME1536_MpzWords(mpz_t x){
+	return (int *)mpz_limbs_read(x);
+}
+
+/** Zero the limbs of x above its size, up to the given nr. of words (32
+ * bits each). The value of x does not change, the limbs may be moved when
+ * x has fewer allocated.
+ */
+void MME1536_MpzPad(mpz_t x, int words){
+	mp_size_t limbs = (mp_size_t)words * 32 / GMP_LIMB_BITS;
+	mp_size_t size = mpz_size(x);
+	mp_limb_t * p;
+	mp_size_t i;
+
+	p = mpz_limbs_modify(x, limbs);
+	for(i=size; i<limbs; i++){
+		p[i] = 0;
+	}
+	mpz_limbs_finish(x, size);
+}
+
+/** Write x into a words long word array (least significant word first).
+ */
+void MME1536_MpzExport(int * bin, mpz_t x, int words){
+	memset(bin, 0, words * sizeof(int));
+	mpz_export((void *)bin, NULL, -1, sizeof(int), 0, 0, x);
+}
@@ -0,0 +1,32 @@
+/** @file libmme1536_mpz.h Header file for libmme1536_mpz.c
+ * Contains the function prototypes for calling the core directly on GMP
+ * integers, without converting them to word arrays first.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_MPZ_H_
+#define _LIBMME1536_MPZ_H_
+
+#include "gmp.h"
+
+#include "libmme1536_v1.h"
+
+/* the limbs of an integer can be handed to the core as they are when they
+ * are sequences of 32-bit words, least significant first: 32-bit limbs, or
+ * 64-bit limbs on a little endian host. Otherwise the words are converted
+ * into buffers on the stack. */
+#if GMP_NAIL_BITS == 0 && (GMP_LIMB_BITS == 32 || (GMP_LIMB_BITS == 64 && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#define MPZ_ZERO_COPY	1
+#else
+#define MPZ_ZERO_COPY	0
+#endif
+
+/** Function prototypes
+ */
+
+int MME1536_MME_mpz(MME1536 * device_instance, mpz_t result, mpz_t g0, mpz_t g1, mpz_t m, mpz_t e0, mpz_t e1);
+int MME1536_Exp_mpz(MME1536 * device_instance, mpz_t result, mpz_t g, mpz_t e, mpz_t m);
+
+#endif /*_LIBMME1536_MPZ_H_*/
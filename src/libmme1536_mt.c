@@ -0,0 +1,428 @@
+/** @file libmme1536_mt.c This file contains the source code for sharing
+ * one mod_sim_exp core between threads.
+ *
+ * Producers claim a slot in a bounded multi-producer/single-consumer ring
+ * with a compare-and-swap on the enqueue position and publish their job
+ * descriptor through the slot's sequence number. The owner thread drains
+ * the ring into the asynchronous API of libmme1536_v1.c, handles the
+ * interrupts and marks finished jobs done on their futex. Producers only
+ * make a system call when the owner sleeps (doorbell) or when they have
+ * to wait for their job themselves.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "libmme1536_mt.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+void * MME1536_MtOwner(void * arg);
+int MME1536_MtPost(MME1536_Mt * mt, MME1536_MtJob * job);
+MME1536_MtJob * MME1536_MtTake(MME1536_Mt * mt);
+int MME1536_MtRingEmpty(MME1536_Mt * mt);
+void MME1536_MtExecute(MME1536_Mt * mt, MME1536_MtJob * job);
+void MME1536_MtRetire(MME1536_Mt * mt);
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Start the owner thread of a core. From now on only the owner thread may
+ * use device_instance.
+ *
+ * @param mt is a pointer to the shared core
+ * @param device_instance is a pointer to an initialised MME1536 variable
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_MtStart(MME1536_Mt * mt, MME1536 * device_instance){
+	int i;
+
+	mt->dev = device_instance;
+	for(i=0; i<MT_RING_SIZE; i++){
+		atomic_init(&(mt->ring[i].seq), i);
+		mt->ring[i].job = NULL;
+	}
+	atomic_init(&(mt->enqueue_pos), 0);
+	mt->dequeue_pos = 0;
+	atomic_init(&(mt->sleeping), 0);
+	atomic_init(&(mt->stop), 0);
+	mt->inflight_head = NULL;
+	mt->inflight_tail = NULL;
+
+	mt->doorbell_fd = eventfd(0, EFD_NONBLOCK);
+	if(mt->doorbell_fd < 0){
+		perror("[ERROR] MME1536: MtStart() -> could not create doorbell\n");
+		return -1;
+	}
+	if(pthread_create(&(mt->owner), NULL, MME1536_MtOwner, mt) != 0){
+		printf("[ERROR] MME1536: MtStart() -> could not start owner thread\n");
+		close(mt->doorbell_fd);
+		return -1;
+	}
+
+	return 0;
+}
+
+/** Finish all posted jobs and stop the owner thread.
+ *
+ * @param mt is a pointer to the shared core
+ *
+ * @return nothing
+ */
+void MME1536_MtStop(MME1536_Mt * mt){
+	uint64_t ring = 1;
+
+	atomic_store(&(mt->stop), 1);
+	write(mt->doorbell_fd, &ring, sizeof(ring));
+	pthread_join(mt->owner, NULL);
+	close(mt->doorbell_fd);
+}
+
+/** Post the computation of g0^e0 * g1^e1 mod m (see MME1536_MME()).
+ * Blocks only while the ring is full. All buffers must stay valid until
+ * the job is done.
+ *
+ * @return 0
+ */
+int MME1536_MtSubmitMME(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	job->type = MT_MME;
+	job->on_done = NULL;
+	job->result = result;
+	job->g0 = g0;
+	job->g1 = g1;
+	job->m = m;
+	job->e0 = e0;
+	job->e1 = e1;
+	job->n = n;
+	job->t = t;
+
+	return MME1536_MtPost(mt, job);
+}
+
+/** Post the computation of g0^e0 * g1^e1 mod m with m set (see
+ * MME1536_MME_m()).
+ *
+ * @return 0
+ */
+int MME1536_MtSubmitMME_m(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * g0, int * g1, int * e0, int * e1, int t){
+	job->type = MT_MME_M;
+	job->on_done = NULL;
+	job->result = result;
+	job->g0 = g0;
+	job->g1 = g1;
+	job->e0 = e0;
+	job->e1 = e1;
+	job->t = t;
+
+	return MME1536_MtPost(mt, job);
+}
+
+/** Post a modular exponentiation with m set (see MME1536_Exp_m()).
+ *
+ * @return 0
+ */
+int MME1536_MtSubmitExp_m(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * g, int * e, int t){
+	job->type = MT_EXP_M;
+	job->on_done = NULL;
+	job->result = result;
+	job->g0 = g;
+	job->e0 = e;
+	job->t = t;
+
+	return MME1536_MtPost(mt, job);
+}
+
+/** Post a single multiplication with m set (see MME1536_Multiply_m()).
+ *
+ * @return 0
+ */
+int MME1536_MtSubmitMultiply_m(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * x, int * y){
+	job->type = MT_MULTIPLY_M;
+	job->on_done = NULL;
+	job->result = result;
+	job->g0 = x;
+	job->g1 = y;
+
+	return MME1536_MtPost(mt, job);
+}
+
+/** Post a modulus change (see MME1536_UpdateModulus()). The _m jobs
+ * posted before it use the old modulus, the ones posted after it the new
+ * one.
+ *
+ * @return 0
+ */
+int MME1536_MtSubmitUpdateModulus(MME1536_Mt * mt, MME1536_MtJob * job, int * m, int n){
+	job->type = MT_UPDATE_MODULUS;
+	job->on_done = NULL;
+	job->m = m;
+	job->n = n;
+
+	return MME1536_MtPost(mt, job);
+}
+
+/** Post a job descriptor that the caller filled in: the type, the fields
+ * of the operation and on_done/arg. on_done can be used to see completion
+ * without waiting for the job, e.g. to keep track of the core's load.
+ *
+ * @return 0
+ */
+int MME1536_MtSubmitJob(MME1536_Mt * mt, MME1536_MtJob * job){
+	return MME1536_MtPost(mt, job);
+}
+
+/** Mark a job done and wake the threads waiting for it. Also used for
+ * descriptors that are completed without the core (see
+ * libmme1536_dispatch.c).
+ *
+ * @param job is a pointer to the job
+ *
+ * @return nothing
+ */
+void MME1536_MtFinish(MME1536_MtJob * job){
+	if(job->on_done != NULL) job->on_done(job);
+	if(atomic_exchange_explicit(&(job->done), MT_DONE, memory_order_release) == MT_WAITING){
+		syscall(SYS_futex, &(job->done), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+/** Check whether a posted job is done.
+ *
+ * @return 1 if the job is done
+ *         0 otherwise
+ */
+int MME1536_MtTest(MME1536_MtJob * job){
+	return (atomic_load_explicit(&(job->done), memory_order_acquire) == MT_DONE);
+}
+
+/** Wait until a posted job is done.
+ *
+ * @param job is a pointer to the posted job
+ *
+ * @return 0 upon success
+ *         -1 if the job failed or was aborted (see MME1536_Complete())
+ */
+int MME1536_MtWait(MME1536_MtJob * job){
+	int state = MT_PENDING;
+
+	// announce that we are going to sleep
+	if(!atomic_compare_exchange_strong(&(job->done), &state, MT_WAITING) && (state == MT_DONE)){
+		return job->error;
+	}
+	while(atomic_load_explicit(&(job->done), memory_order_acquire) != MT_DONE){
+		syscall(SYS_futex, &(job->done), FUTEX_WAIT_PRIVATE, MT_WAITING, NULL, NULL, 0);
+	}
+
+	return job->error;
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+void * MME1536_MtOwner(void * arg){
+	MME1536_Mt * mt = (MME1536_Mt *)arg;
+	MME1536 * dev = mt->dev;
+	int timeout_ms = TIMEOUT_S * 1000 + TIMEOUT_US / 1000;
+	struct pollfd fds[2];
+	MME1536_MtJob * job;
+
+	while(1){
+		// drain the ring
+		while((job = MME1536_MtTake(mt)) != NULL){
+			MME1536_MtExecute(mt, job);
+		}
+
+		// handle the interrupt, if any
+		if(mt->inflight_head != NULL){
+			MME1536_Poll(dev);
+			MME1536_MtRetire(mt);
+			if((dev->wait_mode != WAIT_BLOCK) && (mt->inflight_head != NULL)
+			   && MME1536_MtRingEmpty(mt)){
+				// short operations: spin before going to sleep
+				struct timespec start, now;
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				do{
+					if(MME1536_Poll(dev) > 0) MME1536_MtRetire(mt);
+					clock_gettime(CLOCK_MONOTONIC, &now);
+				} while((mt->inflight_head != NULL) && MME1536_MtRingEmpty(mt)
+				        && ((now.tv_sec - start.tv_sec) * 1000000L
+				            + (now.tv_nsec - start.tv_nsec) / 1000L < dev->spin_us));
+			}
+		}
+
+		if((mt->inflight_head == NULL) && MME1536_MtRingEmpty(mt) && atomic_load(&(mt->stop))){
+			break;
+		}
+
+		// sleep until a producer rings or the core raises an interrupt
+		atomic_store(&(mt->sleeping), 1);
+		// the ring check must not pass the store (see MME1536_MtPost())
+		atomic_thread_fence(memory_order_seq_cst);
+		if(!MME1536_MtRingEmpty(mt)){
+			atomic_store(&(mt->sleeping), 0);
+			continue;
+		}
+		fds[0].fd = mt->doorbell_fd;
+		fds[0].events = POLLIN;
+		fds[1].fd = MME1536_GetFd(dev);
+		fds[1].events = POLLIN;
+		int sleep_ms = (mt->inflight_head != NULL) ? timeout_ms : -1;
+		// a streamed exponent needs regular fifo top-ups
+		if((mt->inflight_head != NULL) && (MME1536_PollInterval(dev) >= 0)){
+			sleep_ms = MME1536_PollInterval(dev);
+		}
+		poll(fds, (mt->inflight_head != NULL) ? 2 : 1, sleep_ms);
+		atomic_store(&(mt->sleeping), 0);
+
+		if(fds[0].revents & POLLIN){
+			uint64_t rings;
+			read(mt->doorbell_fd, &rings, sizeof(rings));
+		}
+	}
+
+	return NULL;
+}
+
+/** Put a job descriptor in the ring and ring the doorbell if the owner
+ * sleeps.
+ */
+int MME1536_MtPost(MME1536_Mt * mt, MME1536_MtJob * job){
+	size_t pos = atomic_load_explicit(&(mt->enqueue_pos), memory_order_relaxed);
+	MME1536_MtSlot * slot;
+
+	atomic_store_explicit(&(job->done), MT_PENDING, memory_order_relaxed);
+	job->error = 0;
+
+	// claim a slot
+	while(1){
+		slot = &(mt->ring[pos & (MT_RING_SIZE - 1)]);
+		size_t seq = atomic_load_explicit(&(slot->seq), memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+		if(diff == 0){
+			if(atomic_compare_exchange_weak_explicit(&(mt->enqueue_pos), &pos, pos + 1,
+			                                         memory_order_relaxed, memory_order_relaxed)){
+				break;
+			}
+		}
+		else if(diff < 0){
+			// ring full: the owner is busy, back off
+			sched_yield();
+			pos = atomic_load_explicit(&(mt->enqueue_pos), memory_order_relaxed);
+		}
+		else{
+			pos = atomic_load_explicit(&(mt->enqueue_pos), memory_order_relaxed);
+		}
+	}
+
+	// publish
+	slot->job = job;
+	atomic_store_explicit(&(slot->seq), pos + 1, memory_order_release);
+
+	// the load of sleeping must not pass the publish: either the owner sees
+	// the job before it sleeps or we see it sleeping
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load(&(mt->sleeping))){
+		uint64_t ring = 1;
+		write(mt->doorbell_fd, &ring, sizeof(ring));
+	}
+
+	return 0;
+}
+
+/** Take the oldest job descriptor from the ring (owner thread only).
+ *
+ * @return the job
+ *         NULL if the ring is empty
+ */
+MME1536_MtJob * MME1536_MtTake(MME1536_Mt * mt){
+	MME1536_MtSlot * slot = &(mt->ring[mt->dequeue_pos & (MT_RING_SIZE - 1)]);
+	MME1536_MtJob * job;
+
+	if(atomic_load_explicit(&(slot->seq), memory_order_acquire) != mt->dequeue_pos + 1){
+		return NULL;
+	}
+	job = slot->job;
+	atomic_store_explicit(&(slot->seq), mt->dequeue_pos + MT_RING_SIZE, memory_order_release);
+	mt->dequeue_pos++;
+
+	return job;
+}
+
+int MME1536_MtRingEmpty(MME1536_Mt * mt){
+	MME1536_MtSlot * slot = &(mt->ring[mt->dequeue_pos & (MT_RING_SIZE - 1)]);
+	return (atomic_load_explicit(&(slot->seq), memory_order_acquire) != mt->dequeue_pos + 1);
+}
+
+/** Hand a job to the core (owner thread only).
+ */
+void MME1536_MtExecute(MME1536_Mt * mt, MME1536_MtJob * job){
+	MME1536 * dev = mt->dev;
+	int ret = 0;
+
+	switch(job->type){
+		case MT_MME:{
+			ret = MME1536_SubmitMME(dev, &(job->job), job->result, job->g0, job->g1, job->m, job->e0, job->e1, job->n, job->t);
+		} break;
+		case MT_MME_M:{
+			ret = MME1536_SubmitMME_m(dev, &(job->job), job->result, job->g0, job->g1, job->e0, job->e1, job->t);
+		} break;
+		case MT_EXP_M:{
+			ret = MME1536_SubmitExp_m(dev, &(job->job), job->result, job->g0, job->e0, job->t);
+		} break;
+		case MT_MULTIPLY_M:{
+			ret = MME1536_SubmitMultiply_m(dev, &(job->job), job->result, job->g0, job->g1);
+		} break;
+		case MT_UPDATE_MODULUS:{
+			// waits for the jobs using the old modulus
+			job->error = (MME1536_UpdateModulus(dev, job->m, job->n) == 0) ? 0 : -1;
+			MME1536_MtRetire(mt);
+			MME1536_MtFinish(job);
+		} return;
+		default:{
+			printf("[ERROR] MME1536: MtExecute() -> wrong job type (%d)\n", job->type);
+			job->error = -1;
+			MME1536_MtFinish(job);
+		} return;
+	}
+	if(ret != 0){
+		job->error = -1;
+		MME1536_MtFinish(job);
+		return;
+	}
+
+	job->next = NULL;
+	if(mt->inflight_tail != NULL) mt->inflight_tail->next = job;
+	else mt->inflight_head = job;
+	mt->inflight_tail = job;
+	// the core may have finished it already
+	MME1536_MtRetire(mt);
+}
+
+/** Mark the jobs the core has finished as done (owner thread only).
+ */
+void MME1536_MtRetire(MME1536_Mt * mt){
+	while((mt->inflight_head != NULL) && (mt->inflight_head->job.state == JOB_DONE)){
+		MME1536_MtJob * job = mt->inflight_head;
+		mt->inflight_head = job->next;
+		if(mt->inflight_head == NULL) mt->inflight_tail = NULL;
+		job->error = job->job.error;
+		MME1536_MtFinish(job);
+	}
+}
@@ -0,0 +1,108 @@
+/** @file libmme1536_mt.h Header file for libmme1536_mt.c
+ * Contains the definitions and function prototypes for sharing one core
+ * between threads.
+ *
+ * A MME1536 handle is not thread safe: it keeps the modulus, interrupt
+ * count and job queue of the core. In thread-safe mode a single owner
+ * thread does all accesses to the handle (and so to the core's registers
+ * and memory). Other threads post job descriptors into a lock-free ring
+ * and wait for them on a per-job futex.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_MT_H_
+#define _LIBMME1536_MT_H_
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "libmme1536_v1.h"
+
+// nr. of descriptors in the job ring (power of 2)
+#define MT_RING_SIZE	256
+
+// job types
+#define MT_MME	0 // MME1536_MME()
+#define MT_MME_M	1 // MME1536_MME_m()
+#define MT_EXP_M	2 // MME1536_Exp_m()
+#define MT_MULTIPLY_M	3 // MME1536_Multiply_m()
+#define MT_UPDATE_MODULUS	4 // MME1536_UpdateModulus()
+
+// completion states
+#define MT_PENDING	0
+#define MT_WAITING	1 // a thread sleeps on the futex
+#define MT_DONE	2
+
+/// a job descriptor posted by a producer thread
+typedef struct mme1536_mt_job_st{
+	int type;
+
+	/* operation */
+	int * result;
+	int * g0;
+	int * g1;
+	int * m;
+	int * e0;
+	int * e1;
+	int n, t;
+
+	/* completion futex: MT_PENDING, MT_WAITING or MT_DONE */
+	atomic_int done;
+	/* 0, or -1 when the job failed or was aborted (the core timed out) */
+	int error;
+
+	/* called (by the thread that finishes the job) right before the job is
+	 * marked done, NULL for none (see MME1536_MtSubmitJob()) */
+	void (* on_done)(struct mme1536_mt_job_st * job);
+	void * arg;
+
+	/* owned by the owner thread */
+	MME1536_Job job;
+	struct mme1536_mt_job_st * next;
+} MME1536_MtJob;
+
+/// one entry of the job ring
+typedef struct mme1536_mt_slot_st{
+	atomic_size_t seq;
+	MME1536_MtJob * job;
+} MME1536_MtSlot;
+
+/// a core shared between threads
+typedef struct mme1536_mt_st{
+	MME1536 * dev;
+	pthread_t owner;
+
+	/* multi-producer, single-consumer job ring */
+	MME1536_MtSlot ring[MT_RING_SIZE];
+	atomic_size_t enqueue_pos;
+	size_t dequeue_pos;
+
+	/* doorbell (eventfd) for a sleeping owner */
+	int doorbell_fd;
+	atomic_int sleeping;
+	atomic_int stop;
+
+	/* jobs submitted to the core, oldest first */
+	MME1536_MtJob * inflight_head;
+	MME1536_MtJob * inflight_tail;
+} MME1536_Mt;
+
+/** Function prototypes
+ */
+
+int MME1536_MtStart(MME1536_Mt * mt, MME1536 * device_instance);
+void MME1536_MtStop(MME1536_Mt * mt);
+
+int MME1536_MtSubmitMME(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+int MME1536_MtSubmitMME_m(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * g0, int * g1, int * e0, int * e1, int t);
+int MME1536_MtSubmitExp_m(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * g, int * e, int t);
+int MME1536_MtSubmitMultiply_m(MME1536_Mt * mt, MME1536_MtJob * job, int * result, int * x, int * y);
+int MME1536_MtSubmitUpdateModulus(MME1536_Mt * mt, MME1536_MtJob * job, int * m, int n);
+int MME1536_MtSubmitJob(MME1536_Mt * mt, MME1536_MtJob * job);
+void MME1536_MtFinish(MME1536_MtJob * job);
+int MME1536_MtTest(MME1536_MtJob * job);
+int MME1536_MtWait(MME1536_MtJob * job);
+
+#endif /*_LIBMME1536_MT_H_*/
@@ -0,0 +1,450 @@
+/** @file libmme1536_pool.c This file contains the source code for
+ * distributing jobs over several mod_sim_exp cores.
+ *
+ * Every core has its own queue of waiting jobs and runs one job at a time
+ * through the asynchronous API of libmme1536_v1.c. New jobs go to a core
+ * that will have their modulus loaded (so the modulus upload and R2
+ * computation are skipped), unless that core is clearly busier than the
+ * others. A core that runs out of work steals a waiting job from the core
+ * with the longest queue.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <poll.h>
+
+#include "libmme1536_pool.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+int MME1536_PoolSelect(MME1536_Pool * pool, MME1536_PoolJob * job);
+void MME1536_PoolKick(MME1536_Pool * pool, int index);
+MME1536_PoolJob * MME1536_PoolSteal(MME1536_Pool * pool, int index);
+int MME1536_PoolLoad(MME1536_PoolDevice * device);
+int MME1536_PoolReadSysfs(char * path, char * buffer, int size);
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Initialise a pool from a list of cores.
+ *
+ * @param pool is a pointer to the pool
+ * @param uio_devs is an array of UIO device paths
+ * @param data_bases is an array of physical base addresses of the cores'
+ *        data memories
+ * @param count is the nr. of cores
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_PoolInitialize(MME1536_Pool * pool, char ** uio_devs, unsigned long * data_bases, int count){
+	int i;
+
+	if((count < 1) || (count > POOL_MAX_DEVICES)){
+		printf("[ERROR] MME1536: PoolInitialize() -> wrong nr. of cores (%d)\n", count);
+		return -1;
+	}
+
+	pool->count = 0;
+	for(i=0; i<count; i++){
+		MME1536_PoolDevice * device = &(pool->device[i]);
+		memset(device, 0, sizeof(MME1536_PoolDevice));
+		strncpy(device->uio_dev, uio_devs[i], sizeof(device->uio_dev) - 1);
+
+		if(MME1536_InitializeAt(&(device->dev), device->uio_dev, data_bases[i]) != 0){
+			printf("[ERROR] MME1536: PoolInitialize() -> could not initialise %s\n", device->uio_dev);
+			MME1536_PoolClean(pool);
+			return -1;
+		}
+		pool->count++;
+	}
+
+	return 0;
+}
+
+/** Initialise a pool with all mod_sim_exp cores found in sysfs.
+ *
+ * A core is a UIO device named POOL_UIO_NAME; the UIO map 1 of the device
+ * gives the base address of its data memory.
+ *
+ * @param pool is a pointer to the pool
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_PoolDiscover(MME1536_Pool * pool){
+	// room for the longest entry name: "/sys/class/uio/" name "/maps/map1/addr"
+	char path[NAME_MAX + 32], value[64];
+	char uio_names[POOL_MAX_DEVICES][NAME_MAX + 8];
+	char * uio_devs[POOL_MAX_DEVICES];
+	unsigned long data_bases[POOL_MAX_DEVICES];
+	int count = 0;
+	struct dirent * entry;
+	DIR * dir;
+
+	dir = opendir("/sys/class/uio");
+	if(dir == NULL){
+		perror("[ERROR] MME1536: PoolDiscover() -> could not open /sys/class/uio\n");
+		return -1;
+	}
+	while(((entry = readdir(dir)) != NULL) && (count < POOL_MAX_DEVICES)){
+		if(strncmp(entry->d_name, "uio", 3) != 0) continue;
+
+		snprintf(path, sizeof(path), "/sys/class/uio/%s/name", entry->d_name);
+		if(MME1536_PoolReadSysfs(path, value, sizeof(value)) != 0) continue;
+		if(strcmp(value, POOL_UIO_NAME) != 0) continue;
+
+		snprintf(path, sizeof(path), "/sys/class/uio/%s/maps/map1/addr", entry->d_name);
+		if(MME1536_PoolReadSysfs(path, value, sizeof(value)) != 0){
+			printf("[WARNING] MME1536: PoolDiscover() -> %s has no data memory map, skipped\n", entry->d_name);
+			continue;
+		}
+
+		snprintf(uio_names[count], sizeof(uio_names[count]), "/dev/%s", entry->d_name);
+		uio_devs[count] = uio_names[count];
+		data_bases[count] = strtoul(value, NULL, 0);
+		printf("[INFO] MME1536: PoolDiscover() -> core %s at 0x%08lx\n", uio_devs[count], data_bases[count]);
+		count++;
+	}
+	closedir(dir);
+
+	if(count == 0){
+		printf("[ERROR] MME1536: PoolDiscover() -> no cores found\n");
+		return -1;
+	}
+
+	return MME1536_PoolInitialize(pool, uio_devs, data_bases, count);
+}
+
+/** Release all cores of a pool.
+ *
+ * @param pool is a pointer to the pool
+ *
+ * @return nothing
+ */
+void MME1536_PoolClean(MME1536_Pool * pool){
+	int i;
+
+	for(i=0; i<pool->count; i++){
+		MME1536_Clean(&(pool->device[i].dev));
+	}
+	pool->count = 0;
+}
+
+/** Queue the computation of g0^e0 * g1^e1 mod m on one of the cores
+ * (see MME1536_MME()). All buffers must stay valid until the job is done.
+ *
+ * @param pool is a pointer to the pool
+ * @param job is a pointer to a job variable owned by the caller
+ * @param result is a pointer to the buffer where the result will be stored
+ * @param g0, g1, e0, e1, m are arrays containing the bases and exponents
+ * @param n is the lenght of g0, g1 and m (#bits)
+ * @param t is the length of the exponents (#bits)
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_PoolSubmit(MME1536_Pool * pool, MME1536_PoolJob * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	int i;
+
+	// a failed job is done, so a later PoolComplete() returns -1
+	job->state = JOB_DONE;
+	job->job.state = JOB_DONE;
+	job->job.error = -1;
+	if((n != BITS_LOW) && (n != BITS_HIGH) && (n != BITS_TOT)){
+		printf("[ERROR] MME1536: PoolSubmit() -> wrong operand length: %d\n", n);
+		return -1;
+	}
+	// the job may run on any core (see MME1536_PoolSteal())
+	if((t <= 0) || ((t%32) != 0)){
+		printf("[ERROR] MME1536: PoolSubmit() -> exponent length %d, is no multiple of 32.\n", t);
+		return -1;
+	}
+	for(i=0; i<pool->count; i++){
+		MME1536 * dev = &(pool->device[i].dev);
+		if(!dev->fifo_streaming && (t/16 > dev->fifo_depth)){
+			printf("[ERROR] MME1536: PoolSubmit() -> exponent of %d fifo entries does not fit the fifo of %s (%d entries)\n", t/16, pool->device[i].uio_dev, dev->fifo_depth);
+			return -1;
+		}
+	}
+
+	job->result = result;
+	job->g0 = g0;
+	job->g1 = g1;
+	job->m = m;
+	job->e0 = e0;
+	job->e1 = e1;
+	job->n = n;
+	job->t = t;
+	job->hash = MME1536_ModulusHash(m, n);
+	job->job.state = JOB_IDLE;
+	job->job.error = 0;
+	job->next = NULL;
+	job->state = JOB_QUEUED;
+
+	// append to the queue of the selected core
+	int index = MME1536_PoolSelect(pool, job);
+	MME1536_PoolDevice * device = &(pool->device[index]);
+	if(device->tail != NULL) device->tail->next = job;
+	else device->head = job;
+	device->tail = job;
+	device->queued++;
+
+	MME1536_PoolKick(pool, index);
+
+	return 0;
+}
+
+/** Handle pending interrupts of all cores without blocking.
+ *
+ * @param pool is a pointer to the pool
+ *
+ * @return the nr. of jobs that were completed
+ */
+int MME1536_PoolPoll(MME1536_Pool * pool){
+	int done = 0;
+	int i;
+
+	for(i=0; i<pool->count; i++){
+		MME1536_PoolDevice * device = &(pool->device[i]);
+		if(device->active != NULL){
+			MME1536_Poll(&(device->dev));
+			if(device->active->job.state != JOB_DONE) continue;
+			device->active->state = JOB_DONE;
+			device->active = NULL;
+			done++;
+		}
+		// idle core: take the next job or steal one
+		MME1536_PoolKick(pool, i);
+	}
+
+	return done;
+}
+
+/** Wait until one of the cores raises an interrupt, then handle it.
+ *
+ * @param pool is a pointer to the pool
+ * @param timeout_ms is the maximum time to wait (-1 waits forever)
+ *
+ * @return the nr. of jobs that were completed
+ *         -1 upon failure
+ */
+int MME1536_PoolWait(MME1536_Pool * pool, int timeout_ms){
+	struct pollfd fds[POOL_MAX_DEVICES];
+	int count = 0;
+	int interval;
+	int i;
+
+	for(i=0; i<pool->count; i++){
+		if(pool->device[i].active == NULL) continue;
+		fds[count].fd = MME1536_GetFd(&(pool->device[i].dev));
+		fds[count].events = POLLIN;
+		count++;
+		// a streamed exponent needs regular fifo top-ups
+		interval = MME1536_PollInterval(&(pool->device[i].dev));
+		if((interval >= 0) && ((timeout_ms < 0) || (interval < timeout_ms))){
+			timeout_ms = interval;
+		}
+	}
+	if(count == 0) return 0;
+
+	if(poll(fds, count, timeout_ms) < 0){
+		perror("[ERROR] MME1536: PoolWait() -> poll failed\n");
+		return -1;
+	}
+
+	return MME1536_PoolPoll(pool);
+}
+
+/** Wait until a job is done.
+ *
+ * @param pool is a pointer to the pool
+ * @param job is a pointer to a job submitted on this pool
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_PoolComplete(MME1536_Pool * pool, MME1536_PoolJob * job){
+	int timeout_ms = TIMEOUT_S * 1000 + TIMEOUT_US / 1000;
+
+	while(job->state != JOB_DONE){
+		if(MME1536_PoolWait(pool, timeout_ms) < 0) return -1;
+	}
+
+	// aborted when its core timed out
+	return job->job.error;
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** Pick the core for a new job: the core that will have the job's modulus
+ * loaded, unless it is more than POOL_AFFINITY_SLACK jobs busier than the
+ * least loaded core.
+ */
+int MME1536_PoolSelect(MME1536_Pool * pool, MME1536_PoolJob * job){
+	int best = 0, affinity = -1;
+	int i;
+
+	for(i=0; i<pool->count; i++){
+		MME1536_PoolDevice * device = &(pool->device[i]);
+		unsigned int hash;
+		int n;
+
+		if(MME1536_PoolLoad(device) < MME1536_PoolLoad(&(pool->device[best]))) best = i;
+
+		// modulus the core has once its queue is done
+		if(device->tail != NULL){
+			hash = device->tail->hash;
+			n = device->tail->n;
+		}
+		else if(device->active != NULL){
+			hash = device->active->hash;
+			n = device->active->n;
+		}
+		else if(device->loaded){
+			hash = device->hash;
+			n = device->n;
+		}
+		else continue;
+
+		if((hash == job->hash) && (n == job->n)){
+			if((affinity < 0) || (MME1536_PoolLoad(device) < MME1536_PoolLoad(&(pool->device[affinity])))){
+				affinity = i;
+			}
+		}
+	}
+
+	if((affinity >= 0) &&
+	   (MME1536_PoolLoad(&(pool->device[affinity])) <= MME1536_PoolLoad(&(pool->device[best])) + POOL_AFFINITY_SLACK)){
+		return affinity;
+	}
+
+	return best;
+}
+
+/** Start the next job on a core if it is idle. A job the core rejects is
+ * done with error -1 and the next one is started.
+ */
+void MME1536_PoolKick(MME1536_Pool * pool, int index){
+	MME1536_PoolDevice * device = &(pool->device[index]);
+	MME1536_PoolJob * job;
+	int ret;
+
+	while(device->active == NULL){
+		job = device->head;
+		if(job != NULL){
+			device->head = job->next;
+			if(device->head == NULL) device->tail = NULL;
+			device->queued--;
+		}
+		else{
+			job = MME1536_PoolSteal(pool, index);
+			if(job == NULL) return;
+		}
+		job->next = NULL;
+		job->device = index;
+
+		// load the modulus unless the core has it already
+		if(!device->loaded || (device->n != job->n) || (device->hash != job->hash)
+		   || (memcmp(device->m, job->m, job->n / 8) != 0)){
+			if(MME1536_UpdateModulus(&(device->dev), job->m, job->n) != 0){
+				device->loaded = 0;
+				job->job.state = JOB_DONE;
+				job->job.error = -1;
+				job->state = JOB_DONE;
+				continue;
+			}
+			memcpy(device->m, job->m, job->n / 8);
+			device->n = job->n;
+			device->hash = job->hash;
+			device->loaded = 1;
+		}
+
+		// without e1 it is g0^e0, which doesn't need the precomputation of g1
+		if(job->e1 == NULL) ret = MME1536_SubmitExp_m(&(device->dev), &(job->job), job->result, job->g0, job->e0, job->t);
+		else ret = MME1536_SubmitMME_m(&(device->dev), &(job->job), job->result, job->g0, job->g1, job->e0, job->e1, job->t);
+		if(ret != 0){
+			job->job.state = JOB_DONE;
+			job->job.error = -1;
+			job->state = JOB_DONE;
+			continue;
+		}
+		job->state = JOB_RUNNING;
+		device->active = job;
+	}
+}
+
+/** Take a waiting job from the core with the longest queue, preferably one
+ * with the modulus the idle core has loaded.
+ *
+ * @return the job
+ *         NULL if no job is waiting
+ */
+MME1536_PoolJob * MME1536_PoolSteal(MME1536_Pool * pool, int index){
+	MME1536_PoolDevice * thief = &(pool->device[index]);
+	MME1536_PoolDevice * victim = NULL;
+	MME1536_PoolJob * job, * prev, * steal_prev;
+	int i;
+
+	for(i=0; i<pool->count; i++){
+		if((i == index) || (pool->device[i].queued == 0)) continue;
+		if((victim == NULL) || (pool->device[i].queued > victim->queued)) victim = &(pool->device[i]);
+	}
+	if(victim == NULL) return NULL;
+
+	// default to the last job in the queue
+	steal_prev = NULL;
+	prev = NULL;
+	for(job=victim->head; job!=NULL; job=job->next){
+		if(job->next == NULL) steal_prev = prev;
+		if(thief->loaded && (job->hash == thief->hash) && (job->n == thief->n)){
+			steal_prev = prev;
+			break;
+		}
+		prev = job;
+	}
+
+	// unlink
+	if(steal_prev == NULL){
+		job = victim->head;
+		victim->head = job->next;
+	}
+	else{
+		job = steal_prev->next;
+		steal_prev->next = job->next;
+	}
+	if(victim->tail == job) victim->tail = steal_prev;
+	victim->queued--;
+
+	return job;
+}
+
+/** Nr. of jobs waiting for or using a core.
+ */
+int MME1536_PoolLoad(MME1536_PoolDevice * device){
+	return device->queued + (device->active != NULL);
+}
+
+int MME1536_PoolReadSysfs(char * path, char * buffer, int size){
+	FILE * file = fopen(path, "r");
+	if(file == NULL) return -1;
+
+	if(fgets(buffer, size, file) == NULL){
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+	buffer[strcspn(buffer, "\n")] = '\0';
+
+	return 0;
+}
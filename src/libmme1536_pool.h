@@ -0,0 +1,83 @@
+/** @file libmme1536_pool.h Header file for libmme1536_pool.c
+ * Contains the definitions and function prototypes for driving several
+ * mod_sim_exp cores through one submission API.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_POOL_H_
+#define _LIBMME1536_POOL_H_
+
+#include "libmme1536_v1.h"
+
+// maximum nr. of cores in a pool
+#define POOL_MAX_DEVICES	8
+
+// UIO name of the mod_sim_exp cores (/sys/class/uio/uioX/name)
+#define POOL_UIO_NAME	"mod_sim_exp"
+
+// a core that has the modulus loaded is preferred unless it has this
+// many more jobs waiting than the least loaded core
+#define POOL_AFFINITY_SLACK	2
+
+/// a job submitted to a pool
+typedef struct mme1536_pool_job_st{
+	int state;
+	int device; // core the job runs on
+
+	/* operation */
+	int * result;
+	int * g0;
+	int * g1;
+	int * m;
+	int * e0;
+	int * e1;
+	int n, t;
+	unsigned int hash;
+
+	/* hardware job on the core */
+	MME1536_Job job;
+
+	struct mme1536_pool_job_st * next;
+} MME1536_PoolJob;
+
+/// one core of a pool with its own queue
+typedef struct mme1536_pool_device_st{
+	MME1536 dev;
+	char uio_dev[64];
+
+	/* waiting jobs */
+	MME1536_PoolJob * head;
+	MME1536_PoolJob * tail;
+	int queued;
+
+	/* job using the core */
+	MME1536_PoolJob * active;
+
+	/* loaded modulus */
+	int loaded;
+	int n;
+	unsigned int hash;
+	int m[WORDS_TOT];
+} MME1536_PoolDevice;
+
+/// a pool of cores
+typedef struct mme1536_pool_st{
+	int count;
+	MME1536_PoolDevice device[POOL_MAX_DEVICES];
+} MME1536_Pool;
+
+/** Function prototypes
+ */
+
+int MME1536_PoolInitialize(MME1536_Pool * pool, char ** uio_devs, unsigned long * data_bases, int count);
+int MME1536_PoolDiscover(MME1536_Pool * pool);
+void MME1536_PoolClean(MME1536_Pool * pool);
+
+int MME1536_PoolSubmit(MME1536_Pool * pool, MME1536_PoolJob * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+int MME1536_PoolPoll(MME1536_Pool * pool);
+int MME1536_PoolWait(MME1536_Pool * pool, int timeout_ms);
+int MME1536_PoolComplete(MME1536_Pool * pool, MME1536_PoolJob * job);
+
+#endif /*_LIBMME1536_POOL_H_*/
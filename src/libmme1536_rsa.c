@@ -0,0 +1,226 @@
+/** @file libmme1536_rsa.c This file contains the source code for RSA
+ * private key operations with the chinese remainder theorem.
+ *
+ * m = c^d mod pq is computed as m1 = c^dp mod p and m2 = c^dq mod q on the
+ * core, followed by Garner's recombination
+ *   m = m2 + q.((m1 - m2).qinv mod p)
+ * on the host. On a single core both halves are queued as asynchronous
+ * jobs, so the second one is started from the interrupt of the first
+ * without a round trip through the caller. On a pool they run on two cores
+ * at the same time.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libmme1536_rsa.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+void MME1536_RsaExport(int * bin, mpz_t x);
+int MME1536_RsaExpLength(mpz_t e);
+void MME1536_RsaCombine(MME1536_RsaKey * key, mpz_t result, int * m1_bin, int * m2_bin);
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Prepare an RSA private key for CRT operations.
+ *
+ * @param key is a pointer to the key to initialise
+ * @param p, q are the prime factors of the modulus (at most 1536 bits)
+ * @param d is the private exponent
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_RsaInit(MME1536_RsaKey * key, mpz_t p, mpz_t q, mpz_t d){
+	size_t half = mpz_sizeinbase(p, 2);
+	mpz_t t;
+
+	if(mpz_sizeinbase(q, 2) > half) half = mpz_sizeinbase(q, 2);
+	if(half <= BITS_LOW) key->n = BITS_LOW;
+	else if(half <= BITS_HIGH) key->n = BITS_HIGH;
+	else if(half <= BITS_TOT) key->n = BITS_TOT;
+	else{
+		printf("[ERROR] MME1536: RsaInit() -> primes of %d bits are too long\n", (int)half);
+		return -1;
+	}
+	if(mpz_even_p(p) || mpz_even_p(q)){
+		printf("[ERROR] MME1536: RsaInit() -> p and q must be odd\n");
+		return -1;
+	}
+
+	mpz_init(key->modulus);
+	mpz_init_set(key->p, p);
+	mpz_init_set(key->q, q);
+	mpz_init(key->qinv);
+	mpz_mul(key->modulus, p, q);
+	key->bits = mpz_sizeinbase(key->modulus, 2);
+	if(mpz_invert(key->qinv, q, p) == 0){
+		printf("[ERROR] MME1536: RsaInit() -> q is not invertible mod p\n");
+		MME1536_RsaClear(key);
+		return -1;
+	}
+
+	MME1536_RsaExport(key->p_bin, p);
+	MME1536_RsaExport(key->q_bin, q);
+
+	// dp = d mod (p-1), dq = d mod (q-1)
+	mpz_init(t);
+	mpz_sub_ui(t, p, 1);
+	mpz_mod(t, d, t);
+	key->tp = MME1536_RsaExpLength(t);
+	MME1536_RsaExport(key->dp_bin, t);
+	mpz_sub_ui(t, q, 1);
+	mpz_mod(t, d, t);
+	key->tq = MME1536_RsaExpLength(t);
+	MME1536_RsaExport(key->dq_bin, t);
+	mpz_clear(t);
+
+	return 0;
+}
+
+/** Free the GMP variables of a key.
+ *
+ * @param key is a pointer to a key set up with MME1536_RsaInit()
+ *
+ * @return nothing
+ */
+void MME1536_RsaClear(MME1536_RsaKey * key){
+	mpz_clear(key->modulus);
+	mpz_clear(key->p);
+	mpz_clear(key->q);
+	mpz_clear(key->qinv);
+}
+
+/** Compute c^d mod pq on one core.
+ *
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param key is a pointer to a key set up with MME1536_RsaInit()
+ * @param result is set to c^d mod pq
+ * @param c is the input (0 <= c < pq)
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_RsaPrivate(MME1536 * device_instance, MME1536_RsaKey * key, mpz_t result, mpz_t c){
+	int cp_bin[WORDS_TOT], cq_bin[WORDS_TOT];
+	int m1_bin[WORDS_TOT], m2_bin[WORDS_TOT];
+	MME1536_Job job_p, job_q;
+	mpz_t t;
+
+	// reduce the input for both halves
+	mpz_init(t);
+	mpz_mod(t, c, key->p);
+	MME1536_RsaExport(cp_bin, t);
+	mpz_mod(t, c, key->q);
+	MME1536_RsaExport(cq_bin, t);
+	mpz_clear(t);
+
+	// both halves are queued, the second starts as soon as the first is done
+	if(MME1536_SubmitExp(device_instance, &job_p, m1_bin, cp_bin, key->p_bin, key->dp_bin, key->n, key->tp) != 0){
+		return -1;
+	}
+	if(MME1536_SubmitExp(device_instance, &job_q, m2_bin, cq_bin, key->q_bin, key->dq_bin, key->n, key->tq) != 0){
+		MME1536_Complete(device_instance, &job_p);
+		return -1;
+	}
+	if((MME1536_Complete(device_instance, &job_p) != 0) | (MME1536_Complete(device_instance, &job_q) != 0)){
+		return -1;
+	}
+
+	MME1536_RsaCombine(key, result, m1_bin, m2_bin);
+
+	return 0;
+}
+
+/** Compute c^d mod pq with the halves on two cores of a pool (if it has
+ * more than one).
+ *
+ * @param pool is a pointer to the pool
+ * @param key is a pointer to a key set up with MME1536_RsaInit()
+ * @param result is set to c^d mod pq
+ * @param c is the input (0 <= c < pq)
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_RsaPrivatePool(MME1536_Pool * pool, MME1536_RsaKey * key, mpz_t result, mpz_t c){
+	int cp_bin[WORDS_TOT], cq_bin[WORDS_TOT];
+	int m1_bin[WORDS_TOT], m2_bin[WORDS_TOT];
+	MME1536_PoolJob job_p, job_q;
+	mpz_t t;
+
+	mpz_init(t);
+	mpz_mod(t, c, key->p);
+	MME1536_RsaExport(cp_bin, t);
+	mpz_mod(t, c, key->q);
+	MME1536_RsaExport(cq_bin, t);
+	mpz_clear(t);
+
+	// the pool spreads the halves over its least loaded cores
+	if(MME1536_PoolSubmit(pool, &job_p, m1_bin, cp_bin, cp_bin, key->p_bin, key->dp_bin, NULL, key->n, key->tp) != 0){
+		return -1;
+	}
+	if(MME1536_PoolSubmit(pool, &job_q, m2_bin, cq_bin, cq_bin, key->q_bin, key->dq_bin, NULL, key->n, key->tq) != 0){
+		MME1536_PoolComplete(pool, &job_p);
+		return -1;
+	}
+	if((MME1536_PoolComplete(pool, &job_p) != 0) | (MME1536_PoolComplete(pool, &job_q) != 0)){
+		return -1;
+	}
+
+	MME1536_RsaCombine(key, result, m1_bin, m2_bin);
+
+	return 0;
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** Write x into a WORDS_TOT word operand (least significant word first).
+ */
+void MME1536_RsaExport(int * bin, mpz_t x){
+	memset(bin, 0, WORDS_TOT * sizeof(int));
+	mpz_export((void *)bin, NULL, -1, sizeof(int), 0, 0, x);
+}
+
+/** Length of an exponent as passed to the core (#bits, multiple of 32).
+ */
+int MME1536_RsaExpLength(mpz_t e){
+	int t = (mpz_sizeinbase(e, 2) + 31) / 32 * 32;
+	return (t == 0) ? 32 : t;
+}
+
+/** Garner's recombination: result = m2 + q.((m1 - m2).qinv mod p).
+ */
+void MME1536_RsaCombine(MME1536_RsaKey * key, mpz_t result, int * m1_bin, int * m2_bin){
+	mpz_t m1, m2, h;
+	int words = key->n / 32;
+
+	mpz_init(m1);
+	mpz_init(m2);
+	mpz_init(h);
+	mpz_import(m1, words, -1, sizeof(int), 0, 0, m1_bin);
+	mpz_import(m2, words, -1, sizeof(int), 0, 0, m2_bin);
+	mpz_mod(m1, m1, key->p);
+	mpz_mod(m2, m2, key->q);
+
+	mpz_sub(h, m1, m2);
+	mpz_mul(h, h, key->qinv);
+	mpz_mod(h, h, key->p);
+	mpz_mul(h, h, key->q);
+	mpz_add(result, m2, h);
+
+	mpz_clear(m1);
+	mpz_clear(m2);
+	mpz_clear(h);
+}
@@ -0,0 +1,47 @@
+/** @file libmme1536_rsa.h Header file for libmme1536_rsa.c
+ * Contains the definitions and function prototypes for RSA private key
+ * operations with the chinese remainder theorem (CRT).
+ *
+ * The two half-size exponentiations (mod p and mod q) run on the core,
+ * the recombination is done with GMP. So a 2048-bit key uses the 1024-bit
+ * (high) pipeline part, a 1024-bit key the 512-bit part and a 3072-bit key
+ * the whole pipeline.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_RSA_H_
+#define _LIBMME1536_RSA_H_
+
+#include "gmp.h"
+
+#include "libmme1536_v1.h"
+#include "libmme1536_pool.h"
+
+/// the CRT form of an RSA private key
+typedef struct mme1536_rsa_key_st{
+	int bits; // modulus length
+	int n; // hardware operand length used for p and q (#bits)
+
+	mpz_t modulus, p, q;
+	mpz_t qinv; // q^(-1) mod p
+
+	/* operands for the core: p, q and d mod (p-1), d mod (q-1) */
+	int p_bin[WORDS_TOT];
+	int q_bin[WORDS_TOT];
+	int dp_bin[WORDS_TOT];
+	int dq_bin[WORDS_TOT];
+	int tp, tq; // exponent lengths (#bits, multiple of 32)
+} MME1536_RsaKey;
+
+/** Function prototypes
+ */
+
+int MME1536_RsaInit(MME1536_RsaKey * key, mpz_t p, mpz_t q, mpz_t d);
+void MME1536_RsaClear(MME1536_RsaKey * key);
+
+int MME1536_RsaPrivate(MME1536 * device_instance, MME1536_RsaKey * key, mpz_t result, mpz_t c);
+int MME1536_RsaPrivatePool(MME1536_Pool * pool, MME1536_RsaKey * key, mpz_t result, mpz_t c);
+
+#endif /*_LIBMME1536_RSA_H_*/
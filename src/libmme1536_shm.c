@@ -0,0 +1,817 @@
+/** @file libmme1536_shm.c This file contains the source code for sharing
+ * one mod_sim_exp core between processes.
+ *
+ * The broker owns the core through the asynchronous API of
+ * libmme1536_v1.c. Every client that connects to its unix socket gets its
+ * own shared memory region (a memfd) and doorbell (an eventfd), passed over
+ * the socket. A client writes the operands of a job into a free slot of the
+ * region, puts the slot index in the region's single-producer,
+ * single-consumer ring and only makes a system call when the broker sleeps
+ * (doorbell) or when it waits for the job itself (futex in the slot).
+ *
+ * The broker takes up to quantum jobs from each client in turn, until
+ * inflight_max jobs are on the core, and runs the jobs of one such round
+ * grouped by modulus with the operands and result in the region, so the
+ * modulus cache and the operand residency of the handle skip the R2
+ * computation and the modulus upload. Everything it reads from a region
+ * is checked or copied first: a client can only hurt its own jobs.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "libmme1536_shm.h"
+
+/******************************************************************************
+ * Low-level Function Prototypes (not to be used outside this file)           *
+ ******************************************************************************/
+int MME1536_BrokerProgress(MME1536_Broker * broker);
+int MME1536_BrokerAccept(MME1536_Broker * broker);
+void MME1536_BrokerRelease(MME1536_Broker * broker, int index);
+int MME1536_BrokerPending(MME1536_Broker * broker);
+void MME1536_BrokerSleeping(MME1536_Broker * broker, int sleeping);
+void MME1536_BrokerIntake(MME1536_Broker * broker);
+MME1536_BrokerJob * MME1536_BrokerTake(MME1536_Broker * broker, int index);
+void MME1536_BrokerOrder(MME1536_Broker * broker, MME1536_BrokerJob ** round, int count);
+void MME1536_BrokerSubmit(MME1536_Broker * broker, MME1536_BrokerJob * job);
+int MME1536_BrokerRetire(MME1536_Broker * broker);
+void MME1536_BrokerFinish(MME1536_Broker * broker, MME1536_BrokerJob * job, int error);
+void MME1536_ShmFinish(MME1536_ShmSlot * slot, int error);
+int MME1536_ShmFutex(atomic_int * word, int op, int value, const struct timespec * timeout);
+
+/******************************************************************************
+ * API Function Source                                                        *
+ ******************************************************************************/
+
+/** Start a broker for an initialised core: listen on a unix socket for
+ * clients. From now on only the broker may use device_instance.
+ *
+ * @param broker is a pointer to the broker
+ * @param device_instance is a pointer to an initialised MME1536 variable
+ * @param path is the path of the socket, NULL for SHM_SOCKET_PATH
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_BrokerStart(MME1536_Broker * broker, MME1536 * device_instance, const char * path){
+	struct sockaddr_un addr;
+
+	memset(broker, 0, sizeof(MME1536_Broker));
+	broker->dev = device_instance;
+	if(path == NULL) path = SHM_SOCKET_PATH;
+	if(strlen(path) >= sizeof(addr.sun_path)){
+		printf("[ERROR] MME1536: BrokerStart() -> socket path too long: %s\n", path);
+		return -1;
+	}
+	strncpy(broker->path, path, sizeof(broker->path) - 1);
+	MME1536_BrokerLimits(broker, SHM_DEPTH, SHM_QUANTUM, SHM_INFLIGHT);
+	atomic_init(&(broker->stop), 0);
+
+	broker->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(broker->listen_fd < 0){
+		perror("[ERROR] MME1536: BrokerStart() -> could not create socket\n");
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+	// a stale socket of an earlier broker
+	unlink(path);
+	if((bind(broker->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+	   || (listen(broker->listen_fd, SHM_MAX_CLIENTS) != 0)){
+		perror("[ERROR] MME1536: BrokerStart() -> could not listen on socket\n");
+		close(broker->listen_fd);
+		return -1;
+	}
+
+	return 0;
+}
+
+/** Set how much of the core a client can take.
+ *
+ * @param broker is a pointer to the broker
+ * @param depth is the nr. of slots of a new client: its jobs queued and
+ *        on the core (1 .. SHM_MAX_DEPTH)
+ * @param quantum is the nr. of jobs taken from a client per round
+ * @param inflight_max is the nr. of jobs on the core (of all clients)
+ *
+ * @return nothing
+ */
+void MME1536_BrokerLimits(MME1536_Broker * broker, int depth, int quantum, int inflight_max){
+	if(depth < 1) depth = 1;
+	if(depth > SHM_MAX_DEPTH) depth = SHM_MAX_DEPTH;
+	broker->depth = depth;
+	broker->quantum = (quantum < 1) ? 1 : quantum;
+	broker->inflight_max = (inflight_max < 1) ? 1 : inflight_max;
+}
+
+/** Run the broker once: take posted jobs, handle the interrupts of the
+ * core, and if there is nothing to do, sleep until a client rings,
+ * connects or leaves, or the core raises an interrupt.
+ *
+ * @param broker is a pointer to the broker
+ * @param timeout_ms is the maximum time to sleep (-1 sleeps until an event)
+ *
+ * @return the nr. of jobs that were completed
+ *         -1 upon failure
+ */
+int MME1536_BrokerStep(MME1536_Broker * broker, int timeout_ms){
+	struct pollfd fds[2 + 2 * SHM_MAX_CLIENTS];
+	int owner[2 + 2 * SHM_MAX_CLIENTS];
+	int count = 0;
+	int done, i;
+
+	done = MME1536_BrokerProgress(broker);
+	if(done > 0) return done;
+
+	// announce that we are going to sleep, the check of the rings must not
+	// pass the stores (see MME1536_ShmPost())
+	MME1536_BrokerSleeping(broker, 1);
+	atomic_thread_fence(memory_order_seq_cst);
+	if(MME1536_BrokerPending(broker) && (broker->inflight < broker->inflight_max)){
+		MME1536_BrokerSleeping(broker, 0);
+		return MME1536_BrokerProgress(broker);
+	}
+
+	fds[count].fd = broker->listen_fd;
+	fds[count].events = POLLIN;
+	owner[count++] = -1;
+	if(broker->inflight > 0){
+		int interval = MME1536_PollInterval(broker->dev);
+		int budget_ms = TIMEOUT_S * 1000 + TIMEOUT_US / 1000;
+		fds[count].fd = MME1536_GetFd(broker->dev);
+		fds[count].events = POLLIN;
+		owner[count++] = -1;
+		// a streamed exponent needs regular fifo top-ups
+		if((interval >= 0) && (interval < budget_ms)) budget_ms = interval;
+		if((timeout_ms < 0) || (budget_ms < timeout_ms)) timeout_ms = budget_ms;
+	}
+	for(i=0; i<SHM_MAX_CLIENTS; i++){
+		MME1536_BrokerClient * client = &(broker->client[i]);
+		if(!client->active || client->closing) continue;
+		fds[count].fd = client->sock;
+		fds[count].events = POLLIN;
+		owner[count++] = i;
+		fds[count].fd = client->doorbell_fd;
+		fds[count].events = POLLIN;
+		owner[count++] = i;
+	}
+
+	if(poll(fds, count, timeout_ms) < 0){
+		MME1536_BrokerSleeping(broker, 0);
+		if(errno == EINTR) return 0;
+		perror("[ERROR] MME1536: BrokerStep() -> poll failed\n");
+		return -1;
+	}
+	MME1536_BrokerSleeping(broker, 0);
+
+	if(fds[0].revents & POLLIN) MME1536_BrokerAccept(broker);
+	for(i=1; i<count; i++){
+		MME1536_BrokerClient * client;
+		if((owner[i] < 0) || (fds[i].revents == 0)) continue;
+		client = &(broker->client[owner[i]]);
+		if(fds[i].fd == client->doorbell_fd){
+			uint64_t rings;
+			read(client->doorbell_fd, &rings, sizeof(rings));
+		}
+		else{
+			// the client never writes to the socket: it closed it
+			client->closing = 1;
+		}
+	}
+
+	done = MME1536_BrokerProgress(broker);
+	for(i=0; i<SHM_MAX_CLIENTS; i++){
+		if(broker->client[i].active && broker->client[i].closing && (broker->client[i].inflight == 0)){
+			MME1536_BrokerRelease(broker, i);
+		}
+	}
+
+	return done;
+}
+
+/** Run the broker until its stop flag is set (e.g. by a signal handler),
+ * then finish the jobs on the core.
+ *
+ * @param broker is a pointer to the broker
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_BrokerRun(MME1536_Broker * broker){
+	while(!atomic_load(&(broker->stop))){
+		if(MME1536_BrokerStep(broker, SHM_TICK_MS) < 0) return -1;
+	}
+	while(broker->inflight > 0){
+		if(MME1536_BrokerStep(broker, SHM_TICK_MS) < 0) return -1;
+	}
+
+	return 0;
+}
+
+/** Disconnect all clients and remove the socket. Jobs the clients posted
+ * but the broker didn't take stay unfinished.
+ *
+ * @param broker is a pointer to the broker
+ *
+ * @return nothing
+ */
+void MME1536_BrokerStop(MME1536_Broker * broker){
+	int i;
+
+	for(i=0; i<SHM_MAX_CLIENTS; i++){
+		if(broker->client[i].active) MME1536_BrokerRelease(broker, i);
+	}
+	close(broker->listen_fd);
+	unlink(broker->path);
+}
+
+/** Connect to a broker.
+ *
+ * @param client is a pointer to the connection
+ * @param path is the path of the broker socket, NULL for SHM_SOCKET_PATH
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ShmConnect(MME1536_ShmClient * client, const char * path){
+	struct sockaddr_un addr;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr * cmsg;
+	char control[CMSG_SPACE(2 * sizeof(int))];
+	int fd[2];
+	int depth;
+	void * region;
+
+	if(path == NULL) path = SHM_SOCKET_PATH;
+	client->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(client->sock < 0){
+		perror("[ERROR] MME1536: ShmConnect() -> could not create socket\n");
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+	if(connect(client->sock, (struct sockaddr *)&addr, sizeof(addr)) != 0){
+		perror("[ERROR] MME1536: ShmConnect() -> could not connect to the broker\n");
+		close(client->sock);
+		return -1;
+	}
+
+	// the broker sends the depth with the region and the doorbell
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &depth;
+	iov.iov_len = sizeof(depth);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	if(recvmsg(client->sock, &msg, MSG_CMSG_CLOEXEC) != sizeof(depth)){
+		printf("[ERROR] MME1536: ShmConnect() -> the broker refused the connection\n");
+		close(client->sock);
+		return -1;
+	}
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if((cmsg == NULL) || (cmsg->cmsg_type != SCM_RIGHTS) || (cmsg->cmsg_len != CMSG_LEN(2 * sizeof(int)))){
+		printf("[ERROR] MME1536: ShmConnect() -> no region received\n");
+		close(client->sock);
+		return -1;
+	}
+	memcpy(fd, CMSG_DATA(cmsg), sizeof(fd));
+
+	region = mmap(NULL, sizeof(MME1536_ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd[0], 0);
+	close(fd[0]);
+	if((region == MAP_FAILED) || (((MME1536_ShmRegion *)region)->magic != SHM_MAGIC)){
+		printf("[ERROR] MME1536: ShmConnect() -> could not map the region\n");
+		if(region != MAP_FAILED) munmap(region, sizeof(MME1536_ShmRegion));
+		close(fd[1]);
+		close(client->sock);
+		return -1;
+	}
+	client->region = (MME1536_ShmRegion *)region;
+	client->doorbell_fd = fd[1];
+	depth = client->region->depth;
+	client->free_mask = (depth == 64) ? ~0ULL : ((1ULL << depth) - 1);
+
+	return 0;
+}
+
+/** Close a connection. The broker finishes the jobs of the client that are
+ * on the core and drops the others.
+ *
+ * @param client is a pointer to the connection
+ *
+ * @return nothing
+ */
+void MME1536_ShmDisconnect(MME1536_ShmClient * client){
+	munmap(client->region, sizeof(MME1536_ShmRegion));
+	close(client->doorbell_fd);
+	close(client->sock);
+}
+
+/** Take a free slot: fill in its type, n, t and operands (the ones the
+ * type uses), then post it with MME1536_ShmPost().
+ *
+ * @param client is a pointer to the connection
+ *
+ * @return the slot
+ *         NULL if all slots of the client are in use
+ */
+MME1536_ShmSlot * MME1536_ShmAcquire(MME1536_ShmClient * client){
+	int i;
+
+	if(client->free_mask == 0) return NULL;
+	i = __builtin_ctzll(client->free_mask);
+	client->free_mask &= ~(1ULL << i);
+
+	return &(client->region->slot[i]);
+}
+
+/** Post a filled in slot to the broker. The slot must not be written until
+ * the job is done.
+ *
+ * @param client is a pointer to the connection
+ * @param slot is a slot from MME1536_ShmAcquire()
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ShmPost(MME1536_ShmClient * client, MME1536_ShmSlot * slot){
+	MME1536_ShmRegion * region = client->region;
+	unsigned index = slot - region->slot;
+	unsigned tail;
+
+	if((index >= (unsigned)region->depth) || (client->free_mask & (1ULL << index))){
+		printf("[ERROR] MME1536: ShmPost() -> not an acquired slot\n");
+		return -1;
+	}
+	slot->error = 0;
+	atomic_store_explicit(&(slot->state), SHM_POSTED, memory_order_relaxed);
+
+	// publish
+	tail = atomic_load_explicit(&(region->post_tail), memory_order_relaxed);
+	region->post[tail & (SHM_MAX_DEPTH - 1)] = index;
+	atomic_store_explicit(&(region->post_tail), tail + 1, memory_order_release);
+
+	// the load of sleeping must not pass the publish: either the broker sees
+	// the job before it sleeps or we see it sleeping
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load(&(region->sleeping))){
+		uint64_t ring = 1;
+		write(client->doorbell_fd, &ring, sizeof(ring));
+	}
+
+	return 0;
+}
+
+/** Check whether a posted slot is done.
+ *
+ * @return 1 if the job is done
+ *         0 otherwise
+ */
+int MME1536_ShmTest(MME1536_ShmSlot * slot){
+	return (atomic_load_explicit(&(slot->state), memory_order_acquire) == SHM_DONE);
+}
+
+/** Wait until a posted slot is done.
+ *
+ * @param client is a pointer to the connection
+ * @param slot is the posted slot
+ *
+ * @return 0 upon success (the result is in the slot)
+ *         -1 upon failure
+ */
+int MME1536_ShmWait(MME1536_ShmClient * client, MME1536_ShmSlot * slot){
+	struct timespec tick = {SHM_TICK_MS / 1000, (SHM_TICK_MS % 1000) * 1000000L};
+	int state = SHM_POSTED;
+
+	// announce that we are going to sleep
+	if(!atomic_compare_exchange_strong(&(slot->state), &state, SHM_WAITING) && (state == SHM_DONE)){
+		return slot->error;
+	}
+	while(atomic_load_explicit(&(slot->state), memory_order_acquire) != SHM_DONE){
+		if((MME1536_ShmFutex(&(slot->state), FUTEX_WAIT, SHM_WAITING, &tick) != 0) && (errno == ETIMEDOUT)){
+			// the broker closes the socket when it goes away
+			struct pollfd fd = {client->sock, POLLIN, 0};
+			if(poll(&fd, 1, 0) > 0){
+				printf("[ERROR] MME1536: ShmWait() -> the broker is gone\n");
+				return -1;
+			}
+		}
+	}
+
+	return slot->error;
+}
+
+/** Give a slot back once its result has been used.
+ *
+ * @param client is a pointer to the connection
+ * @param slot is a slot from MME1536_ShmAcquire()
+ *
+ * @return nothing
+ */
+void MME1536_ShmRelease(MME1536_ShmClient * client, MME1536_ShmSlot * slot){
+	unsigned index = slot - client->region->slot;
+
+	atomic_store_explicit(&(slot->state), SHM_FREE, memory_order_relaxed);
+	client->free_mask |= 1ULL << index;
+}
+
+/** Compute g0^e0 * g1^e1 mod m on the broker's core (see MME1536_MME()),
+ * or g0^e0 mod m when e1 is NULL. Copies the operands into a slot and
+ * waits for the result.
+ *
+ * @param client is a pointer to the connection
+ * @param result is a pointer to the buffer where the result will be stored
+ * @param g0, g1, e0, e1, m are arrays containing the bases and exponents
+ * @param n is the lenght of g0, g1 and m (#bits)
+ * @param t is the length of the exponents (#bits, at most SHM_EXP_BITS)
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ShmMME(MME1536_ShmClient * client, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	MME1536_ShmSlot * slot;
+	int ret;
+
+	if((n != BITS_LOW) && (n != BITS_HIGH) && (n != BITS_TOT)){
+		printf("[ERROR] MME1536: ShmMME() -> wrong operand length: %d\n", n);
+		return -1;
+	}
+	if((t <= 0) || (t > SHM_EXP_BITS) || ((t%32) != 0)){
+		printf("[ERROR] MME1536: ShmMME() -> wrong exponent length: %d\n", t);
+		return -1;
+	}
+	slot = MME1536_ShmAcquire(client);
+	if(slot == NULL){
+		printf("[ERROR] MME1536: ShmMME() -> all slots in use\n");
+		return -1;
+	}
+
+	slot->type = (e1 != NULL) ? SHM_MME : SHM_EXP;
+	slot->n = n;
+	slot->t = t;
+	memcpy(slot->m, m, n / 8);
+	memcpy(slot->g0, g0, n / 8);
+	memcpy(slot->e0, e0, t / 8);
+	if(e1 != NULL){
+		memcpy(slot->g1, g1, n / 8);
+		memcpy(slot->e1, e1, t / 8);
+	}
+
+	ret = MME1536_ShmPost(client, slot);
+	if(ret == 0) ret = MME1536_ShmWait(client, slot);
+	if(ret == 0) memcpy(result, slot->result, n / 8);
+	MME1536_ShmRelease(client, slot);
+
+	return ret;
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** Take posted jobs and retire the jobs the core has finished.
+ *
+ * @return the nr. of jobs that were completed
+ */
+int MME1536_BrokerProgress(MME1536_Broker * broker){
+	int done = 0;
+
+	MME1536_BrokerIntake(broker);
+	if(broker->inflight > 0){
+		MME1536_Poll(broker->dev);
+		done = MME1536_BrokerRetire(broker);
+		// room for more
+		if(done > 0) MME1536_BrokerIntake(broker);
+	}
+
+	return done;
+}
+
+/** Accept a client: create its region and doorbell and send them over the
+ * socket.
+ *
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_BrokerAccept(MME1536_Broker * broker){
+	MME1536_BrokerClient * client = NULL;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr * cmsg;
+	char control[CMSG_SPACE(2 * sizeof(int))];
+	int fd[2];
+	int sock, memfd, i;
+	void * region;
+
+	sock = accept4(broker->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+	if(sock < 0) return -1;
+	for(i=0; i<SHM_MAX_CLIENTS; i++){
+		if(!broker->client[i].active){
+			client = &(broker->client[i]);
+			break;
+		}
+	}
+	if(client == NULL){
+		printf("[WARNING] MME1536: BrokerAccept() -> too many clients, connection refused\n");
+		close(sock);
+		return -1;
+	}
+
+	memfd = memfd_create("mme1536", MFD_CLOEXEC);
+	if((memfd < 0) || (ftruncate(memfd, sizeof(MME1536_ShmRegion)) != 0)){
+		perror("[ERROR] MME1536: BrokerAccept() -> could not create region\n");
+		if(memfd >= 0) close(memfd);
+		close(sock);
+		return -1;
+	}
+	region = mmap(NULL, sizeof(MME1536_ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+	if(region == MAP_FAILED){
+		perror("[ERROR] MME1536: BrokerAccept() -> could not map region\n");
+		close(memfd);
+		close(sock);
+		return -1;
+	}
+
+	memset(client, 0, sizeof(MME1536_BrokerClient));
+	client->sock = sock;
+	client->region = (MME1536_ShmRegion *)region;
+	client->region->magic = SHM_MAGIC;
+	client->region->depth = broker->depth;
+	atomic_init(&(client->region->post_head), 0);
+	atomic_init(&(client->region->post_tail), 0);
+	atomic_init(&(client->region->sleeping), 0);
+	client->doorbell_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(client->doorbell_fd < 0){
+		perror("[ERROR] MME1536: BrokerAccept() -> could not create doorbell\n");
+		munmap(region, sizeof(MME1536_ShmRegion));
+		close(memfd);
+		close(sock);
+		return -1;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &(broker->depth);
+	iov.iov_len = sizeof(broker->depth);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fd));
+	fd[0] = memfd;
+	fd[1] = client->doorbell_fd;
+	memcpy(CMSG_DATA(cmsg), fd, sizeof(fd));
+	i = sendmsg(sock, &msg, MSG_NOSIGNAL);
+	// the mapping keeps the region
+	close(memfd);
+	if(i != sizeof(broker->depth)){
+		perror("[ERROR] MME1536: BrokerAccept() -> could not send region\n");
+		munmap(region, sizeof(MME1536_ShmRegion));
+		close(client->doorbell_fd);
+		close(sock);
+		return -1;
+	}
+	client->active = 1;
+
+	return 0;
+}
+
+/** Free the broker side of a connection (no jobs of the client may be on
+ * the core).
+ */
+void MME1536_BrokerRelease(MME1536_Broker * broker, int index){
+	MME1536_BrokerClient * client = &(broker->client[index]);
+
+	munmap(client->region, sizeof(MME1536_ShmRegion));
+	close(client->doorbell_fd);
+	close(client->sock);
+	client->active = 0;
+}
+
+/** Check whether a client has posted a job the broker didn't take yet.
+ */
+int MME1536_BrokerPending(MME1536_Broker * broker){
+	int i;
+
+	for(i=0; i<SHM_MAX_CLIENTS; i++){
+		MME1536_BrokerClient * client = &(broker->client[i]);
+		if(!client->active || client->closing) continue;
+		if(atomic_load(&(client->region->post_tail)) != atomic_load_explicit(&(client->region->post_head), memory_order_relaxed)){
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void MME1536_BrokerSleeping(MME1536_Broker * broker, int sleeping){
+	int i;
+
+	for(i=0; i<SHM_MAX_CLIENTS; i++){
+		if(broker->client[i].active) atomic_store(&(broker->client[i].region->sleeping), sleeping);
+	}
+}
+
+/** Fill the core up to inflight_max jobs, in rounds that take up to quantum
+ * jobs from each client, starting after the client served last.
+ */
+void MME1536_BrokerIntake(MME1536_Broker * broker){
+	MME1536_BrokerJob * round[SHM_MAX_DEPTH];
+	int room, count, start, i, k;
+	MME1536_BrokerJob * job;
+
+	while((room = broker->inflight_max - broker->inflight) > 0){
+		if(room > SHM_MAX_DEPTH) room = SHM_MAX_DEPTH;
+		count = 0;
+		start = broker->next_client;
+		for(k=0; (k<SHM_MAX_CLIENTS) && (count<room); k++){
+			i = (start + k) % SHM_MAX_CLIENTS;
+			MME1536_BrokerClient * client = &(broker->client[i]);
+			int taken = 0;
+			if(!client->active || client->closing) continue;
+			while((taken < broker->quantum) && (count < room)
+			      && ((job = MME1536_BrokerTake(broker, i)) != NULL)){
+				round[count++] = job;
+				taken++;
+			}
+			// the next round starts after the last client served
+			if(taken > 0) broker->next_client = (i + 1) % SHM_MAX_CLIENTS;
+		}
+		if(count == 0) return;
+
+		MME1536_BrokerOrder(broker, round, count);
+		for(i=0; i<count; i++){
+			MME1536_BrokerSubmit(broker, round[i]);
+		}
+	}
+}
+
+/** Take the next posted job of a client. Posted slots with invalid fields
+ * are finished with an error right away.
+ *
+ * @return the job
+ *         NULL if the client has no posted job
+ */
+MME1536_BrokerJob * MME1536_BrokerTake(MME1536_Broker * broker, int index){
+	MME1536_BrokerClient * client = &(broker->client[index]);
+	MME1536_ShmRegion * region = client->region;
+	unsigned head = atomic_load_explicit(&(region->post_head), memory_order_relaxed);
+	unsigned tail = atomic_load_explicit(&(region->post_tail), memory_order_acquire);
+
+	if(tail - head > SHM_MAX_DEPTH){
+		printf("[WARNING] MME1536: BrokerTake() -> client %d corrupted its ring, disconnected\n", index);
+		client->closing = 1;
+		return NULL;
+	}
+	while(head != tail){
+		unsigned s = region->post[head & (SHM_MAX_DEPTH - 1)];
+		MME1536_ShmSlot * slot;
+		MME1536_BrokerJob * job;
+
+		atomic_store_explicit(&(region->post_head), ++head, memory_order_release);
+		if((s >= (unsigned)broker->depth) || (client->busy_mask & (1ULL << s))){
+			printf("[WARNING] MME1536: BrokerTake() -> client %d posted an invalid slot (%u)\n", index, s);
+			continue;
+		}
+
+		// copy the fields the broker relies on before checking them
+		slot = &(region->slot[s]);
+		job = &(client->job[s]);
+		job->client = index;
+		job->slot = s;
+		job->type = slot->type;
+		job->n = slot->n;
+		job->t = slot->t;
+		if(((job->type != SHM_MME) && (job->type != SHM_EXP))
+		   || ((job->n != BITS_LOW) && (job->n != BITS_HIGH) && (job->n != BITS_TOT))
+		   || (job->t <= 0) || (job->t > SHM_EXP_BITS) || ((job->t%32) != 0)){
+			MME1536_ShmFinish(slot, -1);
+			continue;
+		}
+		// the modulus goes into the modulus cache, which the other clients
+		// use as well: keep a copy the client can't change
+		memcpy(job->m, slot->m, job->n / 8);
+		job->hash = MME1536_ModulusHash(job->m, job->n);
+		client->busy_mask |= 1ULL << s;
+		client->inflight++;
+
+		return job;
+	}
+
+	return NULL;
+}
+
+/** Order the jobs of a round so jobs with the same modulus are next to
+ * each other, starting with the modulus of the last job submitted. Jobs
+ * keep their order otherwise.
+ */
+void MME1536_BrokerOrder(MME1536_Broker * broker, MME1536_BrokerJob ** round, int count){
+	int n = broker->last_n;
+	unsigned int hash = broker->last_hash;
+	int i, j;
+
+	for(i=0; i<count; i++){
+		for(j=i; j<count; j++){
+			if((round[j]->n == n) && (round[j]->hash == hash)) break;
+		}
+		if((j < count) && (j != i)){
+			MME1536_BrokerJob * job = round[j];
+			memmove(&(round[i+1]), &(round[i]), (j - i) * sizeof(MME1536_BrokerJob *));
+			round[i] = job;
+		}
+		n = round[i]->n;
+		hash = round[i]->hash;
+	}
+}
+
+/** Queue a job on the core with the operands and result in the region.
+ */
+void MME1536_BrokerSubmit(MME1536_Broker * broker, MME1536_BrokerJob * job){
+	MME1536_ShmSlot * slot = &(broker->client[job->client].region->slot[job->slot]);
+	int ret;
+
+	if(job->type == SHM_MME){
+		ret = MME1536_SubmitMME(broker->dev, &(job->job), slot->result, slot->g0, slot->g1, job->m, slot->e0, slot->e1, job->n, job->t);
+	}
+	else{
+		ret = MME1536_SubmitMME(broker->dev, &(job->job), slot->result, slot->g0, slot->g0, job->m, slot->e0, NULL, job->n, job->t);
+	}
+	if(ret != 0){
+		MME1536_BrokerFinish(broker, job, -1);
+		return;
+	}
+	broker->last_n = job->n;
+	broker->last_hash = job->hash;
+
+	job->next = NULL;
+	if(broker->inflight_tail != NULL) broker->inflight_tail->next = job;
+	else broker->inflight_head = job;
+	broker->inflight_tail = job;
+	broker->inflight++;
+}
+
+/** Finish the jobs the core is done with.
+ *
+ * @return the nr. of jobs that were completed
+ */
+int MME1536_BrokerRetire(MME1536_Broker * broker){
+	int done = 0;
+
+	while((broker->inflight_head != NULL) && (broker->inflight_head->job.state == JOB_DONE)){
+		MME1536_BrokerJob * job = broker->inflight_head;
+		broker->inflight_head = job->next;
+		if(broker->inflight_head == NULL) broker->inflight_tail = NULL;
+		broker->inflight--;
+		MME1536_BrokerFinish(broker, job, job->job.error);
+		done++;
+	}
+
+	return done;
+}
+
+void MME1536_BrokerFinish(MME1536_Broker * broker, MME1536_BrokerJob * job, int error){
+	MME1536_BrokerClient * client = &(broker->client[job->client]);
+
+	client->busy_mask &= ~(1ULL << job->slot);
+	client->inflight--;
+	client->served++;
+	MME1536_ShmFinish(&(client->region->slot[job->slot]), error);
+}
+
+/** Mark a slot done and wake the client if it waits for it.
+ */
+void MME1536_ShmFinish(MME1536_ShmSlot * slot, int error){
+	slot->error = error;
+	if(atomic_exchange_explicit(&(slot->state), SHM_DONE, memory_order_release) == SHM_WAITING){
+		MME1536_ShmFutex(&(slot->state), FUTEX_WAKE, INT_MAX, NULL);
+	}
+}
+
+/** Futex on a word in a region, shared between processes.
+ */
+int MME1536_ShmFutex(atomic_int * word, int op, int value, const struct timespec * timeout){
+	return syscall(SYS_futex, word, op, value, timeout, NULL, 0);
+}
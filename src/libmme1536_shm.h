@@ -0,0 +1,165 @@
+/** @file libmme1536_shm.h Header file for libmme1536_shm.c
+ * Contains the definitions and function prototypes for sharing one core
+ * between processes.
+ *
+ * MME1536_Initialize() maps /dev/mem and the UIO device, so only one
+ * process can own the core. The broker (see mme1536d.c) is that process:
+ * clients connect to its unix socket and get a shared memory region with
+ * job slots, into which they write their operands. They post a slot
+ * through a lock-free ring in the region and ring an eventfd doorbell when
+ * the broker sleeps; the broker runs the job with the operands and result
+ * in place and marks the slot done on a futex in the region.
+ *
+ * @date 2026/10/14 (last modified)
+ *
+ */
+
+#ifndef _LIBMME1536_SHM_H_
+#define _LIBMME1536_SHM_H_
+
+#include <stdatomic.h>
+
+#include "libmme1536_v1.h"
+
+// default path of the broker socket
+#define SHM_SOCKET_PATH	"/run/mme1536.sock"
+
+// maximum nr. of slots of a client (power of 2, at most 64)
+#define SHM_MAX_DEPTH	64
+
+// maximum length of the exponents of a job (#bits)
+#define SHM_EXP_BITS	2048
+
+// maximum nr. of connected clients
+#define SHM_MAX_CLIENTS	32
+
+// defaults of the broker: slots per client, jobs taken from a client per
+// round and jobs on the core in total
+#define SHM_DEPTH	16
+#define SHM_QUANTUM	2
+#define SHM_INFLIGHT	8
+
+// interval at which a waiting client checks that the broker is still
+// there, and the broker checks its stop flag (ms)
+#define SHM_TICK_MS	1000
+
+// region header check
+#define SHM_MAGIC	0x4d4d4531
+
+// job types
+#define SHM_MME	0 // g0^e0 * g1^e1 mod m
+#define SHM_EXP	1 // g0^e0 mod m
+
+// slot states
+#define SHM_FREE	0
+#define SHM_POSTED	1
+#define SHM_WAITING	2 // the client sleeps on the futex
+#define SHM_DONE	3
+
+/// one job slot, filled in by the client
+typedef struct mme1536_shm_slot_st{
+	/* completion futex: SHM_FREE .. SHM_DONE */
+	atomic_int state;
+	/* 0, or -1 when the job was refused or aborted */
+	int error;
+
+	/* operation */
+	int type;
+	int n, t;
+	int m[WORDS_TOT];
+	int g0[WORDS_TOT];
+	int g1[WORDS_TOT];
+	int e0[SHM_EXP_BITS/32];
+	int e1[SHM_EXP_BITS/32];
+	int result[WORDS_TOT];
+} __attribute__((aligned(64))) MME1536_ShmSlot;
+
+/// the shared memory of one client
+typedef struct mme1536_shm_region_st{
+	unsigned magic;
+	int depth; // nr. of slots the client may use
+
+	/* posted slot indices, single producer (client) and single consumer
+	 * (broker), head and tail count up */
+	atomic_uint post_head __attribute__((aligned(64)));
+	atomic_uint post_tail __attribute__((aligned(64)));
+	unsigned post[SHM_MAX_DEPTH];
+
+	/* set while the broker sleeps, the client then rings the doorbell */
+	atomic_int sleeping;
+
+	MME1536_ShmSlot slot[SHM_MAX_DEPTH];
+} MME1536_ShmRegion;
+
+/// a connection to the broker
+typedef struct mme1536_shm_client_st{
+	int sock;
+	int doorbell_fd;
+	MME1536_ShmRegion * region;
+	/* bit i set: slot i is free */
+	unsigned long long free_mask;
+} MME1536_ShmClient;
+
+/// a job of a client on the core
+typedef struct mme1536_broker_job_st{
+	MME1536_Job job;
+	int client, slot;
+	int type, n, t;
+	int m[WORDS_TOT];
+	unsigned int hash;
+	struct mme1536_broker_job_st * next;
+} MME1536_BrokerJob;
+
+/// broker side of a connection
+typedef struct mme1536_broker_client_st{
+	int active, closing;
+	int sock;
+	int doorbell_fd;
+	MME1536_ShmRegion * region;
+	/* bit i set: slot i is queued or on the core */
+	unsigned long long busy_mask;
+	int inflight;
+	unsigned long served;
+	MME1536_BrokerJob job[SHM_MAX_DEPTH];
+} MME1536_BrokerClient;
+
+/// the broker
+typedef struct mme1536_broker_st{
+	MME1536 * dev;
+	int listen_fd;
+	char path[108];
+	int depth, quantum, inflight_max;
+
+	MME1536_BrokerClient client[SHM_MAX_CLIENTS];
+	int next_client; // first client of the next round
+
+	/* jobs submitted to the core, oldest first */
+	MME1536_BrokerJob * inflight_head;
+	MME1536_BrokerJob * inflight_tail;
+	int inflight;
+	// modulus of the last job submitted
+	int last_n;
+	unsigned int last_hash;
+
+	atomic_int stop;
+} MME1536_Broker;
+
+/** Function prototypes
+ */
+
+int MME1536_BrokerStart(MME1536_Broker * broker, MME1536 * device_instance, const char * path);
+void MME1536_BrokerLimits(MME1536_Broker * broker, int depth, int quantum, int inflight_max);
+int MME1536_BrokerStep(MME1536_Broker * broker, int timeout_ms);
+int MME1536_BrokerRun(MME1536_Broker * broker);
+void MME1536_BrokerStop(MME1536_Broker * broker);
+
+int MME1536_ShmConnect(MME1536_ShmClient * client, const char * path);
+void MME1536_ShmDisconnect(MME1536_ShmClient * client);
+MME1536_ShmSlot * MME1536_ShmAcquire(MME1536_ShmClient * client);
+int MME1536_ShmPost(MME1536_ShmClient * client, MME1536_ShmSlot * slot);
+int MME1536_ShmTest(MME1536_ShmSlot * slot);
+int MME1536_ShmWait(MME1536_ShmClient * client, MME1536_ShmSlot * slot);
+void MME1536_ShmRelease(MME1536_ShmClient * client, MME1536_ShmSlot * slot);
+int MME1536_ShmMME(MME1536_ShmClient * client, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+
+#endif /*_LIBMME1536_SHM_H_*/
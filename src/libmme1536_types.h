@@ -2,24 +2,287 @@
 #define _LIBMME1536_TYPES_H_
 
 
+struct mont_mult1536_st;
+
+/// functions and constants of one operand length (see MME1536_OpsOf())
+typedef struct mme1536_size_ops_st{
+	int n, words, part;
+	int regions; // operand words the length uses (REGION_LOW/REGION_HIGH)
+	int (* set_operand)(struct mont_mult1536_st * device_instance, int * operand_data, int operand);
+	int (* get_operand)(struct mont_mult1536_st * device_instance, int * operand_data, int operand);
+} MME1536_SizeOps;
+
+/// per-modulus precomputed values (see MME1536_UpdateModulus())
+typedef struct mme1536_mont_ctx_st{
+	int valid;
+	unsigned int hash;
+	unsigned long last_used;
+	int n, words, part;
+	const MME1536_SizeOps * ops;
+	int m[1536/32];
+	int R2[1536/32];
+	/* montgomery form of 1 */
+	int R[1536/32];
+} MME1536_MontCtx;
+
+/// a base kept in montgomery form (see MME1536_PinBase_m())
+typedef struct mme1536_pinned_st{
+	/* modulus the base belongs to */
+	unsigned int hash;
+	int n;
+	/* g.R mod m */
+	int mont[1536/32];
+} MME1536_Pinned;
+
+/// a base used with exponents of up to t bits: the montgomery forms of g,
+/// g^(2^h) and g^(1 + 2^h), so an exponentiation is one simultaneous
+/// exponentiation with exponents of h bits (see MME1536_FixedBaseInit_m())
+typedef struct mme1536_fixed_base_st{
+	MME1536_Pinned power[3];
+	int t, h; // maximum exponent length, split point (#bits)
+} MME1536_FixedBase;
+
+/// a result kept in an operand of the core, in montgomery form v.R mod m,
+/// for chained operations (see MME1536_ValueExp_m())
+typedef struct mme1536_value_st{
+	int valid;
+	/* modulus the value belongs to */
+	unsigned int hash;
+	int n;
+	/* operand holding the value, -1 when it only is in data */
+	int operand;
+	/* copy of the value when it had to leave the core */
+	int data[1536/32];
+} MME1536_Value;
+
+/// where a command list puts values: operand, or -1 when read back to
+/// their data (see MME1536_ValueCommit())
+typedef struct mme1536_value_plan_st{
+	int count;
+	MME1536_Value * value[8];
+	int operand[8];
+} MME1536_ValuePlan;
+
+/// the operands of one MME1536_MME() (see MME1536_MMEPair())
+typedef struct mme1536_op_st{
+	int * result;
+	int * g0;
+	int * g1;
+	int * m;
+	int * e0;
+	int * e1;
+	int n, t;
+} MME1536_Op;
+
+/// pre-encoded exponent fifo entries (see MME1536_EncodeExponent())
+typedef struct mme1536_exp_image_st MME1536_ExpImage;
+
+/// instrumentation counters of a handle (see MME1536_GetStats())
+typedef struct mme1536_stats_st{
+	/* operations (command lists and jobs) per length: 512, 1024, 1536 bits */
+	unsigned long ops[3];
+	/* time per phase (ns, see STATS_UPLOAD ..): core operations count from
+	 * their start to their interrupt, so host steps done while the core is
+	 * busy are counted in both */
+	unsigned long long phase_ns[5];
+	/* interrupt waits: time spent spinning and sleeping (ns); operations
+	 * that ran past their wait budget and soft resets of the core */
+	unsigned long waits, timeouts, resets;
+	unsigned long long spin_ns, spin_iterations, sleep_ns;
+	/* latency of operations from submission to result (ns), histogram
+	 * buckets see MME1536_StatsBucketValue() */
+	unsigned long long latency_min_ns, latency_max_ns, latency_sum_ns;
+	unsigned long latency_hist[320];
+} MME1536_Stats;
+
+/// per-handle set of job buffers (see MME1536_ArenaInit())
+typedef struct mme1536_arena_st{
+	/* one cache line aligned block with depth buffers of stride bytes */
+	void * block;
+	int depth, t; // nr. of buffers, exponent bits per buffer
+	size_t stride;
+	/* bit i set: buffer i is free */
+	unsigned long long free_mask;
+} MME1536_Arena;
+
+/// hooks of a backend other than the hardware, e.g. the software model of
+/// the core (see MME1536_InitializeBackend())
+typedef struct mme1536_backend_st{
+	const char * name;
+	/* the start bit was pulsed with this control word */
+	void (* start)(struct mont_mult1536_st * device_instance, unsigned control);
+	/* an entry was written to the exponent fifo */
+	void (* fifo_push)(struct mont_mult1536_st * device_instance, unsigned entry);
+	/* total nr. of interrupts so far (the UIO counter) */
+	int (* read_interrupts)(struct mont_mult1536_st * device_instance);
+	/* soft reset: abandon the operation in progress and empty the fifo */
+	void (* reset)(struct mont_mult1536_st * device_instance);
+	/* free the backend resources (see MME1536_Clean()) */
+	void (* clean)(struct mont_mult1536_st * device_instance);
+} MME1536_Backend;
+
 /// definition of the MME1536 structure
 typedef struct mont_mult1536_st{
+	/* backend: NULL for the core through /dev/mem and UIO, else the hooks
+	 * and state of another backend (see MME1536_InitializeBackend()) */
+	const MME1536_Backend * backend;
+	void * backend_data;
+	
 	/* memory */
 	int data_fd;
 	int ctrl_fd;
 	void * ctrl_ptr;
 	void * data_ptr;
 	char * uio_dev;
+	unsigned long data_base;
+	/* mapping of the data memory (see MME1536_InitializeOpt()) and the
+	 * mapped windows: when the data memory is in the register window
+	 * data_map is NULL */
+	int mapping;
+	size_t ctrl_size, data_size;
+	void * data_map;
+	
+	/* optional DMA channel (see MME1536_DmaAttach()): cdma registers,
+	 * staging buffer and the transfer in flight (dma_busy_bytes = 0 when
+	 * idle) */
+	int dma_fd, dma_buf_fd;
+	void * dma_ptr;
+	void * dma_buf;
+	unsigned long dma_buf_phys;
+	int dma_busy_offset, dma_busy_bytes, dma_busy_keyhole;
 	
-	/* interrupt */
+	/* operand memory transfer path (see MME1536_SetTransferMode()) */
+	int transfer;
+	
+	/* interrupt: the wait budget of a core operation is tv plus
+	 * budget_ns_per_bit for each operand bit of each multiplication, the
+	 * deadline is set when the operation is started (see
+	 * MME1536_SetWaitBudget()) */
 	struct timeval tv;
+	int budget_ns_per_bit;
+	struct timespec deadline;
 	fd_set select_fd;
 	int prev_tot_ints;
+	int wait_mode, spin_us;
+	int start_hold;
+	
+	/* exponent fifo: streamed exponent (raw or encoded) and the next entry
+	 * to write (done when stream_next == stream_count), stream_auto is set
+	 * while an auto-run drains the fifo */
+	int fifo_depth, fifo_streaming;
+	int * stream_e0;
+	int * stream_e1;
+	unsigned * stream_image;
+	int stream_words, stream_next, stream_count;
+	int stream_auto;
+	int exp_entries; // nr. of fifo entries of the exponent for the next auto-run
 	
 	/* data */
-	int * R2;
+	int R2[1536/32];
 	int n, words, part;
+	const MME1536_SizeOps * ops; // operand functions of n (NULL: no modulus)
+	int dirty[5]; // per operand: regions that may hold non-zero data
+	/* per operand: length of the value the host wrote in the low and high
+	 * region, if the core hasn't overwritten it since (0 when unknown), and
+	 * a copy of the operand memory with these values */
+	int res_n[5][2];
+	int res_value[5][1536/32];
+	int split_pipeline;
+	/* per operand: the value kept there, cleared when the host or the core
+	 * writes the operand (see MME1536_ValueExp_m()) */
+	MME1536_Value * holder[5];
+	/* last word written to the control register */
+	unsigned ctrl_shadow;
+	
+	/* modulus cache: context set by UpdateModulus() and context whose
+	 * modulus is in the core (NULL when unknown) */
+	MME1536_MontCtx * ctx_cache;
+	MME1536_MontCtx * ctx;
+	MME1536_MontCtx * loaded_ctx;
+	unsigned long ctx_clock, ctx_hits, ctx_misses;
+	
+	/* asynchronous jobs (head is the one using the core) */
+	struct mme1536_job_st * queue_head;
+	struct mme1536_job_st * queue_tail;
+	
+	/* job buffers */
+	MME1536_Arena arena;
+	
+	/* instrumentation: counters, phase and start time of the core
+	 * operation in flight (stats_phase -1 when none) */
+	int stats_enabled;
+	MME1536_Stats stats;
+	int stats_phase;
+	unsigned long long stats_start_ns;
 } MME1536;
 
+/// maximum nr. of steps in a command list
+#define CMD_LIST_MAX	16
+
+/// one step of a command list (see MME1536_CmdSubmit())
+typedef struct mme1536_cmd_st{
+	int type;
+	/* CMD_SINGLE, CMD_AUTO */
+	int p_sel, destination, x_op, y_op;
+	/* CMD_LOAD, CMD_READ */
+	int * data;
+	int operand, length;
+	const MME1536_SizeOps * ops;
+	/* CMD_EXPONENT */
+	int * e0;
+	int * e1;
+	int t;
+	MME1536_ExpImage * image;
+	/* instrumentation phase of the step (see STATS_UPLOAD ..) */
+	int stats_phase;
+} MME1536_Cmd;
+
+/// a recorded sequence of core operations
+typedef struct mme1536_cmd_list_st{
+	int count;
+	int error; // -1 when a step was rejected (see MME1536_CmdIssue())
+	MME1536_Cmd cmd[CMD_LIST_MAX];
+} MME1536_CmdList;
+
+/// an asynchronous job (see MME1536_SubmitMME())
+typedef struct mme1536_job_st{
+	int state, phase;
+	
+	/* operations of the job and the next one to execute */
+	MME1536_CmdList list;
+	int next;
+	
+	/* modulus of a job queued with m set (NULL for jobs that write their
+	 * own), the current context until the job is done, and R2 of the
+	 * job's modulus */
+	struct mme1536_mont_ctx_st * ctx;
+	int R2[1536/32];
+	
+	/* 0, or -1 when the job was aborted (the core timed out) or a step was
+	 * rejected */
+	int error;
+	
+	/* submission time (ns, only with instrumentation enabled) */
+	unsigned long long submitted_ns;
+	
+	struct mme1536_job_st * next_job;
+} MME1536_Job;
+
+/// buffers for one job, borrowed from the arena of a handle (see
+/// MME1536_ArenaBorrow()), all cache line aligned
+typedef struct mme1536_job_buf_st{
+	int result[1536/32] __attribute__((aligned(64)));
+	int g0[1536/32] __attribute__((aligned(64)));
+	int g1[1536/32] __attribute__((aligned(64)));
+	int m[1536/32] __attribute__((aligned(64)));
+	/* exponents of up to arena.t bits and room to encode them (see
+	 * MME1536_EncodeExponentInto()) */
+	int * e0;
+	int * e1;
+	MME1536_ExpImage * image;
+	MME1536_Job job;
+	int index;
+} MME1536_JobBuf;
+
 #endif /*_LIBMME1536_TYPES_H_*/
 
@@ -22,18 +22,33 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <setjmp.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/time.h>
+#include <sys/select.h>
+#include <time.h>
 #include <errno.h>
-
-#include <gmp.h>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
 
 #include "libmme1536_types.h"
 #include "libmme1536_v1.h"
 
 
+static int zero[WORDS_TOT]={
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0};
+
 static int one[WORDS_TOT]={
 	1,0,0,0,0,0,0,0,
 	0,0,0,0,0,0,0,0,
@@ -42,13 +57,113 @@ static int one[WORDS_TOT]={
 	0,0,0,0,0,0,0,0,
 	0,0,0,0,0,0,0,0};
 
+// memory offset of each operand (OPERAND_0 to MODULUS)
+static const int operand_offsets[5]={
+	OP0_OFFSET, OP1_OFFSET, OP2_OFFSET, OP3_OFFSET, M_OFFSET};
+
+// return point of a transfer probe that faults on the bus
+static sigjmp_buf probe_fault;
+
+/// pre-encoded exponent: fifo entries in the order they are written
+struct mme1536_exp_image_st{
+	int t, entries;
+	int capacity; // nr. of entries there is room for
+	unsigned entry[] __attribute__((aligned(CACHE_LINE)));
+};
+
+// instrumentation switch: a constant 0 when it is compiled out
+#ifdef MME1536_NO_STATS
+#define STATS_ON(device_instance)	0
+#else
+#define STATS_ON(device_instance)	((device_instance)->stats_enabled)
+#endif
+
 /******************************************************************************
  * Low-level Function Prototypes (not to be used outside this file)           *
  ******************************************************************************/
-void MME1536_GetData(MME1536 * device_instance, int * buffer, int offset_start, int operand, int words);
+static inline void MME1536_GetData(MME1536 * device_instance, int * buffer, int offset_start, int operand, const int words);
 void MME1536_ComputeR2(int * R2, int * m, int n);
+void MME1536_ComputePow2(int * result, int * m, int n, int e);
 void MME1536_EnableInterrupt(MME1536 * device_instance);
-void MME1536_SetData(MME1536 * device_instance, int * data, int start_offset, int words);
+static inline void MME1536_SetData(MME1536 * device_instance, int * data, int start_offset, const int words);
+static inline void MME1536_FifoWrite(MME1536 * device_instance, volatile unsigned * fifo, unsigned entry);
+int MME1536_ReadInterrupts(MME1536 * device_instance, int * ints_passed);
+void MME1536_SetDeadline(MME1536 * device_instance, unsigned control);
+long MME1536_TimeLeftUs(struct timespec * deadline);
+void MME1536_TimeAddUs(struct timespec * time, long us);
+void MME1536_PulseStart(MME1536 * device_instance, unsigned control);
+void MME1536_DataBarrier(MME1536 * device_instance);
+int MME1536_UioFindMap(const char * uio_dev, unsigned long addr, unsigned long bytes, unsigned long * map_addr, unsigned long * map_size);
+int MME1536_WaitInterrupt(MME1536 * device_instance);
+void MME1536_RearmInterrupt(MME1536 * device_instance);
+MME1536_Cmd * MME1536_CmdAppend(MME1536_CmdList * list, int type);
+int MME1536_CmdIssue(MME1536 * device_instance, MME1536_CmdList * list, int * next);
+int MME1536_CmdExecute(MME1536 * device_instance, MME1536_Cmd * cmd);
+int MME1536_CmdCheck(MME1536 * device_instance, MME1536_CmdList * list);
+int MME1536_CmdConflicts(MME1536 * device_instance, MME1536_Cmd * running, MME1536_Cmd * cmd);
+void MME1536_CmdHost(MME1536 * device_instance, MME1536_CmdList * list, int * next, MME1536_Cmd * running, int * fifo_owner, int self);
+MME1536_Cmd * MME1536_CmdIssuePair(MME1536 * device_instance, MME1536_CmdList ** list, int * next, int * current, int * fifo_owner, MME1536_Cmd * done);
+int MME1536_CmdPartOf(MME1536_CmdList * list);
+int MME1536_ListMME(MME1536_CmdList * list, int * R2, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+int MME1536_ListExp(MME1536_CmdList * list, int * R2, int * result, int * g, int * m, int * e, int n, int t);
+void MME1536_ListExp_m(MME1536 * device_instance, MME1536_CmdList * list, int * R2, int * result, int * g, int * e, int t);
+void MME1536_ListMultiply_m(MME1536 * device_instance, MME1536_CmdList * list, int * R2, int * result, int * x, int * y);
+void MME1536_JobQueue(MME1536 * device_instance, MME1536_Job * job);
+int MME1536_JobAdvance(MME1536 * device_instance);
+int MME1536_JobIssue(MME1536 * device_instance, MME1536_Job * job);
+void MME1536_JobModulus(MME1536 * device_instance, MME1536_Job * job);
+void MME1536_JobReject(MME1536_Job * job);
+int MME1536_JobAbort(MME1536 * device_instance);
+int MME1536_PartOf(int n);
+const MME1536_SizeOps * MME1536_OpsOf(int n);
+int MME1536_SetOperandLow(MME1536 * device_instance, int * operand_data, int operand);
+int MME1536_SetOperandHigh(MME1536 * device_instance, int * operand_data, int operand);
+int MME1536_SetOperandTot(MME1536 * device_instance, int * operand_data, int operand);
+int MME1536_GetOperandLow(MME1536 * device_instance, int * operand_data, int operand);
+int MME1536_GetOperandHigh(MME1536 * device_instance, int * operand_data, int operand);
+int MME1536_GetOperandTot(MME1536 * device_instance, int * operand_data, int operand);
+int MME1536_MMECtx(MME1536 * device_instance, MME1536_MontCtx * ctx, int * result, int * g0, int * g1, int * e0, int * e1, int t);
+int MME1536_RegionOf(int p_sel);
+void MME1536_Written(MME1536 * device_instance, int operand, int regions);
+MME1536_MontCtx * MME1536_CtxLookup(MME1536 * device_instance, int * m, int n);
+void MME1536_EnsureModulus(MME1536 * device_instance);
+int MME1536_PinnedCheck(MME1536 * device_instance, MME1536_Pinned * base);
+int MME1536_ValueResident(MME1536 * device_instance, MME1536_Value * value);
+int MME1536_ValueCheck(MME1536 * device_instance, MME1536_Value * value);
+int MME1536_ValueFree(MME1536 * device_instance, int avoid, int evict);
+void MME1536_ValueRoom(MME1536 * device_instance, MME1536_CmdList * list, MME1536_ValuePlan * plan, int operand, int * avoid);
+int MME1536_ValueUse(MME1536 * device_instance, MME1536_CmdList * list, MME1536_ValuePlan * plan, MME1536_Value * value, int * avoid);
+void MME1536_ValuePlace(MME1536 * device_instance, MME1536_Value * value, int operand);
+void MME1536_ValueCommit(MME1536 * device_instance, MME1536_ValuePlan * plan);
+void MME1536_WriteWords32(volatile void * to, int * from, int words);
+void MME1536_ReadWords32(int * to, volatile void * from, int words);
+void MME1536_WriteWords64(volatile void * to, int * from, int words);
+void MME1536_ReadWords64(int * to, volatile void * from, int words);
+#ifdef __ARM_NEON
+void MME1536_WriteWordsNeon(volatile void * to, int * from, int words);
+void MME1536_ReadWordsNeon(int * to, volatile void * from, int words);
+#endif
+int MME1536_UseTransfer(MME1536 * device_instance, int mode);
+int MME1536_ProbeTransfer(MME1536 * device_instance, int mode);
+void MME1536_ProbeFault(int signal);
+int MME1536_DmaReadPhys(char * buffer_dev, unsigned long * phys);
+void MME1536_DmaReset(MME1536 * device_instance);
+void MME1536_DmaStart(MME1536 * device_instance, int offset, int bytes, int keyhole);
+void MME1536_DmaClaim(MME1536 * device_instance, int offset, int bytes);
+int MME1536_DmaSync(MME1536 * device_instance);
+int MME1536_FifoBegin(MME1536 * device_instance, int * e0, int * e1, unsigned * image, int entries);
+void MME1536_FifoEncode(unsigned * entry, int * e0, int * e1, int words, int first);
+unsigned MME1536_FifoEntry(MME1536 * device_instance, int k);
+int MME1536_FifoRefill(MME1536 * device_instance);
+void MME1536_FifoCheck(MME1536 * device_instance);
+void MME1536_FifoClearNoPush(MME1536 * device_instance);
+int MME1536_InitState(MME1536 * device_instance);
+size_t MME1536_AlignLine(size_t bytes);
+unsigned long long MME1536_StatsNow(void);
+void MME1536_StatsCoreDone(MME1536 * device_instance);
+void MME1536_StatsRecord(MME1536 * device_instance, int part, unsigned long long latency_ns);
+int MME1536_StatsBucket(unsigned long long ns);
+unsigned long long MME1536_ArenaMask(int depth);
 
 /******************************************************************************
  * API Function Source                                                        *
@@ -64,21 +179,55 @@ void MME1536_SetData(MME1536 * device_instance, int * data, int start_offset, in
  *         1 upon failure
  */
 int MME1536_Initialize(MME1536 * device_instance, char * uio_dev){
-	/* Direct mmap of core's data memory*/
-	device_instance->data_fd=open("/dev/mem",O_RDWR|O_NONBLOCK);
-	if(device_instance->data_fd<1){
-		perror("[ERROR] MME1536: Initialize() -> could not open /dev/mem\n");
-		return -1;
-	}
-	device_instance->data_ptr=mmap(NULL,PAGE_SIZE*6,
-				       PROT_READ|PROT_WRITE,
-				       MAP_SHARED,
-				       device_instance->data_fd,
-				       DATA_BASE_ADDR);
-	if((int)device_instance->data_ptr==-1){
-		perror("[ERROR] MME1536: Initialize() -> could not map data_ptr\n");
-		return -1;
-	}
+	return MME1536_InitializeAt(device_instance, uio_dev, DATA_BASE_ADDR);
+}
+
+/** Initialise a hardware core whose data memory is not at DATA_BASE_ADDR.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable associated with the
+ *        hardware.
+ * @param uio_dev is a string containing the path or the uio device
+ * @param data_base is the physical base address of the core's data memory
+ * 
+ * @return 0 upon success
+ *         1 upon failure
+ */
+int MME1536_InitializeAt(MME1536 * device_instance, char * uio_dev, unsigned long data_base){
+	return MME1536_InitializeOpt(device_instance, uio_dev, data_base, MAPPING_DEVMEM);
+}
+
+/** Initialise a hardware core with a choice of how its data memory is
+ * mapped.
+ * 
+ * MAPPING_DEVMEM maps the data memory through /dev/mem, which needs root.
+ * MAPPING_UIO maps it through the map of the UIO device that holds
+ * data_base (see the maps in UIO_SYSFS), so access to the UIO device is
+ * enough; when that is map 0, the register window already covers the data
+ * memory and both share one mapping. The memory attributes of a UIO map
+ * are those its kernel driver gives it: with the MAPPING_WC flag the
+ * driver assumes the mapping may buffer and merge writes (write-combining
+ * or normal non-cacheable) and drains them before a core operation starts
+ * and before a read.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable associated with the
+ *        hardware.
+ * @param uio_dev is a string containing the path or the uio device
+ * @param data_base is the physical base address of the core's data memory
+ * @param mapping is MAPPING_DEVMEM or MAPPING_UIO, or'ed with MAPPING_WC
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_InitializeOpt(MME1536 * device_instance, char * uio_dev, unsigned long data_base, int mapping){
+	unsigned long map_addr = 0, map_size = 0;
+	int map = -1;
+	
+	device_instance->mapping = mapping;
+	device_instance->data_base = data_base;
+	device_instance->data_fd = -1;
+	device_instance->data_map = NULL;
+	device_instance->data_size = 0;
+	device_instance->ctrl_size = PAGE_SIZE;
 	
 	/* UIO setup*/
 	if(uio_dev == NULL){
@@ -88,59 +237,120 @@ int MME1536_Initialize(MME1536 * device_instance, char * uio_dev){
 	else{
 		device_instance->uio_dev = uio_dev;
 	}
+	if(mapping & MAPPING_UIO){
+		map = MME1536_UioFindMap(device_instance->uio_dev, data_base, PAGE_SIZE*6, &map_addr, &map_size);
+		if(map < 0){
+			printf("[ERROR] MME1536: Initialize() -> no map of %s holds the data memory at 0x%lx\n", device_instance->uio_dev, data_base);
+			return -1;
+		}
+		// the register window is map 0, it then covers the data memory too
+		if(map == 0) device_instance->ctrl_size = map_size;
+	}
 	
 	device_instance->ctrl_fd = open(device_instance->uio_dev, O_RDWR|O_NONBLOCK);
-	if(device_instance->ctrl_fd < 1) {
+	if(device_instance->ctrl_fd < 0) {
 		perror("[ERROR] MME1536: Initialize() -> failed to open UIO device \n");
 		return -1;
 	}
-	device_instance->ctrl_ptr = mmap(NULL, PAGE_SIZE,
+	device_instance->ctrl_ptr = mmap(NULL, device_instance->ctrl_size,
 					 PROT_READ|PROT_WRITE,
 					 MAP_SHARED,
 					 device_instance->ctrl_fd,
 					 0);
-	if(device_instance->ctrl_ptr == 0) {
+	if(device_instance->ctrl_ptr == MAP_FAILED) {
 		printf("[ERROR] MME1536: Initialize() -> failed to mmap the UIO device.\n");
 		goto failed1;
 	}
 	
-	/* Interrupt */
-	// set timeouts
-	device_instance->tv.tv_sec = TIMEOUT_S;
-	device_instance->tv.tv_usec = TIMEOUT_US;
-	// initialise fd_set variable
-	FD_ZERO(&(device_instance->select_fd));
-	FD_SET(device_instance->ctrl_fd, &(device_instance->select_fd));
-	// enable interrupt in the hardware
-	MME1536_EnableInterrupt(device_instance);
-	// Enable uio interrupt
-	int enable = 1;
-	if(write(device_instance->ctrl_fd, &enable, sizeof(int)) == ENOSYS){
-		printf("[ERROR] MME1536: Initialize() -> no interrupt for this device!\n");
-		goto failed2;
-	};
-	// Read nr of ints until now
-	int ints = 0;
-	read(device_instance->ctrl_fd, &ints, sizeof(int));
-	device_instance->prev_tot_ints = ints;
+	/* Data memory */
+	if(map == 0){
+		device_instance->data_ptr = (char *)device_instance->ctrl_ptr + (data_base - map_addr);
+	}
+	else if(map > 0){
+		// UIO selects map i by the mmap offset i pages
+		device_instance->data_size = map_size;
+		device_instance->data_map = mmap(NULL, map_size,
+						 PROT_READ|PROT_WRITE,
+						 MAP_SHARED,
+						 device_instance->ctrl_fd,
+						 map*PAGE_SIZE);
+		if(device_instance->data_map == MAP_FAILED){
+			printf("[ERROR] MME1536: Initialize() -> failed to mmap map %d of the UIO device.\n", map);
+			goto failed2;
+		}
+		device_instance->data_ptr = (char *)device_instance->data_map + (data_base - map_addr);
+	}
+	else{
+		/* Direct mmap of core's data memory*/
+		device_instance->data_fd=open("/dev/mem",O_RDWR|O_NONBLOCK);
+		if(device_instance->data_fd < 0){
+			perror("[ERROR] MME1536: Initialize() -> could not open /dev/mem\n");
+			goto failed2;
+		}
+		device_instance->data_size = PAGE_SIZE*6;
+		device_instance->data_map=mmap(NULL,PAGE_SIZE*6,
+					       PROT_READ|PROT_WRITE,
+					       MAP_SHARED,
+					       device_instance->data_fd,
+					       data_base);
+		if(device_instance->data_map == MAP_FAILED){
+			perror("[ERROR] MME1536: Initialize() -> could not map data_ptr\n");
+			close(device_instance->data_fd);
+			goto failed2;
+		}
+		device_instance->data_ptr = device_instance->data_map;
+	}
 	
-	// Reserve memory for R2
-	device_instance->R2 = (int *)malloc(WORDS_TOT * sizeof(int));
-	if(device_instance->R2 == NULL){
-		printf("[ERROR] MME1536: Initialize() -> could not allocate memory for R2.\n");
-		goto failed2;
+	device_instance->backend = NULL;
+	device_instance->backend_data = NULL;
+	if(MME1536_InitState(device_instance) != 0){
+		goto failed3;
 	}
 	
 	return 0;
 	
+failed3:
+	if(device_instance->data_map != NULL) munmap(device_instance->data_map, device_instance->data_size);
+	if(device_instance->data_fd >= 0) close(device_instance->data_fd);
 failed2:
-	munmap(device_instance->ctrl_ptr, PAGE_SIZE);
+	munmap(device_instance->ctrl_ptr, device_instance->ctrl_size);
 failed1:
 	close(device_instance->ctrl_fd);
 	
 	return -1;
 }
 
+/** Initialise a handle on a backend other than the hardware, e.g. the
+ * software model of the core (see MME1536_EmuInitialize()). The driver
+ * accesses data_ptr and ctrl_ptr as it would the mapped core, waits for
+ * interrupts on fd (readable when one is pending) and leaves the start
+ * bit, the exponent fifo and the interrupt counter to the backend hooks.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ * @param backend is a pointer to the hooks (must stay valid)
+ * @param backend_data is the state of the backend (see backend_data)
+ * @param data_ptr is the data memory (PAGE_SIZE*6 bytes)
+ * @param ctrl_ptr is the register space (PAGE_SIZE bytes)
+ * @param fd is the file descriptor that signals interrupts
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_InitializeBackend(MME1536 * device_instance, const MME1536_Backend * backend, void * backend_data, void * data_ptr, void * ctrl_ptr, int fd){
+	device_instance->backend = backend;
+	device_instance->backend_data = backend_data;
+	device_instance->uio_dev = (char *)backend->name;
+	device_instance->data_fd = -1;
+	device_instance->data_base = 0;
+	device_instance->mapping = MAPPING_DEVMEM;
+	device_instance->data_map = NULL;
+	device_instance->data_ptr = data_ptr;
+	device_instance->ctrl_ptr = ctrl_ptr;
+	device_instance->ctrl_fd = fd;
+	
+	return MME1536_InitState(device_instance);
+}
+
 /** Free memory resources and unmap memory
  * 
  * @param device_instance is a pointer to a MME1536 variable associated with the
@@ -149,12 +359,20 @@ failed1:
  * @return nothing
  */
 void MME1536_Clean(MME1536 * device_instance){
-	free(device_instance->R2);
+	if(device_instance->dma_fd >= 0){
+		MME1536_DmaDetach(device_instance);
+	}
+	free(device_instance->ctx_cache);
+	free(device_instance->arena.block);
 	
-	munmap(device_instance->ctrl_ptr, PAGE_SIZE);
+	if(device_instance->backend != NULL){
+		device_instance->backend->clean(device_instance);
+		return;
+	}
+	if(device_instance->data_map != NULL) munmap(device_instance->data_map, device_instance->data_size);
+	if(device_instance->data_fd >= 0) close(device_instance->data_fd);
+	munmap(device_instance->ctrl_ptr, device_instance->ctrl_size);
 	close(device_instance->ctrl_fd);
-	munmap(device_instance->data_ptr, PAGE_SIZE*6);
-	close(device_instance->data_fd);
 }
 
 /** Start a single montgomery multiplication
@@ -169,21 +387,19 @@ void MME1536_Clean(MME1536 * device_instance){
  * @return nothing
  */
 void MME1536_StartSingle(MME1536 * device_instance, int p_sel, int destination, int x_op, int y_op){
-	// get control register
-	int control = *((unsigned *)(device_instance->ctrl_ptr));
+	// control register (the shadow saves a read over the bus)
+	int control = device_instance->ctrl_shadow;
 	
 	// set al control bits to the correct value
 	control &= 0x003fffff; 
 	control |= (p_sel << P_SEL_BITS) | (destination << DEST_BITS) 
 		 | (x_op << X_OP_BITS) | (y_op << Y_OP_BITS) | 0x00800000;
 	
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
-	// clear start bit
-	control &= 0xff7fffff;
-	usleep(1); // necessary because otherwise the core won't start (we might want to look into this later)
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
+	// the result will be written in the destination
+	MME1536_Written(device_instance, destination, MME1536_RegionOf(p_sel));
+	
+	// pulse the start bit
+	MME1536_PulseStart(device_instance, control);
 }
 
 /** Start a single montgomery multiplication with m set by UpdateModulus()
@@ -196,21 +412,7 @@ void MME1536_StartSingle(MME1536 * device_instance, int p_sel, int destination,
  * @return nothing
  */
 void MME1536_StartSingle_m(MME1536 * device_instance, int destination, int x_op, int y_op){
-	// get control register
-	int control = *((unsigned *)(device_instance->ctrl_ptr));
-	
-	// set al control bits to the correct value
-	control &= 0x003fffff; 
-	control |= (device_instance->part << P_SEL_BITS) | (destination << DEST_BITS) 
-		 | (x_op << X_OP_BITS) | (y_op << Y_OP_BITS) | 0x00800000;
-	
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
-	// clear start bit
-	control &= 0xff7fffff;
-	usleep(1); // necessary because otherwise the core won't start (we might want to look into this later)
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
+	MME1536_StartSingle(device_instance, device_instance->part, destination, x_op, y_op);
 }
 
 /** Start the main computation loop
@@ -225,13 +427,12 @@ void MME1536_StartSingle_m(MME1536 * device_instance, int destination, int x_op,
 void MME1536_StartAuto(MME1536 * device_instance, int p_sel){
 	// set bits start, auto-run and p_sel
 	int control = 0x00c00000 | (p_sel << P_SEL_BITS);
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
-	// clear start bit
-	control &= 0xff7fffff;
-	usleep(1); // necessary because otherwise the core won't start (we might want to look into this later)
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
+	// the result will be written in operand 3
+	MME1536_Written(device_instance, OPERAND_3, MME1536_RegionOf(p_sel));
+	// from now on the fifo drains
+	device_instance->stream_auto = 1;
+	// pulse the start bit
+	MME1536_PulseStart(device_instance, control);
 }
 /** Start the main computation loop with m set by UpdateModulus()
  * 
@@ -241,677 +442,3892 @@ void MME1536_StartAuto(MME1536 * device_instance, int p_sel){
  * @return nothing
  */
 void MME1536_StartAuto_m(MME1536 * device_instance){
-	// set bits start, auto-run and p_sel
-	int control = 0x00c00000 | (device_instance->part << P_SEL_BITS);
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
-	// clear start bit
-	control &= 0xff7fffff;
-	usleep(1); // necessary because otherwise the core won't start (we might want to look into this later)
-	// write control register
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
+	MME1536_StartAuto(device_instance, device_instance->part);
 }
 
-/** Do a single multiplication with m set
+/** Set the length of the start bit pulse.
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
- * @param result is pointer to a buffer where the result will be stored
- * @param x,y the multiplicands
- * 
- * @warning only works when MME1536_UpdateModulus() has been called previously
- */
-void MME1536_Multiply_m(MME1536 * device_instance, int * result, int * x, int * y){
-	// write x and y to hardware
-	MME1536_SetOperand_m(device_instance, x, OPERAND_0);	
-	MME1536_SetOperand_m(device_instance, y, OPERAND_1);
-	MME1536_SetOperand_m(device_instance, device_instance->R2, OPERAND_2);
-	
-	// do the multiplication
-	MME1536_StartSingle_m(device_instance, OPERAND_3, OPERAND_0, OPERAND_1); //(x.y).R^(-1)
-	MME1536_WaitUntilReady(device_instance);
-	MME1536_StartSingle_m(device_instance, OPERAND_3, OPERAND_2, OPERAND_3); //(x.y.R^(-1).R^2).R^(-1)
-	MME1536_WaitUntilReady(device_instance);
-	
-	// get the result
-	MME1536_GetOperand_m(device_instance, result, OPERAND_3);
-}
-
-/** Do a modular exponentiation with m set
- * 
+ * @param cycles is the nr. of control register read-backs between setting
+ *        and clearing the start bit, or START_HOLD_USLEEP to fall back to
+ *        the old usleep(1) handshake
  * 
- * @warning not tested!
+ * @return 0 upon success
+ *         -1 upon failure
  */
-void MME1536_Exp_m(MME1536 * device_instance, int * result, int * g, int * e, int t){
-	// write operands to hardware
-	MME1536_SetOperand_m(device_instance, g, OPERAND_0);	
-	MME1536_SetOperand_m(device_instance, device_instance->R2, OPERAND_1);
-	MME1536_SetOperand_m(device_instance, one, OPERAND_2);
-	
-	// compute gt0
-	MME1536_StartSingle_m(device_instance,OPERAND_0,OPERAND_0,OPERAND_1);	
-	MME1536_WaitUntilReady(device_instance);
-	// compute R
-	MME1536_StartSingle_m(device_instance,OPERAND_3,OPERAND_2,OPERAND_1);	
-	MME1536_WaitUntilReady(device_instance);
-	
-	/* Main computation */
-	// set exponent bits
-	MME1536_SetExponent(device_instance, e , NULL, t);
-	// start core in auto mode
-	MME1536_StartAuto_m(device_instance);
-	MME1536_WaitUntilReady(device_instance);
+int MME1536_SetStartHold(MME1536 * device_instance, int cycles){
+	if(cycles < START_HOLD_USLEEP){
+		printf("[ERROR] MME1536: SetStartHold() -> wrong hold time (%d)\n", cycles);
+		return -1;
+	}
+	device_instance->start_hold = cycles;
 	
-	/* Postcomputation */
-	MME1536_StartSingle_m(device_instance,OPERAND_3,OPERAND_2,OPERAND_3);
-	MME1536_WaitUntilReady(device_instance);
-
-	MME1536_GetOperand_m(device_instance,result,OPERAND_3);
+	return 0;
 }
 
-/** Set a new modulus to be used by the hardware
+/** Select how operands are moved between the host and the core's memory.
+ * The 64-bit and NEON paths halve (or quarter) the nr. of bus transactions,
+ * but only work if the core's memory accepts wide accesses. Before a path
+ * is used it is checked by writing and reading back a test pattern in
+ * operand 0, so this must only be called while operand 0 holds no data.
+ * MME1536_Initialize() selects the widest working path (TRANSFER_AUTO).
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
- * @param m is an array containing the modulus
- * @param n is the length of the modulus in bits
+ * @param mode is TRANSFER_32, TRANSFER_64, TRANSFER_NEON or TRANSFER_AUTO
  * 
- * @return nothing
+ * @return 0 upon success
+ *         -1 upon failure (the current path is kept)
  */
-void MME1536_UpdateModulus(MME1536 * device_instance, int * m, int n){
-	switch(n){
-		case BITS_LOW:{
-			device_instance->part = LOW_PART;
-		} break;
-		case BITS_HIGH:{
-			device_instance->part = HIGH_PART;
-		} break;
-		case BITS_TOT:{
-			device_instance->part = TOT_PIPELINE;
-		} break;
-		default:{
-			printf("[ERROR] MME1536: UpdataModulus() -> wrong modulus length: %d\n", n);
-		} break;
+int MME1536_SetTransferMode(MME1536 * device_instance, int mode){
+	if(mode < TRANSFER_AUTO || mode > TRANSFER_NEON){
+		printf("[ERROR] MME1536: SetTransferMode() -> wrong transfer mode (%d)\n", mode);
+		return -1;
 	}
 	
-	device_instance->n = n;
-	device_instance->words = n / 32;
+	// the probe overwrites operand 0, finish queued jobs first
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
 	
-	int i;
-	for(i=0; i<WORDS_TOT; i++){
-		device_instance->R2[i] = 0x00000000;
+	if(mode == TRANSFER_AUTO){
+		for(mode=TRANSFER_NEON; mode>TRANSFER_32; mode--){
+			if(MME1536_ProbeTransfer(device_instance, mode) == 0){
+				return 0;
+			}
+		}
+		return MME1536_UseTransfer(device_instance, TRANSFER_32);
 	}
 	
-	MME1536_ComputeR2(device_instance->R2, m, n);
+	if(MME1536_ProbeTransfer(device_instance, mode) != 0){
+		printf("[ERROR] MME1536: SetTransferMode() -> transfer mode %d not supported\n", mode);
+		return -1;
+	}
 	
-	MME1536_SetOperand(device_instance, m, MODULUS, n);
+	return 0;
 }
 
-/** Compute g0^e0 * g1^e1 mod m (with m set by UpdateModulus)
+/** Get the operand memory transfer path in use.
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
- * @param result is a pointer to the buffer where the result will be stored
- * @param g0, g1, e0, e1 are arrays containing the bases and exponents
- * @param t is the length of the exponents (#bits)
  * 
- * @return nothing
+ * @return TRANSFER_32, TRANSFER_64 or TRANSFER_NEON
  */
-void MME1536_MME_m(MME1536 * device_instance, int * result, int * g0, int * g1, int * e0, int * e1, int t){
-	// write operands to hardware
-	MME1536_SetOperand_m(device_instance, g0, OPERAND_0);	
-	MME1536_SetOperand_m(device_instance, g1, OPERAND_1);
-	MME1536_SetOperand_m(device_instance, one, OPERAND_2);
-	MME1536_SetOperand_m(device_instance, device_instance->R2, OPERAND_3);
-
-	// compute gt0
-	MME1536_StartSingle_m(device_instance,OPERAND_0,OPERAND_0,OPERAND_3);	
-	MME1536_WaitUntilReady(device_instance);
-	// compute gt1
-	MME1536_StartSingle_m(device_instance,OPERAND_1,OPERAND_1,OPERAND_3);	
-	MME1536_WaitUntilReady(device_instance);
-	// compute R
-	MME1536_StartSingle_m(device_instance,OPERAND_3,OPERAND_2,OPERAND_3);	
-	MME1536_WaitUntilReady(device_instance);
-	// compute gt01
-	MME1536_StartSingle_m(device_instance,OPERAND_2,OPERAND_0,OPERAND_1);	
-	MME1536_WaitUntilReady(device_instance);
-	
-	/* Main computation */
-	// set exponent bits
-	MME1536_SetExponent(device_instance, e0 , e1, t);
-	// start core in auto mode
-	MME1536_StartAuto_m(device_instance);
-	MME1536_WaitUntilReady(device_instance);
-	
-	/* Postcomputation */
-	// write '1'
-	MME1536_SetOperand_m(device_instance, one, OPERAND_2);
-	MME1536_StartSingle_m(device_instance,OPERAND_3,OPERAND_2,OPERAND_3);
-	MME1536_WaitUntilReady(device_instance);
-
-	MME1536_GetOperand_m(device_instance,result,OPERAND_3);
+int MME1536_GetTransferMode(MME1536 * device_instance){
+	return device_instance->transfer;
 }
 
-/** Compute g0^e0 * g1^e1 mod m
+/** Let an AXI CDMA move operands and exponents into the core's memory.
+ * The library fills a physically contiguous staging buffer (an image of
+ * the core's data memory) from the caller's arrays and starts a transfer
+ * from it, so the cpu writes normal memory instead of the bus and can go
+ * on while the transfer runs. The transfer is waited for before the core
+ * is started or read. Short transfers (< DMA_MIN_WORDS) and transfers that
+ * fail are written by the cpu, as without a DMA channel.
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
- * @param result is a pointer to the buffer where the result will be stored
- * @param g0, g1, e0, e1, m are arrays containing the bases and exponents
- * @param n is the lenght of g0, g1 and m (#bits)
- * @param t is the length of the exponents (#bits)
+ * @param dma_uio_dev is the UIO device of the CDMA controller (simple mode;
+ *        operand memory and fifo reachable from its master port)
+ * @param buffer_dev is a u-dma-buf device (e.g. "/dev/udmabuf0") of at
+ *        least DMA_BUF_SIZE bytes
  * 
- * @return nothing
+ * @return 0 upon success
+ *         -1 upon failure (the cpu keeps writing all data)
  */
-void MME1536_MME(MME1536 * device_instance, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
-	int part = 0;
-	switch(n){
-		case BITS_LOW:{
-			part = LOW_PART;
-		} break;
-		case BITS_HIGH:{
-			part = HIGH_PART;
-		} break;
-		case BITS_TOT:{
-			part = TOT_PIPELINE;
-		} break;
-		default:{
-			printf("[ERROR] MME1536: MME() -> wrong operand length: %d\n", n);
-		} break;
+int MME1536_DmaAttach(MME1536 * device_instance, char * dma_uio_dev, char * buffer_dev){
+	if(device_instance->backend != NULL){
+		printf("[ERROR] MME1536: DmaAttach() -> no DMA channel on the %s backend\n", device_instance->backend->name);
+		return -1;
+	}
+	if(device_instance->dma_fd >= 0){
+		MME1536_DmaDetach(device_instance);
 	}
 	
-	// allocate space for R2
-	int * R2;
-	R2 = (int *) malloc(n/8);
+	if(MME1536_DmaReadPhys(buffer_dev, &(device_instance->dma_buf_phys)) != 0){
+		printf("[ERROR] MME1536: DmaAttach() -> no physical address for %s\n", buffer_dev);
+		return -1;
+	}
 	
-	/* Precomputation */
-	// compute R2
-	MME1536_ComputeR2(R2, m, n); 
+	device_instance->dma_buf_fd = open(buffer_dev, O_RDWR|O_SYNC);
+	if(device_instance->dma_buf_fd < 0){
+		perror("[ERROR] MME1536: DmaAttach() -> could not open the DMA buffer\n");
+		return -1;
+	}
+	device_instance->dma_buf = mmap(NULL, DMA_BUF_SIZE,
+					PROT_READ|PROT_WRITE,
+					MAP_SHARED,
+					device_instance->dma_buf_fd,
+					0);
+	if(device_instance->dma_buf == MAP_FAILED){
+		printf("[ERROR] MME1536: DmaAttach() -> failed to mmap the DMA buffer.\n");
+		goto failed1;
+	}
 	
-	// write modulus to hardware
-	MME1536_SetOperand(device_instance, m, MODULUS, n);	
+	int dma_fd = open(dma_uio_dev, O_RDWR);
+	if(dma_fd < 0){
+		perror("[ERROR] MME1536: DmaAttach() -> failed to open the CDMA UIO device\n");
+		goto failed2;
+	}
+	device_instance->dma_ptr = mmap(NULL, PAGE_SIZE,
+					PROT_READ|PROT_WRITE,
+					MAP_SHARED,
+					dma_fd,
+					0);
+	if(device_instance->dma_ptr == MAP_FAILED){
+		printf("[ERROR] MME1536: DmaAttach() -> failed to mmap the CDMA UIO device.\n");
+		close(dma_fd);
+		goto failed2;
+	}
 	
-	// write operands to hardware
-	MME1536_SetOperand(device_instance, g0, OPERAND_0, n);	
-	MME1536_SetOperand(device_instance, g1, OPERAND_1, n);
-	MME1536_SetOperand(device_instance, one, OPERAND_2, n);
-	MME1536_SetOperand(device_instance, R2, OPERAND_3, n);
-
-	// compute gt0
-	MME1536_StartSingle(device_instance,part,OPERAND_0,OPERAND_0,OPERAND_3);	
-	MME1536_WaitUntilReady(device_instance);
-	// compute gt1
-	MME1536_StartSingle(device_instance,part,OPERAND_1,OPERAND_1,OPERAND_3);	
-	MME1536_WaitUntilReady(device_instance);
-	// compute R
-	MME1536_StartSingle(device_instance,part,OPERAND_3,OPERAND_2,OPERAND_3);	
-	MME1536_WaitUntilReady(device_instance);
-	// compute gt01
-	MME1536_StartSingle(device_instance,part,OPERAND_2,OPERAND_0,OPERAND_1);	
-	MME1536_WaitUntilReady(device_instance);
+	device_instance->dma_fd = dma_fd;
+	device_instance->dma_busy_bytes = 0;
+	MME1536_DmaReset(device_instance);
 	
-	/* Main computation */
-	// set exponent bits
-	MME1536_SetExponent(device_instance, e0 , e1, t);
-	// start core in auto mode
-	MME1536_StartAuto(device_instance, part);
-	MME1536_WaitUntilReady(device_instance);
+	return 0;
 	
-	/* Postcomputation */
-	// write '1'
-	MME1536_SetOperand(device_instance, one, OPERAND_2, n);
-	MME1536_StartSingle(device_instance,part,OPERAND_3,OPERAND_2,OPERAND_3);
-	MME1536_WaitUntilReady(device_instance);
-
-	MME1536_GetOperand(device_instance,result,OPERAND_3,n);
-
-	/* Cleanup */
-	free(R2);
+failed2:
+	munmap(device_instance->dma_buf, DMA_BUF_SIZE);
+failed1:
+	close(device_instance->dma_buf_fd);
+	
+	return -1;
 }
 
-/** Wait until the core has completed it's operation (interrupt)
+/** Stop using the DMA channel (the cpu writes all data again).
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
  * 
  * @return nothing
  */
-void MME1536_WaitUntilReady(MME1536 * device_instance){
-	int ints_passed = -1;
-	struct timeval time;
-	int timeout, current_time;
-	gettimeofday(&time,NULL);
-	timeout = (int)time.tv_usec + TIMEOUT_US;
-	current_time = (int)time.tv_usec;
-	// wait for an interrupt (poll flag)
-	while(ints_passed <= device_instance->prev_tot_ints){
-		read(device_instance->ctrl_fd, &ints_passed, sizeof(int));
-		gettimeofday(&time,NULL);
-		current_time = (int)time.tv_usec;
-		if(current_time >= timeout){
-			printf("[WARNING] MME1536: WaitUntilReady() -> Timeout!\n");
-			break;
-		}
-		
+void MME1536_DmaDetach(MME1536 * device_instance){
+	if(device_instance->dma_fd < 0){
+		return;
 	}
-	// update the nr of interrupts
-	device_instance->prev_tot_ints = ints_passed;
+	MME1536_DmaSync(device_instance);
 	
-	// enable interrupts again
-	int enable = 1;
-	write(device_instance->ctrl_fd, &enable, sizeof(int));
+	munmap(device_instance->dma_ptr, PAGE_SIZE);
+	close(device_instance->dma_fd);
+	munmap(device_instance->dma_buf, DMA_BUF_SIZE);
+	close(device_instance->dma_buf_fd);
+	device_instance->dma_fd = -1;
 }
 
-/** Write exponents to the exponent fifo.
+/** Clear a command list.
  * 
- * @param device_instance is a pointer to a MME1536 variable
- *        associated with the hardware.
- * @param e0, e1 are arrays containing the exponents
- * @param t is the nr of bits in the exponent
- * @todo check when fifo is full
+ * @param list is a pointer to the command list
  * 
  * @return nothing
  */
-void MME1536_SetExponent(MME1536 * device_instance, int * e0, int * e1, int t){
-	int temp = 0;
-	int i, words;
-	
-	if((t%32)!=0){
-		printf("[ERROR] MME1536: SetExponent() -> exponent length %d, is no multiple of 32.\n", t);
-		return;
-	}
-	words = t/32;
-	
-	// create fifo entries and write to fifo
-	for(i=(words-1); i>=0; i--){
-		if(e1==NULL) temp = ((e0[i] & 0xffff0000) >> 16);
-		else temp = (e1[i] & 0xffff0000) | ((e0[i] & 0xffff0000) >> 16);
-		*((unsigned *)(device_instance->data_ptr + FIFO_OFFSET)) = temp;
-		//usleep(1);
-		//printf("e: %08x\n", temp);
-		
-		if(e1==NULL) temp = (e0[i] & 0x0000ffff);
-		else temp = ((e1[i] & 0x0000ffff) << 16) | (e0[i] & 0x0000ffff);
-		*((unsigned *)(device_instance->data_ptr + FIFO_OFFSET)) = temp;
-		
-		//printf("e: %08x\n", temp);
-	}
-	
+void MME1536_CmdInit(MME1536_CmdList * list){
+	list->count = 0;
+	list->error = 0;
 }
 
-/** Write an operand to the core's memory
- * 
- * @param device_instance is a pointer to a MME1536 variable
- *        associated with the hardware.
- * @param operand_data is an array containing the operand
- * @param operand sets the memory location where the operand data will be
- *        stored (OPERAND_0 to OPERAND_3).
- * @param length is the nr of elements in operand_data
+/** Append a single montgomery multiplication to a command list
+ * (see MME1536_StartSingle()).
  * 
- * @return nothing
+ * @return 0 upon success
+ *         -1 when the list is full
  */
-int MME1536_SetOperand(MME1536 * device_instance, int * operand_data, int operand, int length){
-	int address_offset;
-	int word;
-	int zeros[WORDS_TOT]={
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0};
-	int * data;
-	
-	switch(operand){
-		case OPERAND_0:{
-			address_offset = OP0_OFFSET;
-		} break;
-		case OPERAND_1:{
-			address_offset = OP1_OFFSET;
-		} break;
-		case OPERAND_2:{
-			address_offset = OP2_OFFSET;
-		} break;
-		case OPERAND_3:{
-			address_offset = OP3_OFFSET;
-		} break;
-		case MODULUS:{
-			address_offset = M_OFFSET;
-		} break;
-		default:{
-			printf("[ERROR] MME1536: SetOperand() -> wrong operand (%d)\n", operand);
-			return -1;
-		} break;
-	}
+int MME1536_CmdSingle(MME1536_CmdList * list, int p_sel, int destination, int x_op, int y_op){
+	MME1536_Cmd * cmd = MME1536_CmdAppend(list, CMD_SINGLE);
+	if(cmd == NULL) return -1;
 	
-	switch(length){
-		case BITS_LOW: {
-			// store data in lower part (rest is zero)
-			for(word=0;word<WORDS_LOW;word++){
-				zeros[word] = operand_data[word];
-				data = zeros;
-			}
-		} break;
-		case BITS_HIGH: {
-			// store data in higher part (rest is zero)
-			for(word=0;word<WORDS_HIGH;word++){
-				zeros[word+WORDS_LOW] = operand_data[word];
-				data = zeros;
-			}
-		} break;
-		case BITS_TOT: {
-			data = operand_data;
-		} break;
-		default: {
-			printf("[ERROR] MME1536: SetOperand() -> wrong operand length (%d)\n", length);
-			return -1;
-		} break;
-	}
-	// write data
-	MME1536_SetData(device_instance, data, address_offset, WORDS_TOT);
+	cmd->p_sel = p_sel;
+	cmd->destination = destination;
+	cmd->x_op = x_op;
+	cmd->y_op = y_op;
 	
 	return 0;
 }
 
-/** Write an operand to the core's memory (length defined by m which was
- * previously set in UpdateModulus()
+/** Append a run of the main computation loop to a command list
+ * (see MME1536_StartAuto()).
  * 
- * @param device_instance is a pointer to a MME1536 variable
- *        associated with the hardware.
- * @param operand sets the memory location where the operand data will be
- *        stored (OPERAND_0 to OPERAND_3).
- * @param operand_data is an array containing the operand
+ * @return 0 upon success
+ *         -1 when the list is full
+ */
+int MME1536_CmdAuto(MME1536_CmdList * list, int p_sel){
+	MME1536_Cmd * cmd = MME1536_CmdAppend(list, CMD_AUTO);
+	if(cmd == NULL) return -1;
+	
+	cmd->p_sel = p_sel;
+	
+	return 0;
+}
+
+/** Append an operand upload to a command list (see MME1536_SetOperand()).
+ * The data is not copied, so the buffer must stay valid until the list has
+ * been submitted.
  * 
- * @return nothing
+ * @return 0 upon success
+ *         -1 for a wrong length or when the list is full
  */
-int MME1536_SetOperand_m(MME1536 * device_instance, int * operand_data, int operand){
-	int address_offset;
-	int word;
-	int zeros[WORDS_TOT]={
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0};
-	int * data;
-	
-	switch(operand){
-		case OPERAND_0:{
-			address_offset = OP0_OFFSET;
-		} break;
-		case OPERAND_1:{
-			address_offset = OP1_OFFSET;
-		} break;
-		case OPERAND_2:{
-			address_offset = OP2_OFFSET;
-		} break;
-		case OPERAND_3:{
-			address_offset = OP3_OFFSET;
-		} break;
-		case MODULUS:{
-			address_offset = M_OFFSET;
-		} break;
-		default:{
-			printf("[ERROR] MME1536: SetOperand_m() -> wrong operand (%d)\n", operand);
-			return -1;
-		} break;
-	}
+int MME1536_CmdLoad(MME1536_CmdList * list, int * data, int operand, int length){
+	const MME1536_SizeOps * ops = MME1536_OpsOf(length);
+	MME1536_Cmd * cmd;
 	
-	switch(device_instance->n){
-		case BITS_LOW: {
-			// store data in lower part (rest is zero)
-			for(word=0;word<WORDS_LOW;word++){
-				zeros[word] = operand_data[word];
-				data = zeros;
-			}
-		} break;
-		case BITS_HIGH: {
-			// store data in higher part (rest is zero)
-			for(word=0;word<WORDS_HIGH;word++){
-				zeros[word+WORDS_LOW] = operand_data[word];
-				data = zeros;
-			}
-		} break;
-		case BITS_TOT: {
-			data = operand_data;
-		} break;
-		default: {
-			printf("[ERROR] MME1536: SetOperand_m() -> wrong operand length (%d)\n", device_instance->n);
-			return -1;
-		} break;
+	if(ops == NULL){
+		printf("[ERROR] MME1536: CmdLoad() -> wrong operand length (%d)\n", length);
+		return -1;
 	}
-	// write data
-	MME1536_SetData(device_instance, data, address_offset, WORDS_TOT);
+	cmd = MME1536_CmdAppend(list, CMD_LOAD);
+	if(cmd == NULL) return -1;
+	
+	cmd->data = data;
+	cmd->operand = operand;
+	cmd->length = length;
+	cmd->ops = ops;
 	
 	return 0;
 }
 
-/** Print some info about the hardware.
+/** Append an exponent upload to a command list (see MME1536_SetExponent()).
  * 
- * @param device_instance is a pointer to a MME1536 variable
- *        associated with the hardware.
+ * @return 0 upon success
+ *         -1 when the list is full
+ */
+int MME1536_CmdExponent(MME1536_CmdList * list, int * e0, int * e1, int t){
+	MME1536_Cmd * cmd = MME1536_CmdAppend(list, CMD_EXPONENT);
+	if(cmd == NULL) return -1;
+	
+	cmd->e0 = e0;
+	cmd->e1 = e1;
+	cmd->t = t;
+	cmd->image = NULL;
+	
+	return 0;
+}
+
+/** Append the upload of a pre-encoded exponent to a command list (see
+ * MME1536_SetExponentImage()).
  * 
- * @return nothing
+ * @return 0 upon success
+ *         -1 when the list is full
+ */
+int MME1536_CmdExponentImage(MME1536_CmdList * list, MME1536_ExpImage * image){
+	MME1536_Cmd * cmd = MME1536_CmdAppend(list, CMD_EXPONENT);
+	if(cmd == NULL) return -1;
+	
+	cmd->image = image;
+	
+	return 0;
+}
+
+/** Append an operand read-back to a command list (see MME1536_GetOperand()).
  * 
+ * @return 0 upon success
+ *         -1 for a wrong length or when the list is full
  */
-void MME1536_PrintInfo(MME1536 * device_instance){
-	printf("[INFO] MME1536: Hardware info\n");
+int MME1536_CmdRead(MME1536_CmdList * list, int * data, int operand, int length){
+	const MME1536_SizeOps * ops = MME1536_OpsOf(length);
+	MME1536_Cmd * cmd;
 	
-	printf(" Addres map:\n");
+	if(ops == NULL){
+		printf("[ERROR] MME1536: CmdRead() -> wrong operand length (%d)\n", length);
+		return -1;
+	}
+	cmd = MME1536_CmdAppend(list, CMD_READ);
+	if(cmd == NULL) return -1;
 	
-	printf("  op0: 0x%08x\n", device_instance->data_ptr + OP0_OFFSET);
-	printf("  op1: 0x%08x\n", device_instance->data_ptr + OP1_OFFSET);
-	printf("  op2: 0x%08x\n", device_instance->data_ptr + OP2_OFFSET);
-	printf("  op3: 0x%08x\n", device_instance->data_ptr + OP3_OFFSET);
-	printf("  m:   0x%08x\n", device_instance->data_ptr + M_OFFSET);
-	printf("  exp: 0x%08x\n", device_instance->data_ptr + FIFO_OFFSET);
+	cmd->data = data;
+	cmd->operand = operand;
+	cmd->length = length;
+	cmd->ops = ops;
 	
-	printf(" Pipeline info:\n");
-	printf("  total nr. words:     %d\n", WORDS_TOT);
-	printf("  low part nr. words:  %d\n", WORDS_LOW);
-	printf("  high part nr. words: %d\n", WORDS_HIGH);
-	printf("  upper part offset: 0x%08x\n", HIGH_OFFSET);
+	return 0;
 }
 
-/** Read the core's operand memory and send to standard out.
- *  (Debugging purposes only).
+/** Execute a command list on the core.
+ * 
+ * Each core operation is started as soon as the interrupt of the previous
+ * one has been seen; the UIO interrupt is only re-enabled after that, while
+ * the core is already busy. Operand and exponent uploads that directly
+ * follow a core operation and don't touch the operands it uses are done
+ * while it runs instead of after it.
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
+ * @param list is a pointer to the command list
  * 
- * @return nothing
- * 
+ * @return 0 upon success
+ *         -1 if the core timed out (it is reset and the rest of the list
+ *         is not executed), or an exponent is no multiple of 32 bits or,
+ *         without fifo streaming, doesn't fit the fifo (nothing is executed)
  */
-void MME1536_PrintOperands(MME1536 * device_instance){
-	int data[WORDS_TOT];
-	int word;
+int MME1536_CmdSubmit(MME1536 * device_instance, MME1536_CmdList * list){
+	int next = 0;
+	int running;
+	unsigned long long start_ns = 0;
 	
-	MME1536_GetData(device_instance, data, OP0_OFFSET, OPERAND_0, WORDS_TOT);
-	printf("OP0: ");
-	for(word=0;word<WORDS_TOT;word++){
-		printf("%08x", data[WORDS_TOT-1-word]);
-	}
-	printf("\n");
+	if(MME1536_CmdCheck(device_instance, list) != 0) return -1;
 	
-	MME1536_GetData(device_instance, data, OP1_OFFSET, OPERAND_1, WORDS_TOT);
-	printf("OP1: ");
-	for(word=0;word<WORDS_TOT;word++){
-		printf("%08x", data[WORDS_TOT-1-word]);
+	// the core is shared with asynchronous jobs, finish those first, they
+	// may have left another modulus
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+		MME1536_EnsureModulus(device_instance);
 	}
-	printf("\n");
 	
-	MME1536_GetData(device_instance, data, OP2_OFFSET, OPERAND_2, WORDS_TOT);
-	printf("OP2: ");
-	for(word=0;word<WORDS_TOT;word++){
-		printf("%08x", data[WORDS_TOT-1-word]);
+	if(STATS_ON(device_instance)) start_ns = MME1536_StatsNow();
+	running = MME1536_CmdIssue(device_instance, list, &next);
+	while(running){
+		if(MME1536_WaitInterrupt(device_instance) != 0) return -1;
+		running = MME1536_CmdIssue(device_instance, list, &next);
+		MME1536_RearmInterrupt(device_instance);
 	}
-	printf("\n");
-	
-	MME1536_GetData(device_instance, data, OP3_OFFSET, OPERAND_3, WORDS_TOT);
-	printf("OP3: ");
-	for(word=0;word<WORDS_TOT;word++){
-		printf("%08x", data[WORDS_TOT-1-word]);
+	if(STATS_ON(device_instance)){
+		MME1536_StatsRecord(device_instance, MME1536_CmdPartOf(list), MME1536_StatsNow() - start_ns);
 	}
-	printf("\n");
+	
+	return list->error;
 }
 
-/** Read an operand from the core's memory.
+/** Execute two command lists together, one on each pipeline part (see
+ * MME1536_SetSplitPipeline()).
+ * 
+ * The core runs one operation at a time, but while an operation of one
+ * list runs, the operand uploads of the other list are done, so neither
+ * list waits for the host. Core operations of the lists take turns and
+ * an exponent is written only when the fifo holds none of the other list.
+ * Lists that don't use one pipeline part each (LOW_PART and HIGH_PART), or
+ * a device not in split pipeline mode, are executed one after the other.
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
- * @param operand_data is a pointer to a buffer where the operand will
- *        be stored.
- * @param operand specifies the operand to read from the memory
- *        (OPERAND_0 to OPERAND_3)
- * @param length is the length op the operand (#bits)
+ * @param list0, list1 are pointers to the command lists
  * 
- * @return nothing
+ * @return 0 upon success
+ *         -1 if the lists could not be completed or the core timed out
  */
-int MME1536_GetOperand(MME1536 * device_instance, int * operand_data, int operand, int length){
-	int address_offset;
-	int words;
+int MME1536_CmdSubmitPair(MME1536 * device_instance, MME1536_CmdList * list0, MME1536_CmdList * list1){
+	MME1536_CmdList * list[2];
+	MME1536_Cmd * running;
+	int next[2] = {0, 0};
+	int current = 1;
+	int fifo_owner = -1;
+	int part0 = MME1536_CmdPartOf(list0);
+	int part1 = MME1536_CmdPartOf(list1);
+	unsigned long long start_ns = 0;
 	
-	switch(operand){
-		case OPERAND_0:{
-			address_offset = OP0_OFFSET;
-		} break;
-		
-		case OPERAND_1:{
-			address_offset = OP1_OFFSET;
-		} break;
-		
-		case OPERAND_2:{
-			address_offset = OP2_OFFSET;
-		} break;
-		
-		case OPERAND_3:{
-			address_offset = OP3_OFFSET;
-		} break;
-		
-		default:{
-			printf("[ERROR] MME1536: GetOperand() -> wrong operand (%d)\n", operand);
-			return -1;
-		} break;
+	if((MME1536_CmdCheck(device_instance, list0) != 0) || (MME1536_CmdCheck(device_instance, list1) != 0)){
+		return -1;
+	}
+	if(!device_instance->split_pipeline || (part0 == TOT_PIPELINE) || (part1 == TOT_PIPELINE)
+	   || (part0 == 0) || (part1 == 0) || (part0 == part1)){
+		if(MME1536_CmdSubmit(device_instance, list0) != 0) return -1;
+		return MME1536_CmdSubmit(device_instance, list1);
 	}
 	
-	switch(length){
-		case BITS_LOW: {
-			words = WORDS_LOW;
-		} break;
-		case BITS_HIGH: {
-			address_offset += HIGH_OFFSET;
-			words = WORDS_HIGH;
-		} break;
-		case BITS_TOT: {
-			words = WORDS_TOT;
-		} break;
-		default: {
-			printf("[ERROR] MME1536: GetOperand() -> wrong operand length (%d)\n", length);
-			return -1;
-		} break;
+	// the core is shared with asynchronous jobs, finish those first, they
+	// may have left another modulus
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+		MME1536_EnsureModulus(device_instance);
+	}
+	// the lists may load a modulus in either part, which the cache doesn't
+	// track: the caller records what is loaded afterwards
+	device_instance->loaded_ctx = NULL;
+	
+	if(STATS_ON(device_instance)) start_ns = MME1536_StatsNow();
+	list[0] = list0;
+	list[1] = list1;
+	running = MME1536_CmdIssuePair(device_instance, list, next, &current, &fifo_owner, NULL);
+	while(running != NULL){
+		if(MME1536_WaitInterrupt(device_instance) != 0) return -1;
+		running = MME1536_CmdIssuePair(device_instance, list, next, &current, &fifo_owner, running);
+		MME1536_RearmInterrupt(device_instance);
+	}
+	if(STATS_ON(device_instance)){
+		// both lists wait for the pair
+		MME1536_StatsRecord(device_instance, part0, MME1536_StatsNow() - start_ns);
+		MME1536_StatsRecord(device_instance, part1, MME1536_StatsNow() - start_ns);
+	}
+	
+	if((next[0] < list0->count) || (next[1] < list1->count)){
+		printf("[ERROR] MME1536: CmdSubmitPair() -> an exponent was never used\n");
+		return -1;
 	}
 	
-	MME1536_GetData(device_instance, operand_data, address_offset, operand, words);
+	return ((list0->error != 0) || (list1->error != 0)) ? -1 : 0;
+}
+
+/** Use the pipeline parts separately.
+ * 
+ * Normally a 512-bit or 1024-bit operand is written with zeros in the
+ * other part of its memory. In split pipeline mode the other part is left
+ * alone, so the low and high part each keep their own modulus and
+ * operands, and 512-bit and 1024-bit jobs can be mixed (see
+ * MME1536_MMEPair()) without re-uploading them. Only enable this if the
+ * core ignores the operand words of the other part.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param enable is 1 to use the parts separately, 0 for the default
+ * 
+ * @return 0
+ */
+int MME1536_SetSplitPipeline(MME1536 * device_instance, int enable){
+	// queued jobs were built for the current mode
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
+	device_instance->split_pipeline = (enable != 0);
 	
 	return 0;
 }
 
-/** Read an operand from the core's memory.
+/** Compute two g0^e0 * g1^e1 mod m (see MME1536_MME()) together, a 512-bit
+ * one on the low part and a 1024-bit one on the high part of the pipeline
+ * (see MME1536_CmdSubmitPair()). Other combinations are computed one after
+ * the other.
  * 
  * @param device_instance is a pointer to a MME1536 variable
  *        associated with the hardware.
- * @param operand_data is a pointer to a buffer where the operand will
- *        be stored.
- * @param operand specifies the operand to read from the memory
- *        (OPERAND_0 to OPERAND_3)
+ * @param op0, op1 are pointers to the operands of the computations
  * 
- * @return nothing
+ * @return 0 upon success
+ *         -1 upon failure
  */
-int MME1536_GetOperand_m(MME1536 * device_instance, int * operand_data, int operand){
-	int address_offset;
+int MME1536_MMEPair(MME1536 * device_instance, MME1536_Op * op0, MME1536_Op * op1){
+	MME1536_MontCtx * ctx0, * ctx1;
+	MME1536_CmdList list0, list1;
 	
-	switch(operand){
-		case OPERAND_0:{
-			address_offset = OP0_OFFSET;
-		} break;
-		
-		case OPERAND_1:{
-			address_offset = OP1_OFFSET;
-		} break;
-		
-		case OPERAND_2:{
-			address_offset = OP2_OFFSET;
-		} break;
-		
-		case OPERAND_3:{
-			address_offset = OP3_OFFSET;
-		} break;
-		
-		default:{
-			printf("[ERROR] MME1536: GetOperand_m() -> wrong operand (%d)\n", operand);
-			return -1;
-		} break;
+	if((MME1536_PartOf(op0->n) == 0) || (MME1536_PartOf(op1->n) == 0)){
+		printf("[ERROR] MME1536: MMEPair() -> wrong operand length\n");
+		return -1;
 	}
 	
-	if(device_instance->n == BITS_HIGH){
-		address_offset += HIGH_OFFSET;
-	}
+	// get R2 from the modulus cache (the lookup of ctx1 can't evict ctx0,
+	// it was used last)
+	ctx0 = MME1536_CtxLookup(device_instance, op0->m, op0->n);
+	ctx1 = MME1536_CtxLookup(device_instance, op1->m, op1->n);
 	
-	MME1536_GetData(device_instance, operand_data, address_offset, operand, device_instance->words);
+	// each part keeps its own modulus, an upload of a resident one is skipped
+	MME1536_ListMME(&list0, ctx0->R2, op0->result, op0->g0, op0->g1, op0->m, op0->e0, op0->e1, op0->n, op0->t);
+	MME1536_ListMME(&list1, ctx1->R2, op1->result, op1->g0, op1->g1, op1->m, op1->e0, op1->e1, op1->n, op1->t);
+	if(MME1536_CmdSubmitPair(device_instance, &list0, &list1) != 0){
+		return -1;
+	}
+	// with one modulus in each part no single context is loaded
+	if(device_instance->split_pipeline && ((MME1536_PartOf(op0->n) ^ MME1536_PartOf(op1->n)) == TOT_PIPELINE)){
+		device_instance->loaded_ctx = NULL;
+	}
+	else{
+		device_instance->loaded_ctx = ctx1;
+	}
 	
 	return 0;
 }
 
-/******************************************************************************
- * Low-level Function Source                                                  *
- ******************************************************************************/
+/** Get the file descriptor that becomes readable when the core raises an
+ * interrupt, e.g. to add it to an epoll set. Call MME1536_Poll() when
+ * it is readable.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return the UIO file descriptor
+ */
+int MME1536_GetFd(MME1536 * device_instance){
+	return device_instance->ctrl_fd;
+}
 
-void MME1536_GetData(MME1536 * device_instance, int * buffer, int offset_start, int operand, int words){
-	int control = 0x00000000;
-	int word;
-	int address_offset = offset_start;
-	// set destination bits in the control register
-	// (necessary for reading from the correct location)
-	control |= (operand << DEST_BITS); 
-	*((unsigned *)(device_instance->ctrl_ptr)) = control;
-	// read all words
-	for(word=0;word<words;word++){
-		buffer[word] = *((unsigned *)(device_instance->data_ptr + address_offset));
-		address_offset += ADDR_STEP;
+/** Queue the computation of g0^e0 * g1^e1 mod m (see MME1536_MME()).
+ * 
+ * The job runs as soon as the jobs in front of it are done and advances
+ * when MME1536_Poll() or MME1536_Complete() is called. All buffers must
+ * stay valid until the job is done.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param job is a pointer to a job variable owned by the caller
+ * @param result is a pointer to the buffer where the result will be stored
+ * @param g0, g1, e0, e1, m are arrays containing the bases and exponents
+ * @param n is the lenght of g0, g1 and m (#bits)
+ * @param t is the length of the exponents (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_SubmitMME(MME1536 * device_instance, MME1536_Job * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	MME1536_JobReject(job);
+	if(MME1536_ListMME(&(job->list), job->R2, result, g0, g1, m, e0, e1, n, t) != 0){
+		return -1;
 	}
+	if(MME1536_CmdCheck(device_instance, &(job->list)) != 0) return -1;
+	memcpy(job->R2, MME1536_CtxLookup(device_instance, m, n)->R2, WORDS_TOT * sizeof(int));
+	// the job writes its own modulus
+	job->ctx = NULL;
+	MME1536_JobQueue(device_instance, job);
+	
+	return 0;
 }
 
-void MME1536_SetData(MME1536 * device_instance, int * data, int start_offset, int words){
-	int word;
-	int address_offset = start_offset;
-	// write all words
-	for(word=0;word<words;word++){
-		*((unsigned *)(device_instance->data_ptr + address_offset)) = data[word];
-		//printf("0x%08x\n",data[word]);
-		address_offset += ADDR_STEP;
+/** Queue the computation of g^e mod m: like MME1536_SubmitMME() with one
+ * base, without the precomputation of g1 and g0.g1.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param job is a pointer to a job variable owned by the caller
+ * @param result is a pointer to the buffer where the result will be stored
+ * @param g, e, m are arrays containing the base, exponent and modulus
+ * @param n is the lenght of g and m (#bits)
+ * @param t is the length of the exponent (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_SubmitExp(MME1536 * device_instance, MME1536_Job * job, int * result, int * g, int * m, int * e, int n, int t){
+	MME1536_JobReject(job);
+	if(MME1536_ListExp(&(job->list), job->R2, result, g, m, e, n, t) != 0){
+		return -1;
 	}
+	if(MME1536_CmdCheck(device_instance, &(job->list)) != 0) return -1;
+	memcpy(job->R2, MME1536_CtxLookup(device_instance, m, n)->R2, WORDS_TOT * sizeof(int));
+	// the job writes its own modulus
+	job->ctx = NULL;
+	MME1536_JobQueue(device_instance, job);
+	
+	return 0;
 }
 
-void MME1536_ComputeR2(int * R2, int * m, int n){
-	mpz_t R2_mpz, m_mpz, b2;
+/** Queue a single multiplication with m set (see MME1536_Multiply_m()).
+ * 
+ * The job runs under the modulus set when it was queued: UpdateModulus()
+ * first completes the queued jobs.
+ * 
+ * @return 0 upon success
+ *         -1 if the exponent doesn't fit the fifo (see MME1536_CmdSubmit())
+ */
+int MME1536_SubmitMultiply_m(MME1536 * device_instance, MME1536_Job * job, int * result, int * x, int * y){
+	MME1536_JobReject(job);
+	MME1536_JobModulus(device_instance, job);
+	MME1536_ListMultiply_m(device_instance, &(job->list), job->R2, result, x, y);
+	if(MME1536_CmdCheck(device_instance, &(job->list)) != 0) return -1;
+	MME1536_JobQueue(device_instance, job);
+	
+	return 0;
+}
 
-	mpz_init2(R2_mpz, n);
-	mpz_init2(m_mpz, n);
-	mpz_init_set_ui(b2, 2);
-	// convert integer array to mpz
-	mpz_import(m_mpz, n/(sizeof(int)*8), -1, sizeof(int), 0, 0, m);
-	// compute R2
-	mpz_powm_ui(R2_mpz, b2, (unsigned long int)(2 * n), m_mpz);
-	// convert result back to integer array
-	mpz_export((void*)R2,NULL,-1,sizeof(int),0,0,R2_mpz); 
+/** Queue a modular exponentiation with m set (see MME1536_Exp_m()).
+ * 
+ * The job runs under the modulus set when it was queued: UpdateModulus()
+ * first completes the queued jobs.
+ * 
+ * @return 0 upon success
+ *         -1 if the exponent doesn't fit the fifo (see MME1536_CmdSubmit())
+ */
+int MME1536_SubmitExp_m(MME1536 * device_instance, MME1536_Job * job, int * result, int * g, int * e, int t){
+	MME1536_JobReject(job);
+	MME1536_JobModulus(device_instance, job);
+	MME1536_ListExp_m(device_instance, &(job->list), job->R2, result, g, e, t);
+	if(MME1536_CmdCheck(device_instance, &(job->list)) != 0) return -1;
+	MME1536_JobQueue(device_instance, job);
+	
+	return 0;
 }
 
-void MME1536_EnableInterrupt(MME1536 * device_instance){
-	// Enable all interrupt sources from user logic.
-	*((unsigned *)(device_instance->ctrl_ptr + MME1536_INTR_IPIER_OFFSET)) = 0x00000001;
+/** Queue the computation of g0^e0 * g1^e1 mod m with m set (see
+ * MME1536_MME_m()).
+ * 
+ * The job runs under the modulus set when it was queued: UpdateModulus()
+ * first completes the queued jobs.
+ * 
+ * @return 0 upon success
+ *         -1 if the exponent doesn't fit the fifo (see MME1536_CmdSubmit())
+ */
+int MME1536_SubmitMME_m(MME1536 * device_instance, MME1536_Job * job, int * result, int * g0, int * g1, int * e0, int * e1, int t){
+	MME1536_JobReject(job);
+	MME1536_JobModulus(device_instance, job);
+	MME1536_ListMME(&(job->list), job->R2, result, g0, g1, NULL, e0, e1, device_instance->n, t);
+	if(MME1536_CmdCheck(device_instance, &(job->list)) != 0) return -1;
+	MME1536_JobQueue(device_instance, job);
+	
+	return 0;
+}
 
-	// Set global interrupt enable.
-	*((unsigned *)(device_instance->ctrl_ptr + MME1536_INTR_DGIER_OFFSET)) = INTR_GIE_MASK;
+/** Handle a pending interrupt, if any, and move the running job to its
+ * next phase. Doesn't block. While an exponent is streamed this also tops
+ * up the fifo (see MME1536_PollInterval()).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return the nr. of jobs that were completed (or aborted because the core
+ *         ran past the wait budget, see MME1536_Complete())
+ */
+int MME1536_Poll(MME1536 * device_instance){
+	int ints_passed = device_instance->prev_tot_ints;
+	
+	if(device_instance->queue_head == NULL) return 0;
+	if(device_instance->stream_next < device_instance->stream_count) MME1536_FifoRefill(device_instance);
+	if(!MME1536_ReadInterrupts(device_instance, &ints_passed)){
+		if(MME1536_TimeLeftUs(&(device_instance->deadline)) > 0) return 0;
+		// past the wait budget: recover the core and go on with the next job
+		printf("[WARNING] MME1536: Poll() -> Timeout!\n");
+		device_instance->stats.timeouts++;
+		MME1536_ResetHardware(device_instance);
+		return MME1536_JobAbort(device_instance);
+	}
+	MME1536_FifoCheck(device_instance);
+	device_instance->prev_tot_ints = ints_passed;
+	
+	return MME1536_JobAdvance(device_instance);
+}
+
+/** Wait until a job is done.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param job is a pointer to a job submitted on this device
+ * 
+ * @return 0 upon success
+ *         -1 if the job was never submitted, was rejected when submitted or
+ *         was aborted because the core timed out (the core is reset and the
+ *         next jobs still run)
+ */
+int MME1536_Complete(MME1536 * device_instance, MME1536_Job * job){
+	if(job->state == JOB_IDLE){
+		printf("[ERROR] MME1536: Complete() -> job was not submitted\n");
+		return -1;
+	}
+	while(job->state != JOB_DONE){
+		if(MME1536_WaitInterrupt(device_instance) != 0){
+			MME1536_JobAbort(device_instance);
+			continue;
+		}
+		MME1536_JobAdvance(device_instance);
+	}
+	
+	return job->error;
+}
+
+/** Do a single multiplication with m set
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is pointer to a buffer where the result will be stored
+ * @param x,y the multiplicands
+ * 
+ * @return 0 upon success
+ *         -1 if the core timed out
+ * 
+ * @warning only works when MME1536_UpdateModulus() has been called previously
+ */
+int MME1536_Multiply_m(MME1536 * device_instance, int * result, int * x, int * y){
+	MME1536_CmdList list;
+	
+	MME1536_EnsureModulus(device_instance);
+	
+	MME1536_ListMultiply_m(device_instance, &list, device_instance->R2, result, x, y);
+	return MME1536_CmdSubmit(device_instance, &list);
+}
+
+/** Do a modular exponentiation with m set
+ * 
+ * @return 0 upon success
+ *         -1 if the core timed out
+ * 
+ * @warning not tested!
+ */
+int MME1536_Exp_m(MME1536 * device_instance, int * result, int * g, int * e, int t){
+	MME1536_CmdList list;
+	
+	MME1536_EnsureModulus(device_instance);
+	
+	MME1536_ListExp_m(device_instance, &list, device_instance->R2, result, g, e, t);
+	return MME1536_CmdSubmit(device_instance, &list);
+}
+
+/** Compute the montgomery form g.R mod m of a base that is used for many
+ * exponentiations with m set, so these skip its conversion (see
+ * MME1536_ExpPinned_m()).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param base is a pointer to the pinned base to fill in
+ * @param g is the base
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ * 
+ * @warning only works when MME1536_UpdateModulus() has been called previously
+ */
+int MME1536_PinBase_m(MME1536 * device_instance, MME1536_Pinned * base, int * g){
+	int n = device_instance->n;
+	MME1536_CmdList list;
+	
+	if(device_instance->ctx == NULL){
+		printf("[ERROR] MME1536: PinBase_m() -> no modulus set\n");
+		return -1;
+	}
+	MME1536_EnsureModulus(device_instance);
+	
+	// (g.R2).R^(-1) = g.R
+	MME1536_CmdInit(&list);
+	MME1536_CmdLoad(&list, g, OPERAND_0, n);
+	MME1536_CmdLoad(&list, device_instance->R2, OPERAND_1, n);
+	MME1536_CmdSingle(&list, device_instance->part, OPERAND_3, OPERAND_0, OPERAND_1);
+	MME1536_CmdRead(&list, base->mont, OPERAND_3, n);
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	
+	base->hash = device_instance->ctx->hash;
+	base->n = n;
+	
+	return 0;
+}
+
+/** Do a modular exponentiation of a pinned base with m set (see
+ * MME1536_Exp_m()). gt0 is the pinned value and R is taken from the
+ * modulus cache, so only the exponent and R are written (and the base too
+ * when operand 0 was overwritten).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is pointer to a buffer where the result will be stored
+ * @param base is a base pinned with MME1536_PinBase_m()
+ * @param e is the exponent
+ * @param t is the length of the exponent (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ExpPinned_m(MME1536 * device_instance, int * result, MME1536_Pinned * base, int * e, int t){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	MME1536_CmdList list;
+	
+	if(MME1536_PinnedCheck(device_instance, base) != 0) return -1;
+	MME1536_EnsureModulus(device_instance);
+	
+	MME1536_CmdInit(&list);
+	MME1536_CmdLoad(&list, base->mont, OPERAND_0, n);
+	MME1536_CmdLoad(&list, one, OPERAND_2, n);
+	MME1536_CmdLoad(&list, device_instance->ctx->R, OPERAND_3, n);
+	MME1536_CmdExponent(&list, e, NULL, t);
+	
+	/* Main computation */
+	MME1536_CmdAuto(&list, part);
+	
+	/* Postcomputation */
+	MME1536_CmdSingle(&list, part, OPERAND_3, OPERAND_2, OPERAND_3);
+	MME1536_CmdRead(&list, result, OPERAND_3, n);
+	return MME1536_CmdSubmit(device_instance, &list);
+}
+
+/** Compute base0^e0 * base1^e1 mod m for pinned bases with m set (see
+ * MME1536_MME_m()). Only gt01 is computed by the core.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is pointer to a buffer where the result will be stored
+ * @param base0, base1 are bases pinned with MME1536_PinBase_m()
+ * @param e0, e1 are the exponents
+ * @param t is the length of the exponents (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_MMEPinned_m(MME1536 * device_instance, int * result, MME1536_Pinned * base0, MME1536_Pinned * base1, int * e0, int * e1, int t){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	MME1536_CmdList list;
+	
+	if(MME1536_PinnedCheck(device_instance, base0) != 0) return -1;
+	if(MME1536_PinnedCheck(device_instance, base1) != 0) return -1;
+	MME1536_EnsureModulus(device_instance);
+	
+	MME1536_CmdInit(&list);
+	MME1536_CmdLoad(&list, base0->mont, OPERAND_0, n);
+	MME1536_CmdLoad(&list, base1->mont, OPERAND_1, n);
+	// compute gt01
+	MME1536_CmdSingle(&list, part, OPERAND_2, OPERAND_0, OPERAND_1);
+	// written while gt01 is computed
+	MME1536_CmdLoad(&list, device_instance->ctx->R, OPERAND_3, n);
+	MME1536_CmdExponent(&list, e0, e1, t);
+	
+	/* Main computation */
+	MME1536_CmdAuto(&list, part);
+	
+	/* Postcomputation */
+	MME1536_CmdLoad(&list, one, OPERAND_2, n);
+	MME1536_CmdSingle(&list, part, OPERAND_3, OPERAND_2, OPERAND_3);
+	MME1536_CmdRead(&list, result, OPERAND_3, n);
+	return MME1536_CmdSubmit(device_instance, &list);
+}
+
+/** Prepare a base that is used for many exponentiations with m set and
+ * exponents of up to t bits (see MME1536_ExpFixed_m()).
+ * 
+ * An exponent e = e_lo + 2^h.e_hi with h about t/2 gives
+ * g^e = g^e_lo * (g^(2^h))^e_hi, so with g^(2^h) computed once here the
+ * exponentiation is one simultaneous exponentiation of h bits: half the
+ * squarings of MME1536_Exp_m(). g^(2^h) takes h squarings on the core.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param base is a pointer to the fixed base to fill in
+ * @param g is the base
+ * @param t is the maximum length of the exponents (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ * 
+ * @warning only works when MME1536_UpdateModulus() has been called previously
+ */
+int MME1536_FixedBaseInit_m(MME1536 * device_instance, MME1536_FixedBase * base, int * g, int t){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	int h = ((t+63)/64)*32;
+	int zeros[h/32 > 0 ? h/32 : 1];
+	int i;
+	MME1536_CmdList list;
+	
+	if(device_instance->ctx == NULL){
+		printf("[ERROR] MME1536: FixedBaseInit_m() -> no modulus set\n");
+		return -1;
+	}
+	if(t < 1){
+		printf("[ERROR] MME1536: FixedBaseInit_m() -> invalid exponent length %d\n", t);
+		return -1;
+	}
+	memset(zeros, 0, sizeof(zeros));
+	MME1536_EnsureModulus(device_instance);
+	
+	MME1536_CmdInit(&list);
+	// gt0 = (g.R2).R^(-1)
+	MME1536_CmdLoad(&list, g, OPERAND_0, n);
+	MME1536_CmdLoad(&list, device_instance->R2, OPERAND_1, n);
+	MME1536_CmdSingle(&list, part, OPERAND_0, OPERAND_0, OPERAND_1);
+	MME1536_CmdRead(&list, base->power[0].mont, OPERAND_0, n);
+	// gt1 = gt0^(2^h): an all-zero exponent only squares the accumulator
+	MME1536_CmdLoad(&list, base->power[0].mont, OPERAND_3, n);
+	MME1536_CmdExponent(&list, zeros, NULL, h);
+	MME1536_CmdAuto(&list, part);
+	MME1536_CmdRead(&list, base->power[1].mont, OPERAND_3, n);
+	// gt01
+	MME1536_CmdSingle(&list, part, OPERAND_2, OPERAND_0, OPERAND_3);
+	MME1536_CmdRead(&list, base->power[2].mont, OPERAND_2, n);
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	
+	for(i=0; i<3; i++){
+		base->power[i].hash = device_instance->ctx->hash;
+		base->power[i].n = n;
+	}
+	base->t = t;
+	base->h = h;
+	
+	return 0;
+}
+
+/** Do a modular exponentiation of a fixed base with m set (see
+ * MME1536_FixedBaseInit_m()): the low and high h bits of e are the
+ * exponents of a simultaneous exponentiation of gt0 and gt1, with gt01
+ * taken from the fixed base as well. Exponents of up to h bits are done as
+ * MME1536_ExpPinned_m() of gt0.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is pointer to a buffer where the result will be stored
+ * @param base is a base prepared with MME1536_FixedBaseInit_m()
+ * @param e is the exponent
+ * @param t is the length of the exponent (#bits, at most that of the fixed
+ *        base; bits of the last word of e above t must be 0)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ExpFixed_m(MME1536 * device_instance, int * result, MME1536_FixedBase * base, int * e, int t){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	int h = base->h;
+	int words = h/32;
+	int e_pad[2*words];
+	int * e0 = e;
+	int * e1 = e + words;
+	MME1536_CmdList list;
+	
+	if((t < 1) || (t > base->t)){
+		printf("[ERROR] MME1536: ExpFixed_m() -> exponent length %d outside 1..%d\n", t, base->t);
+		return -1;
+	}
+	// a short exponent is rounded up to whole words, as a long one is
+	// zero-extended below
+	if(t <= h) return MME1536_ExpPinned_m(device_instance, result, &base->power[0], e, ((t+31)/32)*32);
+	if(MME1536_PinnedCheck(device_instance, &base->power[0]) != 0) return -1;
+	
+	// zero-extend e to 2h bits
+	if(t < 2*h){
+		memset(e_pad, 0, sizeof(e_pad));
+		memcpy(e_pad, e, ((t+31)/32)*4);
+		e0 = e_pad;
+		e1 = e_pad + words;
+	}
+	MME1536_EnsureModulus(device_instance);
+	
+	MME1536_CmdInit(&list);
+	MME1536_CmdLoad(&list, base->power[0].mont, OPERAND_0, n);
+	MME1536_CmdLoad(&list, base->power[1].mont, OPERAND_1, n);
+	MME1536_CmdLoad(&list, base->power[2].mont, OPERAND_2, n);
+	MME1536_CmdLoad(&list, device_instance->ctx->R, OPERAND_3, n);
+	MME1536_CmdExponent(&list, e0, e1, h);
+	
+	/* Main computation */
+	MME1536_CmdAuto(&list, part);
+	
+	/* Postcomputation */
+	MME1536_CmdLoad(&list, one, OPERAND_2, n);
+	MME1536_CmdSingle(&list, part, OPERAND_3, OPERAND_2, OPERAND_3);
+	MME1536_CmdRead(&list, result, OPERAND_3, n);
+	return MME1536_CmdSubmit(device_instance, &list);
+}
+
+/** Do a modular exponentiation with m set and keep the result in the core
+ * for chained operations (see MME1536_ValueMultiply_m()).
+ * 
+ * A value stays in an operand in montgomery form, so there is no
+ * postcomputation and no read: only MME1536_ValueRead_m() brings the end
+ * result of a chain to the host. Up to four values are kept at once; when
+ * an operation needs the operand of a value, the value is moved to a free
+ * operand on the core or, when there is none, read back and written again
+ * when it is used. Other functions that write an operand (MME1536_Exp_m(),
+ * jobs, ...) drop the value kept there: using it afterwards fails. A value
+ * must be released with MME1536_ValueRelease() before its memory goes away.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param value is a pointer to the value that receives the result (its
+ *        previous content is dropped)
+ * @param g is the base
+ * @param e is the exponent
+ * @param t is the length of the exponent (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ * 
+ * @warning only works when MME1536_UpdateModulus() has been called previously
+ */
+int MME1536_ValueExp_m(MME1536 * device_instance, MME1536_Value * value, int * g, int * e, int t){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	int avoid = (1 << OPERAND_0) | (1 << OPERAND_1) | (1 << OPERAND_3);
+	MME1536_ValuePlan plan;
+	MME1536_CmdList list;
+	
+	if(device_instance->ctx == NULL){
+		printf("[ERROR] MME1536: ValueExp_m() -> no modulus set\n");
+		return -1;
+	}
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
+	MME1536_ValueRelease(device_instance, value);
+	MME1536_EnsureModulus(device_instance);
+	
+	// operand 2 is not used, a value there stays
+	plan.count = 0;
+	MME1536_CmdInit(&list);
+	MME1536_ValueRoom(device_instance, &list, &plan, OPERAND_0, &avoid);
+	MME1536_ValueRoom(device_instance, &list, &plan, OPERAND_1, &avoid);
+	MME1536_ValueRoom(device_instance, &list, &plan, OPERAND_3, &avoid);
+	
+	/* Precomputation */
+	MME1536_CmdLoad(&list, g, OPERAND_0, n);
+	MME1536_CmdLoad(&list, device_instance->R2, OPERAND_1, n);
+	MME1536_CmdSingle(&list, part, OPERAND_0, OPERAND_0, OPERAND_1);
+	MME1536_CmdLoad(&list, device_instance->ctx->R, OPERAND_3, n);
+	MME1536_CmdExponent(&list, e, NULL, t);
+	
+	/* Main computation */
+	MME1536_CmdAuto(&list, part);
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	
+	MME1536_ValueCommit(device_instance, &plan);
+	MME1536_ValuePlace(device_instance, value, OPERAND_3);
+	return 0;
+}
+
+/** Write a number to the core as a value with m set (see
+ * MME1536_ValueExp_m()), e.g. a blinding factor.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param value is a pointer to the value that receives x (its previous
+ *        content is dropped)
+ * @param x is the number
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ValueLoad_m(MME1536 * device_instance, MME1536_Value * value, int * x){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	int avoid = 0;
+	int a, b;
+	MME1536_ValuePlan plan;
+	MME1536_CmdList list;
+	
+	if(device_instance->ctx == NULL){
+		printf("[ERROR] MME1536: ValueLoad_m() -> no modulus set\n");
+		return -1;
+	}
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
+	MME1536_ValueRelease(device_instance, value);
+	MME1536_EnsureModulus(device_instance);
+	
+	plan.count = 0;
+	MME1536_CmdInit(&list);
+	a = MME1536_ValueFree(device_instance, avoid, 1);
+	MME1536_ValueRoom(device_instance, &list, &plan, a, &avoid);
+	b = MME1536_ValueFree(device_instance, avoid, 1);
+	MME1536_ValueRoom(device_instance, &list, &plan, b, &avoid);
+	
+	// x.R = (x.R2).R^(-1)
+	MME1536_CmdLoad(&list, x, a, n);
+	MME1536_CmdLoad(&list, device_instance->R2, b, n);
+	MME1536_CmdSingle(&list, part, a, a, b);
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	
+	MME1536_ValueCommit(device_instance, &plan);
+	MME1536_ValuePlace(device_instance, value, a);
+	return 0;
+}
+
+/** Compute x * y mod m of values with m set (see MME1536_ValueExp_m()):
+ * one multiplication on the core, (x.R).(y.R).R^(-1) = x.y.R, without
+ * writing or reading operands unless x or y had to leave the core.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is a pointer to the value that receives the product, it
+ *        may be x or y (its previous content is dropped)
+ * @param x, y are pointers to the values to multiply
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ValueMultiply_m(MME1536 * device_instance, MME1536_Value * result, MME1536_Value * x, MME1536_Value * y){
+	int avoid = 0;
+	int x_op, y_op, dest;
+	MME1536_ValuePlan plan;
+	MME1536_CmdList list;
+	
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
+	if(MME1536_ValueCheck(device_instance, x) != 0) return -1;
+	if(MME1536_ValueCheck(device_instance, y) != 0) return -1;
+	if((result != x) && (result != y)) MME1536_ValueRelease(device_instance, result);
+	MME1536_EnsureModulus(device_instance);
+	
+	plan.count = 0;
+	MME1536_CmdInit(&list);
+	x_op = MME1536_ValueUse(device_instance, &list, &plan, x, &avoid);
+	y_op = (y == x) ? x_op : MME1536_ValueUse(device_instance, &list, &plan, y, &avoid);
+	if(result == x) dest = x_op;
+	else if(result == y) dest = y_op;
+	else{
+		dest = MME1536_ValueFree(device_instance, avoid, 1);
+		MME1536_ValueRoom(device_instance, &list, &plan, dest, &avoid);
+	}
+	MME1536_CmdSingle(&list, device_instance->part, dest, x_op, y_op);
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	
+	MME1536_ValueCommit(device_instance, &plan);
+	MME1536_ValuePlace(device_instance, result, dest);
+	return 0;
+}
+
+/** Read a value with m set (see MME1536_ValueExp_m()): v = (v.R).1.R^(-1)
+ * is computed in a free operand, so the value stays in the core.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is pointer to a buffer where the number will be stored
+ * @param value is a pointer to the value
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_ValueRead_m(MME1536 * device_instance, int * result, MME1536_Value * value){
+	int n = device_instance->n;
+	int avoid = 0;
+	int v_op, c;
+	MME1536_ValuePlan plan;
+	MME1536_CmdList list;
+	
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
+	if(MME1536_ValueCheck(device_instance, value) != 0) return -1;
+	MME1536_EnsureModulus(device_instance);
+	
+	plan.count = 0;
+	MME1536_CmdInit(&list);
+	v_op = MME1536_ValueUse(device_instance, &list, &plan, value, &avoid);
+	c = MME1536_ValueFree(device_instance, avoid, 1);
+	MME1536_ValueRoom(device_instance, &list, &plan, c, &avoid);
+	
+	/* Postcomputation */
+	MME1536_CmdLoad(&list, one, c, n);
+	MME1536_CmdSingle(&list, device_instance->part, c, v_op, c);
+	MME1536_CmdRead(&list, result, c, n);
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	
+	MME1536_ValueCommit(device_instance, &plan);
+	return 0;
+}
+
+/** Drop a value (see MME1536_ValueExp_m()): its operand is free again.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param value is a pointer to the value
+ */
+void MME1536_ValueRelease(MME1536 * device_instance, MME1536_Value * value){
+	if(MME1536_ValueResident(device_instance, value)) device_instance->holder[value->operand] = NULL;
+	value->valid = 0;
+	value->operand = -1;
+}
+
+/** Do many modular exponentiations with m set
+ * 
+ * R2 and '1' are written once and stay in operands 1 and 2; R (the
+ * montgomery form of 1) is taken from the modulus cache and written into
+ * operand 3 for each job instead of being recomputed. The base and exponent of the
+ * next job are written while the postcomputation of the current one runs.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param results is an array of pointers to the result buffers
+ * @param bases, exps are arrays of pointers to the bases and exponents
+ * @param count is the nr. of exponentiations
+ * @param t is the length of the exponents (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ * 
+ * @warning only works when MME1536_UpdateModulus() has been called previously
+ */
+int MME1536_ExpBatch_m(MME1536 * device_instance, int ** results, int ** bases, int ** exps, int count, int t){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	int * R;
+	int i;
+	MME1536_CmdList list;
+	
+	if(count < 1) return 0;
+	if(part == 0){
+		printf("[ERROR] MME1536: ExpBatch_m() -> no modulus set\n");
+		return -1;
+	}
+	MME1536_EnsureModulus(device_instance);
+	
+	/* Per-modulus constants */
+	MME1536_CmdInit(&list);
+	MME1536_CmdLoad(&list, device_instance->R2, OPERAND_1, n);
+	MME1536_CmdLoad(&list, one, OPERAND_2, n);
+	// first job
+	MME1536_CmdLoad(&list, bases[0], OPERAND_0, n);
+	MME1536_CmdExponent(&list, exps[0], NULL, t);
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	R = device_instance->ctx->R;
+	
+	for(i=0; i<count; i++){
+		MME1536_CmdInit(&list);
+		// compute gt0
+		MME1536_CmdSingle(&list, part, OPERAND_0, OPERAND_0, OPERAND_1);
+		// write R (while gt0 is computed)
+		MME1536_CmdLoad(&list, R, OPERAND_3, n);
+		
+		/* Main computation */
+		MME1536_CmdAuto(&list, part);
+		
+		/* Postcomputation */
+		MME1536_CmdSingle(&list, part, OPERAND_3, OPERAND_2, OPERAND_3);
+		// next job (while the postcomputation runs)
+		if(i+1 < count){
+			MME1536_CmdLoad(&list, bases[i+1], OPERAND_0, n);
+			MME1536_CmdExponent(&list, exps[i+1], NULL, t);
+		}
+		MME1536_CmdRead(&list, results[i], OPERAND_3, n);
+		if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	}
+	
+	return 0;
+}
+
+/** Set a new modulus to be used by the hardware
+ * 
+ * The precomputed values for the last CTX_CACHE_SIZE moduli are kept, so
+ * switching back to one of them skips the R2 computation, and the
+ * modulus upload as well if the core still holds it.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param m is an array containing the modulus
+ * @param n is the length of the modulus in bits (512, 1024 or 1536, see
+ *        libmme1536_mp.c for longer moduli)
+ * 
+ * @return 0 upon success
+ *         -1 for a wrong modulus length (the previous modulus stays set)
+ */
+int MME1536_UpdateModulus(MME1536 * device_instance, int * m, int n){
+	const MME1536_SizeOps * ops = MME1536_OpsOf(n);
+	
+	if(ops == NULL){
+		printf("[ERROR] MME1536: UpdateModulus() -> wrong modulus length: %d\n", n);
+		return -1;
+	}
+	
+	// queued jobs use the current modulus, finish those first
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
+	
+	device_instance->ops = ops;
+	device_instance->part = ops->part;
+	device_instance->n = n;
+	device_instance->words = ops->words;
+	
+	// R2 comes from the modulus cache
+	MME1536_MontCtx * ctx = MME1536_CtxLookup(device_instance, m, n);
+	memcpy(device_instance->R2, ctx->R2, WORDS_TOT * sizeof(int));
+	device_instance->ctx = ctx;
+	
+	// the core may have this modulus already
+	MME1536_EnsureModulus(device_instance);
+	
+	return 0;
+}
+
+/** Compute g0^e0 * g1^e1 mod m (with m set by UpdateModulus)
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is a pointer to the buffer where the result will be stored
+ * @param g0, g1, e0, e1 are arrays containing the bases and exponents
+ * @param t is the length of the exponents (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_MME_m(MME1536 * device_instance, int * result, int * g0, int * g1, int * e0, int * e1, int t){
+	if(device_instance->ctx == NULL){
+		printf("[ERROR] MME1536: MME_m() -> no modulus set\n");
+		return -1;
+	}
+	
+	return MME1536_MMECtx(device_instance, device_instance->ctx, result, g0, g1, e0, e1, t);
+}
+
+/** Compute g0^e0 * g1^e1 mod m
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param result is a pointer to the buffer where the result will be stored
+ * @param g0, g1, e0, e1, m are arrays containing the bases and exponents
+ * @param n is the lenght of g0, g1 and m (#bits)
+ * @param t is the length of the exponents (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_MME(MME1536 * device_instance, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	if(MME1536_PartOf(n) == 0){
+		printf("[ERROR] MME1536: MME() -> wrong operand length: %d\n", n);
+		return -1;
+	}
+	
+	/* Precomputation */
+	// get R2 from the modulus cache
+	return MME1536_MMECtx(device_instance, MME1536_CtxLookup(device_instance, m, n), result, g0, g1, e0, e1, t);
+}
+
+/** Wait until the core has completed it's operation (interrupt)
+ * 
+ * Depending on the wait mode (see MME1536_SetWaitMode()) the UIO counter
+ * is polled, the calling thread sleeps in select() on the UIO fd, or it
+ * first polls for spin_us microseconds and then sleeps. In all modes the
+ * wait is bounded by the deadline on the monotonic clock that was set when
+ * the operation was started, from its wait budget (see
+ * MME1536_SetWaitBudget()). An operation that runs past it is abandoned
+ * with a soft reset of the core (see MME1536_ResetHardware()).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return 0 upon success
+ *         -1 if the core timed out
+ */
+int MME1536_WaitUntilReady(MME1536 * device_instance){
+	int ret = MME1536_WaitInterrupt(device_instance);
+	MME1536_RearmInterrupt(device_instance);
+	
+	return ret;
+}
+
+/** Wait for the next interrupt without re-enabling it (see
+ * MME1536_WaitUntilReady()).
+ * 
+ * @return 0 upon success
+ *         -1 if the core timed out (it has been reset)
+ */
+int MME1536_WaitInterrupt(MME1536 * device_instance){
+	int ints_passed = -1;
+	int ret = 0;
+	struct timespec deadline, spin_end;
+	long budget_us, spin_us;
+	unsigned long long start_ns = 0, spin_start_ns = 0, sleep_start_ns = 0;
+	unsigned long long iterations = 0;
+	
+	deadline = device_instance->deadline;
+	budget_us = MME1536_TimeLeftUs(&deadline);
+	if(budget_us < 0) budget_us = 0;
+	switch(device_instance->wait_mode){
+		case WAIT_BLOCK:{
+			spin_us = 0;
+		} break;
+		case WAIT_HYBRID:{
+			spin_us = device_instance->spin_us;
+		} break;
+		default:{
+			spin_us = budget_us;
+		} break;
+	}
+	if(spin_us > budget_us) spin_us = budget_us;
+	
+	clock_gettime(CLOCK_MONOTONIC, &spin_end);
+	MME1536_TimeAddUs(&spin_end, spin_us);
+	if(STATS_ON(device_instance)) start_ns = MME1536_StatsNow();
+	
+	// streaming phase: top up the fifo until it holds the whole exponent
+	while((device_instance->stream_next < device_instance->stream_count)
+	      && (MME1536_ReadInterrupts(device_instance, &ints_passed) == 0)){
+		long left_us = MME1536_TimeLeftUs(&deadline);
+		if(left_us <= 0) break;
+		if(MME1536_FifoRefill(device_instance) == 0) break;
+		if(left_us > FIFO_POLL_MS * 1000L) left_us = FIFO_POLL_MS * 1000L;
+		fd_set fds = device_instance->select_fd;
+		struct timeval tv;
+		tv.tv_sec = 0;
+		tv.tv_usec = left_us;
+		select(device_instance->ctrl_fd + 1, &fds, NULL, NULL, &tv);
+	}
+	
+	// spin phase: poll the interrupt counter
+	if(STATS_ON(device_instance)) spin_start_ns = MME1536_StatsNow();
+	while(MME1536_ReadInterrupts(device_instance, &ints_passed) == 0){
+		iterations++;
+		if(MME1536_TimeLeftUs(&spin_end) <= 0) break;
+	}
+	if(STATS_ON(device_instance)) sleep_start_ns = MME1536_StatsNow();
+	
+	// blocking phase: sleep until the UIO fd becomes readable
+	while(ints_passed <= device_instance->prev_tot_ints){
+		long left_us = MME1536_TimeLeftUs(&deadline);
+		if(left_us <= 0){
+			printf("[WARNING] MME1536: WaitUntilReady() -> Timeout!\n");
+			device_instance->stats.timeouts++;
+			ret = -1;
+			break;
+		}
+		fd_set fds = device_instance->select_fd;
+		struct timeval tv;
+		tv.tv_sec = left_us / 1000000L;
+		tv.tv_usec = left_us % 1000000L;
+		int ready = select(device_instance->ctrl_fd + 1, &fds, NULL, NULL, &tv);
+		if(ready > 0){
+			MME1536_ReadInterrupts(device_instance, &ints_passed);
+		}
+		else if((ready < 0) && (errno != EINTR)){
+			perror("[ERROR] MME1536: WaitUntilReady() -> select failed\n");
+			ret = -1;
+			break;
+		}
+	}
+	if(STATS_ON(device_instance)){
+		// the streaming phase sleeps in select() as well
+		device_instance->stats.waits++;
+		device_instance->stats.spin_ns += sleep_start_ns - spin_start_ns;
+		device_instance->stats.spin_iterations += iterations;
+		device_instance->stats.sleep_ns += (spin_start_ns - start_ns) + (MME1536_StatsNow() - sleep_start_ns);
+	}
+	// update the nr of interrupts
+	if(ints_passed > device_instance->prev_tot_ints){
+		MME1536_FifoCheck(device_instance);
+	}
+	device_instance->prev_tot_ints = ints_passed;
+	// abandon the operation, so the core can take the next one
+	if(ret != 0) MME1536_ResetHardware(device_instance);
+	
+	return ret;
+}
+
+/** Select how MME1536_WaitUntilReady() waits for the core.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param mode is WAIT_SPIN, WAIT_BLOCK or WAIT_HYBRID
+ * @param spin_us is the time to poll before sleeping (WAIT_HYBRID only)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_SetWaitMode(MME1536 * device_instance, int mode, int spin_us){
+	if((mode != WAIT_SPIN) && (mode != WAIT_BLOCK) && (mode != WAIT_HYBRID)){
+		printf("[ERROR] MME1536: SetWaitMode() -> wrong wait mode (%d)\n", mode);
+		return -1;
+	}
+	if(spin_us < 0){
+		printf("[ERROR] MME1536: SetWaitMode() -> negative spin time (%d)\n", spin_us);
+		return -1;
+	}
+	device_instance->wait_mode = mode;
+	device_instance->spin_us = spin_us;
+	
+	return 0;
+}
+
+/** Set the wait budget of core operations: base_us plus ns_per_bit for
+ * each operand bit of each multiplication the operation can do (1 for a
+ * single multiplication, 2 per exponent bit for an auto-run). The deadline
+ * is set when the operation is started; an operation that is not done by
+ * then is abandoned (see MME1536_WaitUntilReady()).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param base_us is the fixed part of the budget (TIMEOUT_S, TIMEOUT_US)
+ * @param ns_per_bit is the part per bit (DEFAULT_BUDGET_NS_PER_BIT)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_SetWaitBudget(MME1536 * device_instance, long base_us, int ns_per_bit){
+	if((base_us < 0) || (ns_per_bit < 0)){
+		printf("[ERROR] MME1536: SetWaitBudget() -> negative budget (%ld us, %d ns per bit)\n", base_us, ns_per_bit);
+		return -1;
+	}
+	device_instance->tv.tv_sec = base_us / 1000000L;
+	device_instance->tv.tv_usec = base_us % 1000000L;
+	device_instance->budget_ns_per_bit = ns_per_bit;
+	
+	return 0;
+}
+
+/** Soft reset of the core, to recover from an operation that does not
+ * finish. The operation in progress and the exponent fifo are abandoned,
+ * the interrupt is enabled again and the modulus set by UpdateModulus() is
+ * written again; all other operands must be rewritten by the host.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return 0
+ */
+int MME1536_ResetHardware(MME1536 * device_instance){
+	int ints = device_instance->prev_tot_ints;
+	int operand;
+	
+	// a transfer in flight is abandoned as well
+	if(device_instance->dma_fd >= 0) MME1536_DmaReset(device_instance);
+	device_instance->dma_busy_bytes = 0;
+	
+	if(device_instance->backend != NULL){
+		device_instance->backend->reset(device_instance);
+	}
+	else{
+		*((volatile unsigned *)(device_instance->ctrl_ptr + MME1536_RST_OFFSET)) = SOFT_RESET;
+		__sync_synchronize();
+	}
+	// the reset clears the control register and the interrupt enables
+	*((volatile unsigned *)(device_instance->ctrl_ptr)) = 0;
+	device_instance->ctrl_shadow = 0;
+	MME1536_EnableInterrupt(device_instance);
+	MME1536_FifoClearNoPush(device_instance);
+	
+	// the fifo is empty
+	device_instance->stream_next = 0;
+	device_instance->stream_count = 0;
+	device_instance->stream_auto = 0;
+	device_instance->exp_entries = 0;
+	
+	// the abandoned operation may have written any operand
+	for(operand=OPERAND_0; operand<=MODULUS; operand++){
+		device_instance->dirty[operand] = REGION_LOW | REGION_HIGH;
+		device_instance->res_n[operand][0] = 0;
+		device_instance->res_n[operand][1] = 0;
+		device_instance->holder[operand] = NULL;
+	}
+	device_instance->loaded_ctx = NULL;
+	MME1536_EnsureModulus(device_instance);
+	
+	// an interrupt that got through before the reset is not for the next
+	// operation
+	MME1536_ReadInterrupts(device_instance, &ints);
+	device_instance->prev_tot_ints = ints;
+	MME1536_RearmInterrupt(device_instance);
+	device_instance->stats.resets++;
+	
+	return 0;
+}
+
+/** Write exponents to the exponent fifo.
+ * 
+ * At most fifo_depth entries (2 per 32 exponent bits) are written. Longer
+ * exponents need fifo streaming (see MME1536_SetFifoStreaming()): the rest
+ * is written while the core runs, so e0 and e1 must stay valid until then.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param e0, e1 are arrays containing the exponents
+ * @param t is the nr of bits in the exponent
+ * 
+ * @return 0 upon success
+ *         -1 if t is no multiple of 32 or the exponent doesn't fit the fifo
+ *         (nothing is written)
+ */
+int MME1536_SetExponent(MME1536 * device_instance, int * e0, int * e1, int t){
+	volatile unsigned * fifo = (volatile unsigned *)(device_instance->data_ptr + FIFO_OFFSET);
+	int i, words, first, count;
+	
+	if((t%32)!=0){
+		printf("[ERROR] MME1536: SetExponent() -> exponent length %d, is no multiple of 32.\n", t);
+		return -1;
+	}
+	words = t/32;
+	
+	// exponent words that fit the fifo now: words-1 down to first
+	count = MME1536_FifoBegin(device_instance, e0, e1, NULL, 2*words);
+	if(count < 0) return -1;
+	first = words - count/2;
+	
+	// fifo entries must arrive in order: wait for a fifo transfer in flight
+	MME1536_DmaClaim(device_instance, FIFO_OFFSET, PAGE_SIZE);
+	if(device_instance->dma_fd >= 0 && 2*(words-first) >= DMA_MIN_WORDS && 2*(words-first)*ADDR_STEP <= PAGE_SIZE){
+		// create fifo entries in the staging buffer and send them with one
+		// transfer to the fifo address
+		MME1536_FifoEncode((unsigned *)(device_instance->dma_buf + FIFO_OFFSET), e0, e1, words, first);
+		MME1536_DmaStart(device_instance, FIFO_OFFSET, 2*(words-first)*ADDR_STEP, 1);
+		return 0;
+	}
+	
+	// create fifo entries and write to fifo: high halves first
+	if(e1==NULL){
+		for(i=(words-1); i>=first; i--){
+			MME1536_FifoWrite(device_instance, fifo, ((e0[i] & 0xffff0000) >> 16));
+			MME1536_FifoWrite(device_instance, fifo, (e0[i] & 0x0000ffff));
+		}
+	}
+	else{
+		for(i=(words-1); i>=first; i--){
+			MME1536_FifoWrite(device_instance, fifo, (e1[i] & 0xffff0000) | ((e0[i] & 0xffff0000) >> 16));
+			MME1536_FifoWrite(device_instance, fifo, ((e1[i] & 0x0000ffff) << 16) | (e0[i] & 0x0000ffff));
+		}
+	}
+	
+	return 0;
+}
+
+/** Encode an exponent (pair) into fifo entries once, for exponents that are
+ * used many times (see MME1536_SetExponentImage()).
+ * 
+ * @param e0, e1 are arrays containing the exponents (e1 NULL for a single
+ *        exponentiation)
+ * @param t is the nr of bits in the exponent
+ * 
+ * @return a pointer to the image (free with MME1536_FreeExponent())
+ *         NULL upon failure
+ */
+MME1536_ExpImage * MME1536_EncodeExponent(int * e0, int * e1, int t){
+	MME1536_ExpImage * image;
+	
+	if((t <= 0) || ((t%32)!=0)){
+		printf("[ERROR] MME1536: EncodeExponent() -> exponent length %d, is no multiple of 32.\n", t);
+		return NULL;
+	}
+	if(posix_memalign((void **)&image, CACHE_LINE, sizeof(MME1536_ExpImage) + (t/16) * sizeof(unsigned)) != 0){
+		printf("[ERROR] MME1536: EncodeExponent() -> could not allocate memory for the image.\n");
+		return NULL;
+	}
+	image->capacity = t/16;
+	if(MME1536_EncodeExponentInto(image, e0, e1, t) != 0){
+		free(image);
+		return NULL;
+	}
+	
+	return image;
+}
+
+/** Encode an exponent (pair) into an existing image, e.g. the one of a job
+ * buffer from the arena (see MME1536_ArenaBorrow()), without allocating.
+ * 
+ * @param image is a pointer to the image to overwrite
+ * @param e0, e1 are arrays containing the exponents (e1 NULL for a single
+ *        exponentiation)
+ * @param t is the nr of bits in the exponent (at most what the image was
+ *        made for)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_EncodeExponentInto(MME1536_ExpImage * image, int * e0, int * e1, int t){
+	if((t <= 0) || ((t%32)!=0)){
+		printf("[ERROR] MME1536: EncodeExponentInto() -> exponent length %d, is no multiple of 32.\n", t);
+		return -1;
+	}
+	if(t/16 > image->capacity){
+		printf("[ERROR] MME1536: EncodeExponentInto() -> exponent of %d bits does not fit the image.\n", t);
+		return -1;
+	}
+	image->t = t;
+	image->entries = t/16;
+	MME1536_FifoEncode(image->entry, e0, e1, t/32, 0);
+	
+	return 0;
+}
+
+/** Free an exponent image.
+ * 
+ * @param image is a pointer returned by MME1536_EncodeExponent()
+ * 
+ * @return nothing
+ */
+void MME1536_FreeExponent(MME1536_ExpImage * image){
+	free(image);
+}
+
+/** Write a pre-encoded exponent to the exponent fifo (see
+ * MME1536_SetExponent()).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param image is a pointer returned by MME1536_EncodeExponent(), which must
+ *        stay valid until the exponentiation is done
+ * 
+ * @return 0 upon success
+ *         -1 if the exponent doesn't fit the fifo (nothing is written)
+ */
+int MME1536_SetExponentImage(MME1536 * device_instance, MME1536_ExpImage * image){
+	volatile unsigned * fifo = (volatile unsigned *)(device_instance->data_ptr + FIFO_OFFSET);
+	int k, count;
+	
+	count = MME1536_FifoBegin(device_instance, NULL, NULL, image->entry, image->entries);
+	if(count < 0) return -1;
+	
+	// fifo entries must arrive in order: wait for a fifo transfer in flight
+	MME1536_DmaClaim(device_instance, FIFO_OFFSET, PAGE_SIZE);
+	if(device_instance->dma_fd >= 0 && count >= DMA_MIN_WORDS && count*ADDR_STEP <= PAGE_SIZE){
+		memcpy(device_instance->dma_buf + FIFO_OFFSET, image->entry, count*ADDR_STEP);
+		MME1536_DmaStart(device_instance, FIFO_OFFSET, count*ADDR_STEP, 1);
+		return 0;
+	}
+	
+	for(k=0; k<count; k++){
+		MME1536_FifoWrite(device_instance, fifo, image->entry[k]);
+	}
+	
+	return 0;
+}
+
+/** Configure the exponent fifo.
+ * 
+ * Without streaming, exponents longer than depth/2 words are rejected by
+ * MME1536_SetExponent(). With streaming, the fifo is filled up front and
+ * topped up while the core runs: first entries are written until the core
+ * reports a dropped write (IPISR_FIFO_NOPUSH), the dropped entry is retried
+ * on the next top-up. Top-ups are done in MME1536_WaitUntilReady() and
+ * MME1536_Poll(); callers that sleep on MME1536_GetFd() themselves must call
+ * MME1536_Poll() at least every MME1536_PollInterval() ms, or the fifo runs
+ * empty and the core stops before the end of the exponent.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param enable is 1 to stream long exponents, 0 to reject them
+ * @param depth is the nr. of fifo entries of the core (even, >= 2)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_SetFifoStreaming(MME1536 * device_instance, int enable, int depth){
+	if((depth < 2) || ((depth % 2) != 0)){
+		printf("[ERROR] MME1536: SetFifoStreaming() -> wrong fifo depth (%d)\n", depth);
+		return -1;
+	}
+	device_instance->fifo_streaming = (enable != 0);
+	device_instance->fifo_depth = depth;
+	
+	return 0;
+}
+
+/** Get the longest time a caller may sleep on MME1536_GetFd() before
+ * calling MME1536_Poll() (see MME1536_SetFifoStreaming()).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return the time in ms
+ *         -1 if there is no limit
+ */
+int MME1536_PollInterval(MME1536 * device_instance){
+	if(device_instance->stream_next == device_instance->stream_count){
+		return -1;
+	}
+	return FIFO_POLL_MS;
+}
+
+/** Write an operand to the core's memory
+ * 
+ * The value is remembered until the core writes the operand, so writing
+ * the same value again (the constant 1, R2, a fixed base) costs no bus
+ * transfers.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param operand_data is an array containing the operand
+ * @param operand sets the memory location where the operand data will be
+ *        stored (OPERAND_0 to OPERAND_3 or MODULUS).
+ * @param length is the length of the operand (#bits)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_SetOperand(MME1536 * device_instance, int * operand_data, int operand, int length){
+	const MME1536_SizeOps * ops = MME1536_OpsOf(length);
+	
+	if(ops == NULL){
+		printf("[ERROR] MME1536: SetOperand() -> wrong operand length (%d)\n", length);
+		return -1;
+	}
+	
+	return ops->set_operand(device_instance, operand_data, operand);
+}
+
+/** Write an operand to the core's memory (length defined by m which was
+ * previously set in UpdateModulus()
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param operand sets the memory location where the operand data will be
+ *        stored (OPERAND_0 to OPERAND_3).
+ * @param operand_data is an array containing the operand
+ * 
+ * @return nothing
+ */
+int MME1536_SetOperand_m(MME1536 * device_instance, int * operand_data, int operand){
+	if(device_instance->ops == NULL){
+		printf("[ERROR] MME1536: SetOperand_m() -> no modulus set\n");
+		return -1;
+	}
+	
+	return device_instance->ops->set_operand(device_instance, operand_data, operand);
+}
+
+/** Hash a modulus, e.g. to find a core that has it loaded already.
+ * 
+ * @param m is an array containing the modulus
+ * @param n is the length of the modulus in bits
+ * 
+ * @return a 32-bit FNV-1a hash of the modulus words and n
+ */
+unsigned int MME1536_ModulusHash(int * m, int n){
+	unsigned int hash = 2166136261u;
+	int word, byte;
+	
+	for(word=0; word<(n/32); word++){
+		for(byte=0; byte<4; byte++){
+			hash ^= ((unsigned)m[word] >> (byte*8)) & 0xff;
+			hash *= 16777619u;
+		}
+	}
+	hash ^= (unsigned)n;
+	hash *= 16777619u;
+	
+	return hash;
+}
+
+/** Get the hit and miss counts of the modulus cache.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param hits, misses are pointers to where the counts will be stored
+ * 
+ * @return nothing
+ */
+void MME1536_GetCacheStats(MME1536 * device_instance, unsigned long * hits, unsigned long * misses){
+	*hits = device_instance->ctx_hits;
+	*misses = device_instance->ctx_misses;
+}
+
+/** Enable or disable the instrumentation counters of a handle (see
+ * MME1536_GetStats()). When disabled, the driver only tests a flag; when
+ * the driver is compiled with MME1536_NO_STATS not even that, and only the
+ * timeout count is kept.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param enable is 1 to collect counters, 0 to stop
+ * 
+ * @return 0 upon success
+ *         -1 if the driver was compiled without instrumentation
+ */
+int MME1536_SetStats(MME1536 * device_instance, int enable){
+#ifdef MME1536_NO_STATS
+	if(enable){
+		printf("[ERROR] MME1536: SetStats() -> compiled with MME1536_NO_STATS\n");
+		return -1;
+	}
+#endif
+	device_instance->stats_enabled = (enable != 0);
+	device_instance->stats_phase = -1;
+	
+	return 0;
+}
+
+/** Take a snapshot of the instrumentation counters, e.g. to export them.
+ * Call it from the thread that uses the handle (or the owner thread of
+ * MME1536_MtStart()) for a consistent copy.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param snapshot is a pointer to where the counters will be copied
+ * 
+ * @return nothing
+ */
+void MME1536_GetStats(MME1536 * device_instance, MME1536_Stats * snapshot){
+	memcpy(snapshot, &(device_instance->stats), sizeof(MME1536_Stats));
+}
+
+/** Clear the instrumentation counters.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return nothing
+ */
+void MME1536_ResetStats(MME1536 * device_instance){
+	memset(&(device_instance->stats), 0, sizeof(MME1536_Stats));
+}
+
+/** Get a latency percentile from a snapshot (see MME1536_GetStats()).
+ * 
+ * @param snapshot is a pointer to the counters
+ * @param p is the percentile (0 .. 100)
+ * 
+ * @return the lowest latency of the bucket the percentile falls in (ns,
+ *         within 1/2^STATS_HIST_SUB_BITS of the exact value)
+ *         0 if no latencies were recorded
+ */
+unsigned long long MME1536_StatsPercentile(MME1536_Stats * snapshot, double p){
+	unsigned long long total = 0, seen = 0, target;
+	int i;
+	
+	for(i=0; i<STATS_HIST_BUCKETS; i++){
+		total += snapshot->latency_hist[i];
+	}
+	if(total == 0) return 0;
+	
+	target = (unsigned long long)(p / 100.0 * total + 0.5);
+	if(target < 1) target = 1;
+	if(target > total) target = total;
+	for(i=0; i<STATS_HIST_BUCKETS; i++){
+		seen += snapshot->latency_hist[i];
+		if(seen >= target) break;
+	}
+	
+	return MME1536_StatsBucketValue(i);
+}
+
+/** Get the lowest latency of a histogram bucket. The buckets are linear up
+ * to 2^STATS_HIST_SUB_BITS ns, then each power of two is split in
+ * 2^STATS_HIST_SUB_BITS buckets; the last one holds everything above.
+ * 
+ * @param bucket is the index in latency_hist
+ * 
+ * @return the latency (ns)
+ */
+unsigned long long MME1536_StatsBucketValue(int bucket){
+	int sub = 1 << STATS_HIST_SUB_BITS;
+	int e;
+	
+	if(bucket < sub) return (unsigned long long)bucket;
+	e = (bucket >> STATS_HIST_SUB_BITS) + STATS_HIST_SUB_BITS - 1;
+	
+	return (unsigned long long)(sub + (bucket & (sub-1))) << (e - STATS_HIST_SUB_BITS);
+}
+
+/** Reserve the job buffers of a handle: depth buffers holding a result,
+ * bases and modulus of up to BITS_TOT bits, room for two exponents of up
+ * to t bits and their fifo encoding, and a job descriptor. They are
+ * allocated as one cache line aligned block, so jobs taken from the arena
+ * (see MME1536_ArenaBorrow()) never go through the allocator. The
+ * initialisation reserves DEFAULT_ARENA_DEPTH buffers for DEFAULT_ARENA_T
+ * bit exponents.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param depth is the nr. of buffers (1 .. ARENA_MAX_DEPTH), e.g. the
+ *        queue depth of the caller
+ * @param t is the longest exponent (#bits, multiple of 32)
+ * 
+ * @return 0 upon success
+ *         -1 upon failure (the previous buffers are kept)
+ */
+int MME1536_ArenaInit(MME1536 * device_instance, int depth, int t){
+	MME1536_Arena * arena = &(device_instance->arena);
+	size_t exp_bytes, image_bytes, stride;
+	void * block;
+	int i;
+	
+	if((depth <= 0) || (depth > ARENA_MAX_DEPTH)){
+		printf("[ERROR] MME1536: ArenaInit() -> depth %d is not in [1, %d].\n", depth, ARENA_MAX_DEPTH);
+		return -1;
+	}
+	if((t <= 0) || ((t%32)!=0)){
+		printf("[ERROR] MME1536: ArenaInit() -> exponent length %d, is no multiple of 32.\n", t);
+		return -1;
+	}
+	if((arena->block != NULL) && (arena->free_mask != MME1536_ArenaMask(arena->depth))){
+		printf("[ERROR] MME1536: ArenaInit() -> job buffers are still borrowed.\n");
+		return -1;
+	}
+	
+	// one buffer: the operands, both exponents and their image
+	exp_bytes = MME1536_AlignLine((t/32) * sizeof(int));
+	image_bytes = MME1536_AlignLine(sizeof(MME1536_ExpImage) + (t/16) * sizeof(unsigned));
+	stride = MME1536_AlignLine(sizeof(MME1536_JobBuf)) + 2*exp_bytes + image_bytes;
+	if(posix_memalign(&block, CACHE_LINE, depth * stride) != 0){
+		printf("[ERROR] MME1536: ArenaInit() -> could not allocate memory for %d job buffers.\n", depth);
+		return -1;
+	}
+	for(i=0; i<depth; i++){
+		MME1536_JobBuf * buf = (MME1536_JobBuf *)((char *)block + i*stride);
+		char * tail = (char *)buf + MME1536_AlignLine(sizeof(MME1536_JobBuf));
+		
+		buf->e0 = (int *)tail;
+		buf->e1 = (int *)(tail + exp_bytes);
+		buf->image = (MME1536_ExpImage *)(tail + 2*exp_bytes);
+		buf->image->t = 0;
+		buf->image->entries = 0;
+		buf->image->capacity = t/16;
+		buf->index = i;
+	}
+	
+	free(arena->block);
+	arena->block = block;
+	arena->depth = depth;
+	arena->t = t;
+	arena->stride = stride;
+	arena->free_mask = MME1536_ArenaMask(depth);
+	
+	return 0;
+}
+
+/** Take a free job buffer from the arena of a handle (see
+ * MME1536_ArenaInit()). Lock free, so threads feeding the same handle can
+ * share its arena.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return a pointer to the buffer (give back with MME1536_ArenaReturn())
+ *         NULL when all buffers are in use
+ */
+MME1536_JobBuf * MME1536_ArenaBorrow(MME1536 * device_instance){
+	MME1536_Arena * arena = &(device_instance->arena);
+	unsigned long long mask;
+	int i;
+	
+	do{
+		mask = *((volatile unsigned long long *)&(arena->free_mask));
+		if(mask == 0) return NULL;
+		i = __builtin_ctzll(mask);
+	} while(!__sync_bool_compare_and_swap(&(arena->free_mask), mask, mask & ~(1ULL << i)));
+	
+	return (MME1536_JobBuf *)((char *)arena->block + i*arena->stride);
+}
+
+/** Give a job buffer back to the arena it was borrowed from.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param buf is a pointer returned by MME1536_ArenaBorrow()
+ * 
+ * @return nothing
+ */
+void MME1536_ArenaReturn(MME1536 * device_instance, MME1536_JobBuf * buf){
+	__sync_fetch_and_or(&(device_instance->arena.free_mask), 1ULL << buf->index);
+}
+
+/** Print some info about the hardware.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return nothing
+ * 
+ */
+void MME1536_PrintInfo(MME1536 * device_instance){
+	printf("[INFO] MME1536: Hardware info\n");
+	
+	printf(" Addres map:\n");
+	
+	printf("  op0: 0x%08x\n", device_instance->data_ptr + OP0_OFFSET);
+	printf("  op1: 0x%08x\n", device_instance->data_ptr + OP1_OFFSET);
+	printf("  op2: 0x%08x\n", device_instance->data_ptr + OP2_OFFSET);
+	printf("  op3: 0x%08x\n", device_instance->data_ptr + OP3_OFFSET);
+	printf("  m:   0x%08x\n", device_instance->data_ptr + M_OFFSET);
+	printf("  exp: 0x%08x\n", device_instance->data_ptr + FIFO_OFFSET);
+	
+	printf(" Pipeline info:\n");
+	printf("  total nr. words:     %d\n", WORDS_TOT);
+	printf("  low part nr. words:  %d\n", WORDS_LOW);
+	printf("  high part nr. words: %d\n", WORDS_HIGH);
+	printf("  upper part offset: 0x%08x\n", HIGH_OFFSET);
+}
+
+/** Read the core's operand memory and send to standard out.
+ *  (Debugging purposes only).
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * 
+ * @return nothing
+ * 
+ */
+void MME1536_PrintOperands(MME1536 * device_instance){
+	int data[WORDS_TOT];
+	int word;
+	
+	MME1536_GetData(device_instance, data, OP0_OFFSET, OPERAND_0, WORDS_TOT);
+	printf("OP0: ");
+	for(word=0;word<WORDS_TOT;word++){
+		printf("%08x", data[WORDS_TOT-1-word]);
+	}
+	printf("\n");
+	
+	MME1536_GetData(device_instance, data, OP1_OFFSET, OPERAND_1, WORDS_TOT);
+	printf("OP1: ");
+	for(word=0;word<WORDS_TOT;word++){
+		printf("%08x", data[WORDS_TOT-1-word]);
+	}
+	printf("\n");
+	
+	MME1536_GetData(device_instance, data, OP2_OFFSET, OPERAND_2, WORDS_TOT);
+	printf("OP2: ");
+	for(word=0;word<WORDS_TOT;word++){
+		printf("%08x", data[WORDS_TOT-1-word]);
+	}
+	printf("\n");
+	
+	MME1536_GetData(device_instance, data, OP3_OFFSET, OPERAND_3, WORDS_TOT);
+	printf("OP3: ");
+	for(word=0;word<WORDS_TOT;word++){
+		printf("%08x", data[WORDS_TOT-1-word]);
+	}
+	printf("\n");
+}
+
+/** Read an operand from the core's memory.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param operand_data is a pointer to a buffer where the operand will
+ *        be stored.
+ * @param operand specifies the operand to read from the memory
+ *        (OPERAND_0 to OPERAND_3)
+ * @param length is the length op the operand (#bits)
+ * 
+ * @return nothing
+ */
+int MME1536_GetOperand(MME1536 * device_instance, int * operand_data, int operand, int length){
+	const MME1536_SizeOps * ops = MME1536_OpsOf(length);
+	
+	if(ops == NULL){
+		printf("[ERROR] MME1536: GetOperand() -> wrong operand length (%d)\n", length);
+		return -1;
+	}
+	
+	return ops->get_operand(device_instance, operand_data, operand);
+}
+
+/** Read an operand from the core's memory.
+ * 
+ * @param device_instance is a pointer to a MME1536 variable
+ *        associated with the hardware.
+ * @param operand_data is a pointer to a buffer where the operand will
+ *        be stored.
+ * @param operand specifies the operand to read from the memory
+ *        (OPERAND_0 to OPERAND_3)
+ * 
+ * @return nothing
+ */
+int MME1536_GetOperand_m(MME1536 * device_instance, int * operand_data, int operand){
+	if(device_instance->ops == NULL){
+		printf("[ERROR] MME1536: GetOperand_m() -> no modulus set\n");
+		return -1;
+	}
+	
+	return device_instance->ops->get_operand(device_instance, operand_data, operand);
+}
+
+/******************************************************************************
+ * Low-level Function Source                                                  *
+ ******************************************************************************/
+
+/** Write one exponent fifo entry, to the core or to the backend.
+ */
+static inline void MME1536_FifoWrite(MME1536 * device_instance, volatile unsigned * fifo, unsigned entry){
+	if(device_instance->backend != NULL) device_instance->backend->fifo_push(device_instance, entry);
+	else *fifo = entry;
+}
+
+/** Operand engine.
+ * The transfer and operand functions below are written once for any operand
+ * length and stamped out for 512, 1024 and 1536 bits by
+ * MME1536_SIZE_ENGINE(). In each instance the length and everything
+ * derived from it (words, offsets, regions) is a compile-time constant, so
+ * the length switches fold away and the word copies have a constant count
+ * the compiler can unroll. MME1536_OpsOf() picks the instance once, when a
+ * modulus is set or a command list step is recorded.
+ */
+static inline void MME1536_TransferWrite(MME1536 * device_instance, int offset, int * from, const int words){
+	volatile void * to = device_instance->data_ptr + offset;
+	switch(device_instance->transfer){
+#ifdef __ARM_NEON
+		case TRANSFER_NEON: {
+			MME1536_WriteWordsNeon(to, from, words);
+		} break;
+#endif
+		case TRANSFER_64: {
+			MME1536_WriteWords64(to, from, words);
+		} break;
+		default: {
+			MME1536_WriteWords32(to, from, words);
+		} break;
+	}
+}
+
+static inline void MME1536_TransferRead(MME1536 * device_instance, int * to, int offset, const int words){
+	volatile void * from = device_instance->data_ptr + offset;
+	switch(device_instance->transfer){
+#ifdef __ARM_NEON
+		case TRANSFER_NEON: {
+			MME1536_ReadWordsNeon(to, from, words);
+		} break;
+#endif
+		case TRANSFER_64: {
+			MME1536_ReadWords64(to, from, words);
+		} break;
+		default: {
+			MME1536_ReadWords32(to, from, words);
+		} break;
+	}
+}
+
+static inline void MME1536_GetData(MME1536 * device_instance, int * buffer, int offset_start, int operand, const int words){
+	int control = 0x00000000;
+	// the words may still be on their way
+	MME1536_DmaSync(device_instance);
+	// set destination bits in the control register
+	// (necessary for reading from the correct location), unless they
+	// select the operand already
+	if(((device_instance->ctrl_shadow >> DEST_BITS) & 0x3) != (unsigned)operand){
+		control |= (operand << DEST_BITS); 
+		*((volatile unsigned *)(device_instance->ctrl_ptr)) = control;
+		device_instance->ctrl_shadow = control;
+		// the reads must not pass the control register write
+		MME1536_DataBarrier(device_instance);
+	}
+	else if(device_instance->mapping & MAPPING_WC){
+		// nor, on a buffered mapping, the interrupt
+		MME1536_DataBarrier(device_instance);
+	}
+	// read all words
+	MME1536_TransferRead(device_instance, buffer, offset_start, words);
+}
+
+static inline void MME1536_SetData(MME1536 * device_instance, int * data, int start_offset, const int words){
+	int bytes = words * ADDR_STEP;
+	// a transfer in flight to these words would overwrite them
+	MME1536_DmaClaim(device_instance, start_offset, bytes);
+	if(device_instance->dma_fd >= 0 && words >= DMA_MIN_WORDS){
+		memcpy(device_instance->dma_buf + start_offset, data, bytes);
+		MME1536_DmaStart(device_instance, start_offset, bytes, 0);
+		return;
+	}
+	// write all words (MME1536_PulseStart() orders them before the start bit)
+	MME1536_TransferWrite(device_instance, start_offset, data, words);
+}
+
+/** Write an operand of n bits (see MME1536_SetOperand()).
+ */
+static inline int MME1536_SetOperandN(MME1536 * device_instance, int * operand_data, int operand, const int n){
+	const int words = n / 32;
+	const int first = (n == BITS_HIGH) ? WORDS_LOW : 0; // first word of the value
+	int address_offset;
+	
+	if((operand < OPERAND_0) || (operand > MODULUS)){
+		printf("[ERROR] MME1536: SetOperand() -> wrong operand (%d)\n", operand);
+		return -1;
+	}
+	address_offset = operand_offsets[operand];
+	// the caller records which modulus this is
+	if(operand == MODULUS) device_instance->loaded_ctx = NULL;
+	
+	// write the data straight from the caller's buffer into its part of the
+	// operand, and clear the other part only if it may hold data (in split
+	// pipeline mode it is left as is); nothing is written if the operand
+	// already holds the value
+	int * dirty = &(device_instance->dirty[operand]);
+	int * res_n = device_instance->res_n[operand];
+	int * res_value = device_instance->res_value[operand];
+	int split = device_instance->split_pipeline;
+	if(n == BITS_TOT){
+		if((res_n[0] == BITS_TOT) && (res_n[1] == BITS_TOT)
+		   && (memcmp(res_value, operand_data, words * sizeof(int)) == 0)){
+			return 0;
+		}
+		MME1536_SetData(device_instance, operand_data, address_offset, words);
+		*dirty = REGION_LOW | REGION_HIGH;
+		res_n[0] = BITS_TOT;
+		res_n[1] = BITS_TOT;
+	}
+	else{
+		// own part (0 = low, 1 = high) and the other part of the operand
+		const int own = (n == BITS_HIGH);
+		const int own_region = own ? REGION_HIGH : REGION_LOW;
+		const int other_region = own ? REGION_LOW : REGION_HIGH;
+		const int other_first = own ? 0 : WORDS_LOW;
+		if((res_n[own] == n) && (split || !(*dirty & other_region))
+		   && (memcmp(res_value + first, operand_data, words * sizeof(int)) == 0)){
+			return 0;
+		}
+		// store data in its part (rest is zero)
+		MME1536_SetData(device_instance, operand_data, address_offset + first * ADDR_STEP, words);
+		if(!split && (*dirty & other_region)){
+			MME1536_SetData(device_instance, zero, address_offset + other_first * ADDR_STEP, WORDS_TOT - words);
+			*dirty &= ~other_region;
+			res_n[!own] = 0;
+		}
+		*dirty |= own_region;
+		res_n[own] = n;
+		if(res_n[!own] == BITS_TOT) res_n[!own] = 0;
+	}
+	memcpy(res_value + first, operand_data, words * sizeof(int));
+	device_instance->holder[operand] = NULL;
+	
+	return 0;
+}
+
+/** Read an operand of n bits (see MME1536_GetOperand()).
+ */
+static inline int MME1536_GetOperandN(MME1536 * device_instance, int * operand_data, int operand, const int n){
+	if((operand < OPERAND_0) || (operand > OPERAND_3)){
+		printf("[ERROR] MME1536: GetOperand() -> wrong operand (%d)\n", operand);
+		return -1;
+	}
+	
+	MME1536_GetData(device_instance, operand_data, operand_offsets[operand] + ((n == BITS_HIGH) ? HIGH_OFFSET : 0), operand, n / 32);
+	
+	return 0;
+}
+
+#define MME1536_SIZE_ENGINE(NAME, N) \
+int MME1536_SetOperand##NAME(MME1536 * device_instance, int * operand_data, int operand){ \
+	return MME1536_SetOperandN(device_instance, operand_data, operand, N); \
+} \
+int MME1536_GetOperand##NAME(MME1536 * device_instance, int * operand_data, int operand){ \
+	return MME1536_GetOperandN(device_instance, operand_data, operand, N); \
+}
+
+MME1536_SIZE_ENGINE(Low, BITS_LOW)
+MME1536_SIZE_ENGINE(High, BITS_HIGH)
+MME1536_SIZE_ENGINE(Tot, BITS_TOT)
+
+static const MME1536_SizeOps size_ops[3] = {
+	{BITS_LOW, WORDS_LOW, LOW_PART, REGION_LOW, MME1536_SetOperandLow, MME1536_GetOperandLow},
+	{BITS_HIGH, WORDS_HIGH, HIGH_PART, REGION_HIGH, MME1536_SetOperandHigh, MME1536_GetOperandHigh},
+	{BITS_TOT, WORDS_TOT, TOT_PIPELINE, REGION_LOW | REGION_HIGH, MME1536_SetOperandTot, MME1536_GetOperandTot}
+};
+
+/** Get the engine instance for an operand length.
+ * 
+ * @return a pointer to the functions and constants of the length
+ *         NULL for a wrong length
+ */
+const MME1536_SizeOps * MME1536_OpsOf(int n){
+	if((n <= 0) || (n > BITS_TOT) || ((n % BITS_LOW) != 0)) return NULL;
+	return &(size_ops[n / BITS_LOW - 1]);
+}
+
+/** Operand memory transfer paths.
+ * A path moves whole words between a host buffer (any int alignment) and
+ * the core's memory. The wide paths use 32-bit accesses up to the first
+ * aligned address and for the remaining words. Ordering against the control
+ * register is left to the callers.
+ */
+void MME1536_WriteWords32(volatile void * to, int * from, int words){
+	volatile unsigned * word_ptr = (volatile unsigned *)to;
+	int word;
+	for(word=0;word<words;word++){
+		word_ptr[word] = from[word];
+	}
+}
+
+void MME1536_ReadWords32(int * to, volatile void * from, int words){
+	volatile unsigned * word_ptr = (volatile unsigned *)from;
+	int word;
+	for(word=0;word<words;word++){
+		to[word] = word_ptr[word];
+	}
+}
+
+void MME1536_WriteWords64(volatile void * to, int * from, int words){
+	volatile unsigned * word_ptr = (volatile unsigned *)to;
+	uint64_t pair;
+	int word = 0;
+	if((((uintptr_t)word_ptr) & 7) != 0 && words > 0){
+		word_ptr[0] = from[0];
+		word = 1;
+	}
+	for(;word+2<=words;word+=2){
+		// the host buffer may only be 4-byte aligned
+		memcpy(&pair, &from[word], sizeof(pair));
+		*((volatile uint64_t *)&word_ptr[word]) = pair;
+	}
+	if(word < words){
+		word_ptr[word] = from[word];
+	}
+}
+
+void MME1536_ReadWords64(int * to, volatile void * from, int words){
+	volatile unsigned * word_ptr = (volatile unsigned *)from;
+	uint64_t pair;
+	int word = 0;
+	if((((uintptr_t)word_ptr) & 7) != 0 && words > 0){
+		to[0] = word_ptr[0];
+		word = 1;
+	}
+	for(;word+2<=words;word+=2){
+		pair = *((volatile uint64_t *)&word_ptr[word]);
+		memcpy(&to[word], &pair, sizeof(pair));
+	}
+	if(word < words){
+		to[word] = word_ptr[word];
+	}
+}
+
+#ifdef __ARM_NEON
+/* NEON intrinsics take no volatile pointers: the compiler barriers keep the
+ * 128-bit accesses from being merged with, or moved across, the surrounding
+ * 32-bit accesses.
+ */
+void MME1536_WriteWordsNeon(volatile void * to, int * from, int words){
+	volatile unsigned * word_ptr = (volatile unsigned *)to;
+	int word = 0;
+	while(word < words && (((uintptr_t)&word_ptr[word]) & 15) != 0){
+		word_ptr[word] = from[word];
+		word++;
+	}
+	__asm__ __volatile__("" ::: "memory");
+	for(;word+4<=words;word+=4){
+		vst1q_u32((uint32_t *)&word_ptr[word], vld1q_u32((uint32_t *)&from[word]));
+	}
+	__asm__ __volatile__("" ::: "memory");
+	for(;word<words;word++){
+		word_ptr[word] = from[word];
+	}
+}
+
+void MME1536_ReadWordsNeon(int * to, volatile void * from, int words){
+	volatile unsigned * word_ptr = (volatile unsigned *)from;
+	int word = 0;
+	while(word < words && (((uintptr_t)&word_ptr[word]) & 15) != 0){
+		to[word] = word_ptr[word];
+		word++;
+	}
+	__asm__ __volatile__("" ::: "memory");
+	for(;word+4<=words;word+=4){
+		vst1q_u32((uint32_t *)&to[word], vld1q_u32((uint32_t *)&word_ptr[word]));
+	}
+	__asm__ __volatile__("" ::: "memory");
+	for(;word<words;word++){
+		to[word] = word_ptr[word];
+	}
+}
+#endif
+
+/** Select a transfer path without checking it.
+ * 
+ * @return 0 upon success
+ *         -1 if the path is not built in
+ */
+int MME1536_UseTransfer(MME1536 * device_instance, int mode){
+	switch(mode){
+		case TRANSFER_32:
+		case TRANSFER_64:
+#ifdef __ARM_NEON
+		case TRANSFER_NEON:
+#endif
+			break;
+		default: {
+			return -1;
+		} break;
+	}
+	device_instance->transfer = mode;
+	
+	return 0;
+}
+
+/** Check a transfer path against the 32-bit path and select it if it works.
+ * A pattern is written with the path and read back with 32-bit reads, and
+ * the other way around. A core that answers the wide accesses with a bus
+ * error (SIGBUS) fails the probe.
+ * 
+ * @return 0 upon success
+ *         -1 upon failure (the current path is kept)
+ */
+int MME1536_ProbeTransfer(MME1536 * device_instance, int mode){
+	volatile int previous = device_instance->transfer;
+	int pattern[8], readback[8];
+	struct sigaction fault, old_fault;
+	volatile int works = 0;
+	int word;
+	
+	if(MME1536_UseTransfer(device_instance, mode) != 0){
+		return -1;
+	}
+	if(mode == TRANSFER_32){
+		return 0;
+	}
+	
+	for(word=0;word<8;word++){
+		pattern[word] = 0xa5000000 | (mode << 16) | (word << 8) | (~word & 0xff);
+	}
+	
+	memset(&fault, 0, sizeof(fault));
+	fault.sa_handler = MME1536_ProbeFault;
+	sigemptyset(&fault.sa_mask);
+	sigaction(SIGBUS, &fault, &old_fault);
+	if(sigsetjmp(probe_fault, 1) == 0){
+		// wide writes, 32-bit reads
+		MME1536_SetData(device_instance, pattern, OP0_OFFSET, 8);
+		__sync_synchronize();
+		MME1536_UseTransfer(device_instance, TRANSFER_32);
+		MME1536_GetData(device_instance, readback, OP0_OFFSET, OPERAND_0, 8);
+		if(memcmp(pattern, readback, sizeof(pattern)) == 0){
+			// 32-bit writes, wide reads
+			for(word=0;word<8;word++){
+				pattern[word] = ~pattern[word];
+			}
+			MME1536_SetData(device_instance, pattern, OP0_OFFSET, 8);
+			__sync_synchronize();
+			MME1536_UseTransfer(device_instance, mode);
+			MME1536_GetData(device_instance, readback, OP0_OFFSET, OPERAND_0, 8);
+			works = (memcmp(pattern, readback, sizeof(pattern)) == 0);
+		}
+	}
+	sigaction(SIGBUS, &old_fault, NULL);
+	
+	MME1536_Written(device_instance, OPERAND_0, REGION_LOW);
+	MME1536_UseTransfer(device_instance, works ? mode : previous);
+	
+	return works ? 0 : -1;
+}
+
+void MME1536_ProbeFault(int signal){
+	(void)signal;
+	siglongjmp(probe_fault, 1);
+}
+
+/** Start a new exponent: the first entries (up to the fifo depth) are
+ * written by the caller, the rest is streamed (see MME1536_FifoRefill()).
+ * 
+ * @return the nr. of entries to write now
+ *         -1 if the exponent does not fit and streaming is off
+ */
+int MME1536_FifoBegin(MME1536 * device_instance, int * e0, int * e1, unsigned * image, int entries){
+	int count = entries;
+	
+	// the wait budget of the auto-run depends on it
+	device_instance->exp_entries = entries;
+
+	if(count > device_instance->fifo_depth){
+		if(!device_instance->fifo_streaming){
+			printf("[ERROR] MME1536: SetExponent() -> exponent of %d fifo entries does not fit the fifo (%d entries).\n", entries, device_instance->fifo_depth);
+			return -1;
+		}
+		count = device_instance->fifo_depth;
+		MME1536_FifoClearNoPush(device_instance);
+	}
+	if(device_instance->stream_next < device_instance->stream_count){
+		printf("[WARNING] MME1536: SetExponent() -> previous exponent was not streamed completely\n");
+	}
+	device_instance->stream_e0 = e0;
+	device_instance->stream_e1 = e1;
+	device_instance->stream_image = image;
+	device_instance->stream_words = entries/2;
+	device_instance->stream_next = count;
+	device_instance->stream_count = entries;
+	
+	return count;
+}
+
+/** Encode exponent words words-1 down to first into fifo entries.
+ */
+void MME1536_FifoEncode(unsigned * entry, int * e0, int * e1, int words, int first){
+	int i;
+	
+	if(e1==NULL){
+		for(i=(words-1); i>=first; i--){
+			*(entry++) = ((e0[i] & 0xffff0000) >> 16);
+			*(entry++) = (e0[i] & 0x0000ffff);
+		}
+	}
+	else{
+		for(i=(words-1); i>=first; i--){
+			*(entry++) = (e1[i] & 0xffff0000) | ((e0[i] & 0xffff0000) >> 16);
+			*(entry++) = ((e1[i] & 0x0000ffff) << 16) | (e0[i] & 0x0000ffff);
+		}
+	}
+}
+
+/** Fifo entry k of the streamed exponent.
+ */
+unsigned MME1536_FifoEntry(MME1536 * device_instance, int k){
+	int * e0 = device_instance->stream_e0;
+	int * e1 = device_instance->stream_e1;
+	int i = device_instance->stream_words - 1 - k/2;
+	
+	if(device_instance->stream_image != NULL){
+		return device_instance->stream_image[k];
+	}
+	if((k % 2) == 0){
+		if(e1==NULL) return ((e0[i] & 0xffff0000) >> 16);
+		return (e1[i] & 0xffff0000) | ((e0[i] & 0xffff0000) >> 16);
+	}
+	if(e1==NULL) return (e0[i] & 0x0000ffff);
+	return ((e1[i] & 0x0000ffff) << 16) | (e0[i] & 0x0000ffff);
+}
+
+/** Write fifo entries of the streamed exponent until the core drops one.
+ * 
+ * @return the nr. of entries still to write (0 when done)
+ */
+int MME1536_FifoRefill(MME1536 * device_instance){
+	volatile unsigned * fifo = (volatile unsigned *)(device_instance->data_ptr + FIFO_OFFSET);
+	volatile unsigned * isr = (volatile unsigned *)(device_instance->ctrl_ptr + MME1536_INTR_IPISR_OFFSET);
+	
+	// the prefill may still be on its way
+	MME1536_DmaClaim(device_instance, FIFO_OFFSET, PAGE_SIZE);
+	
+	while(device_instance->stream_next < device_instance->stream_count){
+		MME1536_FifoWrite(device_instance, fifo, MME1536_FifoEntry(device_instance, device_instance->stream_next));
+		// the status read must not pass the fifo write
+		__sync_synchronize();
+		if((*isr & IPISR_FIFO_NOPUSH) != 0){
+			// fifo full, entry dropped: retry next time
+			*isr = IPISR_FIFO_NOPUSH;
+			break;
+		}
+		device_instance->stream_next++;
+	}
+	
+	return device_instance->stream_count - device_instance->stream_next;
+}
+
+/** Called on each interrupt: the end of an auto-run must also be the end
+ * of the streamed exponent.
+ */
+void MME1536_FifoCheck(MME1536 * device_instance){
+	if(device_instance->stream_auto && (device_instance->stream_next < device_instance->stream_count)){
+		printf("[ERROR] MME1536: exponent fifo ran empty, %d fifo entries not used\n", device_instance->stream_count - device_instance->stream_next);
+		device_instance->stream_next = device_instance->stream_count;
+	}
+	device_instance->stream_auto = 0;
+}
+
+/** Clear a dropped fifo write flagged before streaming starts.
+ */
+void MME1536_FifoClearNoPush(MME1536 * device_instance){
+	volatile unsigned * isr = (volatile unsigned *)(device_instance->ctrl_ptr + MME1536_INTR_IPISR_OFFSET);
+	
+	if((*isr & IPISR_FIFO_NOPUSH) != 0){
+		*isr = IPISR_FIFO_NOPUSH;
+	}
+}
+
+/** Read the physical address of a u-dma-buf (or older udmabuf) buffer.
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_DmaReadPhys(char * buffer_dev, unsigned long * phys){
+	static char * classes[2] = {"u-dma-buf", "udmabuf"};
+	char path[128], value[32];
+	char * name = strrchr(buffer_dev, '/');
+	int i, fd, length;
+	
+	name = (name == NULL) ? buffer_dev : name + 1;
+	for(i=0;i<2;i++){
+		snprintf(path, sizeof(path), "/sys/class/%s/%s/phys_addr", classes[i], name);
+		fd = open(path, O_RDONLY);
+		if(fd < 0){
+			continue;
+		}
+		length = read(fd, value, sizeof(value) - 1);
+		close(fd);
+		if(length <= 0){
+			return -1;
+		}
+		value[length] = '\0';
+		*phys = strtoul(value, NULL, 0);
+		return 0;
+	}
+	
+	return -1;
+}
+
+/** Reset the CDMA controller (clears errors and the keyhole setting).
+ */
+void MME1536_DmaReset(MME1536 * device_instance){
+	volatile unsigned * cr = (volatile unsigned *)(device_instance->dma_ptr + CDMA_CR_OFFSET);
+	int poll;
+	
+	*cr = CDMA_CR_RESET;
+	for(poll=0; poll<1000 && (*cr & CDMA_CR_RESET) != 0; poll++);
+}
+
+/** Send bytes from the staging buffer to the same offset in the core's data
+ * memory, or all to FIFO_OFFSET if keyhole is set.
+ */
+void MME1536_DmaStart(MME1536 * device_instance, int offset, int bytes, int keyhole){
+	volatile unsigned * cdma = (volatile unsigned *)(device_instance->dma_ptr);
+	unsigned long destination = device_instance->data_base + (keyhole ? FIFO_OFFSET : offset);
+	
+	// one transfer at a time (simple mode)
+	MME1536_DmaSync(device_instance);
+	
+	// control register changes are only allowed while idle
+	if(keyhole){
+		cdma[CDMA_CR_OFFSET/4] |= CDMA_CR_KEYHOLE_WRITE;
+	}
+	else{
+		cdma[CDMA_CR_OFFSET/4] &= ~CDMA_CR_KEYHOLE_WRITE;
+	}
+	// the staging buffer writes must be visible before the transfer starts
+	__sync_synchronize();
+	cdma[CDMA_SA_OFFSET/4] = device_instance->dma_buf_phys + offset;
+	cdma[CDMA_DA_OFFSET/4] = destination;
+	cdma[CDMA_BTT_OFFSET/4] = bytes;
+	
+	device_instance->dma_busy_offset = offset;
+	device_instance->dma_busy_bytes = bytes;
+	device_instance->dma_busy_keyhole = keyhole;
+}
+
+/** Wait for the transfer in flight if it overlaps [offset, offset+bytes).
+ */
+void MME1536_DmaClaim(MME1536 * device_instance, int offset, int bytes){
+	if(device_instance->dma_busy_bytes == 0){
+		return;
+	}
+	if(offset < device_instance->dma_busy_offset + device_instance->dma_busy_bytes
+	   && device_instance->dma_busy_offset < offset + bytes){
+		MME1536_DmaSync(device_instance);
+	}
+}
+
+/** Wait for the transfer in flight. If it fails or does not finish in
+ * CDMA_TIMEOUT_US the cpu writes the data from the staging buffer instead.
+ * 
+ * @return 0 upon success
+ *         -1 if the data had to be written by the cpu
+ */
+int MME1536_DmaSync(MME1536 * device_instance){
+	volatile unsigned * sr;
+	struct timespec deadline;
+	unsigned status;
+	int offset, word, words;
+	
+	if(device_instance->dma_busy_bytes == 0){
+		return 0;
+	}
+	
+	sr = (volatile unsigned *)(device_instance->dma_ptr + CDMA_SR_OFFSET);
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	MME1536_TimeAddUs(&deadline, CDMA_TIMEOUT_US);
+	while(((status = *sr) & CDMA_SR_IDLE) == 0){
+		if(MME1536_TimeLeftUs(&deadline) <= 0){
+			break;
+		}
+	}
+	
+	offset = device_instance->dma_busy_offset;
+	words = device_instance->dma_busy_bytes / ADDR_STEP;
+	device_instance->dma_busy_bytes = 0;
+	if((status & CDMA_SR_IDLE) != 0 && (status & CDMA_SR_ERRORS) == 0){
+		return 0;
+	}
+	
+	printf("[ERROR] MME1536: DmaSync() -> transfer failed (status 0x%08x), writing %d words by cpu\n", status, words);
+	MME1536_DmaReset(device_instance);
+	if(device_instance->dma_busy_keyhole){
+		for(word=0;word<words;word++){
+			*((volatile unsigned *)(device_instance->data_ptr + FIFO_OFFSET))
+				= ((unsigned *)(device_instance->dma_buf + offset))[word];
+		}
+	}
+	else{
+		MME1536_TransferWrite(device_instance, offset, device_instance->dma_buf + offset, words);
+	}
+	
+	return -1;
+}
+
+/** Compute R2 = 2^(2n) mod m without GMP or heap memory.
+ */
+void MME1536_ComputeR2(int * R2, int * m, int n){
+	MME1536_ComputePow2(R2, m, n, 2 * n);
+}
+
+/** Compute 2^e mod m (e <= 2 * BITS_TOT) with a fixed-width long
+ * division (Knuth, algorithm D) of which only the remainder is kept.
+ * 
+ * @param result is an array of n/32 words for the result
+ * @param m is an array containing the modulus
+ * @param n is the length of the modulus in bits
+ * @param e is the power of 2
+ */
+void MME1536_ComputePow2(int * result, int * m, int n, int e){
+	unsigned int v[WORDS_TOT];         // normalised modulus
+	unsigned int u[2*WORDS_TOT + 2];   // normalised 2^e, becomes the remainder
+	unsigned long long qhat, rhat, p;
+	long long t, k;
+	int words = n / 32;
+	int vw, uw, shift;
+	int i, j;
+	
+	// significant words of m
+	for(vw=words; (vw>0) && (m[vw-1]==0); vw--);
+	if(vw == 0){
+		printf("[ERROR] MME1536: ComputePow2() -> modulus is zero\n");
+		return;
+	}
+	
+	// normalise: shift m (and 2^e) left until the top bit of m is set
+	shift = __builtin_clz((unsigned)m[vw-1]);
+	for(i=vw-1; i>0; i--){
+		v[i] = ((unsigned)m[i] << shift) | (shift ? ((unsigned)m[i-1] >> (32 - shift)) : 0);
+	}
+	v[0] = (unsigned)m[0] << shift;
+	
+	uw = (e + shift) / 32 + 1;
+	for(i=0; i<=uw; i++) u[i] = 0;
+	u[(e + shift) / 32] = 1u << ((e + shift) % 32);
+	
+	// divide, one quotient word at a time
+	for(j=uw-vw; j>=0; j--){
+		// estimate the quotient word
+		qhat = (((unsigned long long)u[j+vw] << 32) | u[j+vw-1]) / v[vw-1];
+		rhat = (((unsigned long long)u[j+vw] << 32) | u[j+vw-1]) % v[vw-1];
+		while((qhat >> 32) || ((vw > 1) && (qhat * v[vw-2] > ((rhat << 32) | u[j+vw-2])))){
+			qhat--;
+			rhat += v[vw-1];
+			if(rhat >> 32) break;
+		}
+		
+		// multiply and subtract
+		k = 0;
+		for(i=0; i<vw; i++){
+			p = qhat * v[i];
+			t = (long long)u[i+j] - k - (long long)(p & 0xffffffffULL);
+			u[i+j] = (unsigned int)t;
+			k = (long long)(p >> 32) - (t >> 32);
+		}
+		t = (long long)u[j+vw] - k;
+		u[j+vw] = (unsigned int)t;
+		
+		// estimate was one too big: add back
+		if(t < 0){
+			k = 0;
+			for(i=0; i<vw; i++){
+				t = (long long)u[i+j] + v[i] + k;
+				u[i+j] = (unsigned int)t;
+				k = t >> 32;
+			}
+			u[j+vw] += (unsigned int)k;
+		}
+	}
+	
+	// unnormalise the remainder
+	for(i=0; i<vw-1; i++){
+		result[i] = (int)((u[i] >> shift) | (shift ? (u[i+1] << (32 - shift)) : 0));
+	}
+	result[vw-1] = (int)(u[vw-1] >> shift);
+	for(i=vw; i<words; i++){
+		result[i] = 0;
+	}
+}
+
+void MME1536_EnableInterrupt(MME1536 * device_instance){
+	// Enable all interrupt sources from user logic.
+	*((unsigned *)(device_instance->ctrl_ptr + MME1536_INTR_IPIER_OFFSET)) = 0x00000001;
+
+	// Set global interrupt enable.
+	*((unsigned *)(device_instance->ctrl_ptr + MME1536_INTR_DGIER_OFFSET)) = INTR_GIE_MASK;
+}
+
+MME1536_Cmd * MME1536_CmdAppend(MME1536_CmdList * list, int type){
+	if(list->count >= CMD_LIST_MAX){
+		printf("[ERROR] MME1536: CmdAppend() -> command list full\n");
+		return NULL;
+	}
+	MME1536_Cmd * cmd = &(list->cmd[list->count++]);
+	int i;
+	
+	cmd->type = type;
+	switch(type){
+		case CMD_SINGLE:{
+			// behind an auto-run it post-processes the result
+			cmd->stats_phase = STATS_PRECOMPUTE;
+			for(i=0; i<list->count-1; i++){
+				if(list->cmd[i].type == CMD_AUTO) cmd->stats_phase = STATS_POSTCOMPUTE;
+			}
+		} break;
+		case CMD_AUTO:{
+			cmd->stats_phase = STATS_AUTO;
+		} break;
+		case CMD_READ:{
+			cmd->stats_phase = STATS_READBACK;
+		} break;
+		default:{
+			cmd->stats_phase = STATS_UPLOAD;
+		} break;
+	}
+	
+	return cmd;
+}
+
+/** Run the host steps of a command list up to the next core operation,
+ * start it, and then run the host steps behind it that don't conflict
+ * with it.
+ * 
+ * @return 1 if a core operation was started
+ *         0 if the end of the list was reached
+ */
+int MME1536_CmdIssue(MME1536 * device_instance, MME1536_CmdList * list, int * next){
+	MME1536_Cmd * running;
+	
+	if(STATS_ON(device_instance)) MME1536_StatsCoreDone(device_instance);
+	
+	// host steps in front of the next core operation
+	while((*next < list->count) && (list->cmd[*next].type != CMD_SINGLE)
+	      && (list->cmd[*next].type != CMD_AUTO)){
+		if(MME1536_CmdExecute(device_instance, &(list->cmd[*next])) != 0){
+			// a rejected step ends the list
+			list->error = -1;
+			*next = list->count;
+			return 0;
+		}
+		(*next)++;
+	}
+	if(*next >= list->count) return 0;
+	
+	// start the core
+	running = &(list->cmd[(*next)++]);
+	MME1536_CmdExecute(device_instance, running);
+	
+	// fill the gap while the core is busy
+	while((*next < list->count) && !MME1536_CmdConflicts(device_instance, running, &(list->cmd[*next]))){
+		if(MME1536_CmdExecute(device_instance, &(list->cmd[*next])) != 0){
+			list->error = -1;
+			*next = list->count;
+			break;
+		}
+		(*next)++;
+	}
+	
+	return 1;
+}
+
+/** Execute one step of a command list.
+ * 
+ * @return 0 upon success
+ *         -1 if the exponent was rejected
+ */
+int MME1536_CmdExecute(MME1536 * device_instance, MME1536_Cmd * cmd){
+	unsigned long long start_ns = 0;
+	int ret = 0;
+	
+	if(STATS_ON(device_instance)) start_ns = MME1536_StatsNow();
+	switch(cmd->type){
+		case CMD_SINGLE:{
+			MME1536_StartSingle(device_instance, cmd->p_sel, cmd->destination, cmd->x_op, cmd->y_op);
+		} break;
+		case CMD_AUTO:{
+			MME1536_StartAuto(device_instance, cmd->p_sel);
+		} break;
+		case CMD_LOAD:{
+			cmd->ops->set_operand(device_instance, cmd->data, cmd->operand);
+		} break;
+		case CMD_EXPONENT:{
+			if(cmd->image != NULL) ret = MME1536_SetExponentImage(device_instance, cmd->image);
+			else ret = MME1536_SetExponent(device_instance, cmd->e0, cmd->e1, cmd->t);
+		} break;
+		case CMD_READ:{
+			cmd->ops->get_operand(device_instance, cmd->data, cmd->operand);
+		} break;
+	}
+	if(STATS_ON(device_instance)){
+		if((cmd->type == CMD_SINGLE) || (cmd->type == CMD_AUTO)){
+			// counted when its interrupt is seen (MME1536_StatsCoreDone())
+			device_instance->stats_phase = cmd->stats_phase;
+			device_instance->stats_start_ns = start_ns;
+		}
+		else{
+			device_instance->stats.phase_ns[cmd->stats_phase] += MME1536_StatsNow() - start_ns;
+		}
+	}
+	
+	return ret;
+}
+
+/** Check the steps of a command list that can be rejected before anything
+ * is written to the core: exponents must be a multiple of 32 bits and,
+ * without fifo streaming, fit the fifo (see MME1536_FifoBegin()).
+ * 
+ * @return 0 upon success
+ *         -1 if the list would be rejected
+ */
+int MME1536_CmdCheck(MME1536 * device_instance, MME1536_CmdList * list){
+	MME1536_Cmd * cmd;
+	int i, t;
+	
+	for(i=0; i<list->count; i++){
+		cmd = &(list->cmd[i]);
+		if(cmd->type != CMD_EXPONENT) continue;
+		t = (cmd->image != NULL) ? cmd->image->t : cmd->t;
+		if((t%32)!=0){
+			printf("[ERROR] MME1536: CmdSubmit() -> exponent length %d, is no multiple of 32.\n", t);
+			return -1;
+		}
+		if(!device_instance->fifo_streaming && (t/16 > device_instance->fifo_depth)){
+			printf("[ERROR] MME1536: CmdSubmit() -> exponent of %d fifo entries does not fit the fifo (%d entries), enable fifo streaming.\n", t/16, device_instance->fifo_depth);
+			return -1;
+		}
+	}
+	
+	return 0;
+}
+
+/** Check whether a host step has to wait for a running core operation.
+ * Reads always wait, because they change the control register. In split
+ * pipeline mode a load into the other pipeline part never waits.
+ * 
+ * @return 1 if cmd can't be executed while running is busy
+ *         0 otherwise
+ */
+int MME1536_CmdConflicts(MME1536 * device_instance, MME1536_Cmd * running, MME1536_Cmd * cmd){
+	switch(cmd->type){
+		case CMD_LOAD:{
+			if(device_instance->split_pipeline
+			   && ((cmd->ops->regions & MME1536_RegionOf(running->p_sel)) == 0)){
+				return 0;
+			}
+			if(running->type == CMD_AUTO) return 1;
+			return (cmd->operand == MODULUS) || (cmd->operand == running->destination)
+			    || (cmd->operand == running->x_op) || (cmd->operand == running->y_op);
+		}
+		case CMD_EXPONENT:{
+			return (running->type == CMD_AUTO);
+		}
+		default:{
+			return 1;
+		}
+	}
+}
+
+/** Execute the host steps of a list that can go now: all up to the next
+ * core operation if the core is idle (running is NULL), else the ones
+ * that don't conflict with running. An exponent is only written when the
+ * fifo holds none of the other list.
+ */
+void MME1536_CmdHost(MME1536 * device_instance, MME1536_CmdList * list, int * next, MME1536_Cmd * running, int * fifo_owner, int self){
+	MME1536_Cmd * cmd;
+	
+	while(*next < list->count){
+		cmd = &(list->cmd[*next]);
+		if((cmd->type == CMD_SINGLE) || (cmd->type == CMD_AUTO)) break;
+		if((running != NULL) && MME1536_CmdConflicts(device_instance, running, cmd)) break;
+		if(cmd->type == CMD_EXPONENT){
+			if((*fifo_owner != -1) && (*fifo_owner != self)) break;
+			*fifo_owner = self;
+		}
+		if(MME1536_CmdExecute(device_instance, cmd) != 0){
+			list->error = -1;
+			*next = list->count;
+			return;
+		}
+		(*next)++;
+	}
+}
+
+/** Start the next core operation of two lists, taking turns, and fill the
+ * gap with the host steps of both (see MME1536_CmdSubmitPair()).
+ * 
+ * @param done is the operation that just completed (NULL if none)
+ * 
+ * @return the started operation
+ *         NULL if neither list has one left
+ */
+MME1536_Cmd * MME1536_CmdIssuePair(MME1536 * device_instance, MME1536_CmdList ** list, int * next, int * current, int * fifo_owner, MME1536_Cmd * done){
+	MME1536_Cmd * running = NULL;
+	int i, l;
+	
+	if(STATS_ON(device_instance)) MME1536_StatsCoreDone(device_instance);
+	
+	// an auto-run empties the fifo
+	if((done != NULL) && (done->type == CMD_AUTO)) *fifo_owner = -1;
+	
+	for(l=0; l<2; l++){
+		MME1536_CmdHost(device_instance, list[l], &(next[l]), NULL, fifo_owner, l);
+	}
+	
+	for(i=1; (i<=2) && (running == NULL); i++){
+		l = (*current + i) % 2;
+		if((next[l] < list[l]->count) && ((list[l]->cmd[next[l]].type == CMD_SINGLE)
+		                                  || (list[l]->cmd[next[l]].type == CMD_AUTO))){
+			running = &(list[l]->cmd[next[l]++]);
+			*current = l;
+		}
+	}
+	if(running == NULL) return NULL;
+	MME1536_CmdExecute(device_instance, running);
+	
+	// fill the gap while the core is busy
+	MME1536_CmdHost(device_instance, list[*current], &(next[*current]), running, fifo_owner, *current);
+	MME1536_CmdHost(device_instance, list[1 - *current], &(next[1 - *current]), running, fifo_owner, 1 - *current);
+	
+	return running;
+}
+
+/** Get the pipeline part used by all core operations and loads of a list.
+ * 
+ * @return LOW_PART, HIGH_PART or TOT_PIPELINE
+ *         0 if the list mixes parts
+ */
+int MME1536_CmdPartOf(MME1536_CmdList * list){
+	int part = 0;
+	int i, cmd_part;
+	
+	for(i=0; i<list->count; i++){
+		switch(list->cmd[i].type){
+			case CMD_SINGLE:
+			case CMD_AUTO:{
+				cmd_part = list->cmd[i].p_sel;
+			} break;
+			case CMD_LOAD:
+			case CMD_READ:{
+				cmd_part = list->cmd[i].ops->part;
+			} break;
+			default:{
+				continue;
+			}
+		}
+		if((cmd_part == 0) || ((part != 0) && (cmd_part != part))) return 0;
+		part = cmd_part;
+	}
+	
+	return part;
+}
+
+/** Record g0^e0 * g1^e1 mod m in a command list. The modulus is only
+ * written when m is not NULL.
+ * 
+ * @return 0 upon success
+ *         -1 for a wrong operand length
+ */
+int MME1536_ListMME(MME1536_CmdList * list, int * R2, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t){
+	int part = MME1536_PartOf(n);
+	if(part == 0){
+		printf("[ERROR] MME1536: MME() -> wrong operand length: %d\n", n);
+		return -1;
+	}
+	
+	MME1536_CmdInit(list);
+	
+	// write modulus to hardware
+	if(m != NULL){
+		MME1536_CmdLoad(list, m, MODULUS, n);
+	}
+	
+	// write operands to hardware
+	MME1536_CmdLoad(list, g0, OPERAND_0, n);
+	MME1536_CmdLoad(list, g1, OPERAND_1, n);
+	MME1536_CmdLoad(list, one, OPERAND_2, n);
+	MME1536_CmdLoad(list, R2, OPERAND_3, n);
+
+	// compute gt0
+	MME1536_CmdSingle(list, part, OPERAND_0, OPERAND_0, OPERAND_3);
+	// set exponent bits (written while gt0 is computed)
+	MME1536_CmdExponent(list, e0, e1, t);
+	// compute gt1
+	MME1536_CmdSingle(list, part, OPERAND_1, OPERAND_1, OPERAND_3);
+	// compute R
+	MME1536_CmdSingle(list, part, OPERAND_3, OPERAND_2, OPERAND_3);
+	// compute gt01
+	MME1536_CmdSingle(list, part, OPERAND_2, OPERAND_0, OPERAND_1);
+	
+	/* Main computation */
+	// start core in auto mode
+	MME1536_CmdAuto(list, part);
+	
+	/* Postcomputation */
+	// write '1'
+	MME1536_CmdLoad(list, one, OPERAND_2, n);
+	MME1536_CmdSingle(list, part, OPERAND_3, OPERAND_2, OPERAND_3);
+	MME1536_CmdRead(list, result, OPERAND_3, n);
+	
+	return 0;
+}
+
+/** Record g^e mod m in a command list. The modulus is only written when m
+ * is not NULL.
+ * 
+ * @return 0 upon success
+ *         -1 for a wrong operand length
+ */
+int MME1536_ListExp(MME1536_CmdList * list, int * R2, int * result, int * g, int * m, int * e, int n, int t){
+	int part = MME1536_PartOf(n);
+	if(part == 0){
+		printf("[ERROR] MME1536: Exp() -> wrong operand length: %d\n", n);
+		return -1;
+	}
+	
+	MME1536_CmdInit(list);
+	
+	// write modulus to hardware
+	if(m != NULL){
+		MME1536_CmdLoad(list, m, MODULUS, n);
+	}
+	
+	// write operands to hardware
+	MME1536_CmdLoad(list, g, OPERAND_0, n);
+	MME1536_CmdLoad(list, R2, OPERAND_1, n);
+	MME1536_CmdLoad(list, one, OPERAND_2, n);
+	
+	// compute gt0
+	MME1536_CmdSingle(list, part, OPERAND_0, OPERAND_0, OPERAND_1);
+	// set exponent bits (written while gt0 is computed)
+	MME1536_CmdExponent(list, e, NULL, t);
+	// compute R
+	MME1536_CmdSingle(list, part, OPERAND_3, OPERAND_2, OPERAND_1);
+	
+	/* Main computation */
+	// start core in auto mode
+	MME1536_CmdAuto(list, part);
+	
+	/* Postcomputation */
+	MME1536_CmdSingle(list, part, OPERAND_3, OPERAND_2, OPERAND_3);
+	MME1536_CmdRead(list, result, OPERAND_3, n);
+	
+	return 0;
+}
+
+void MME1536_ListExp_m(MME1536 * device_instance, MME1536_CmdList * list, int * R2, int * result, int * g, int * e, int t){
+	MME1536_ListExp(list, R2, result, g, NULL, e, device_instance->n, t);
+}
+
+void MME1536_ListMultiply_m(MME1536 * device_instance, MME1536_CmdList * list, int * R2, int * result, int * x, int * y){
+	int n = device_instance->n;
+	int part = device_instance->part;
+	
+	MME1536_CmdInit(list);
+	
+	// write x and y to hardware
+	MME1536_CmdLoad(list, x, OPERAND_0, n);
+	MME1536_CmdLoad(list, y, OPERAND_1, n);
+	MME1536_CmdLoad(list, R2, OPERAND_2, n);
+	
+	// do the multiplication
+	MME1536_CmdSingle(list, part, OPERAND_3, OPERAND_0, OPERAND_1); //(x.y).R^(-1)
+	MME1536_CmdSingle(list, part, OPERAND_3, OPERAND_2, OPERAND_3); //(x.y.R^(-1).R^2).R^(-1)
+	
+	// get the result
+	MME1536_CmdRead(list, result, OPERAND_3, n);
+}
+
+/** Append a job to the device queue and start it if the core is free.
+ */
+void MME1536_JobQueue(MME1536 * device_instance, MME1536_Job * job){
+	job->state = JOB_QUEUED;
+	job->phase = PHASE_PRECOMPUTE;
+	job->error = 0;
+	job->next = 0;
+	job->next_job = NULL;
+	if(STATS_ON(device_instance)) job->submitted_ns = MME1536_StatsNow();
+	
+	if(device_instance->queue_tail != NULL){
+		device_instance->queue_tail->next_job = job;
+		device_instance->queue_tail = job;
+		return;
+	}
+	device_instance->queue_head = job;
+	device_instance->queue_tail = job;
+	
+	// core is free
+	while(!MME1536_JobIssue(device_instance, device_instance->queue_head)){
+		// job didn't need the core
+		device_instance->queue_head->state = JOB_DONE;
+		if(STATS_ON(device_instance)){
+			MME1536_StatsRecord(device_instance, MME1536_CmdPartOf(&(device_instance->queue_head->list)), MME1536_StatsNow() - device_instance->queue_head->submitted_ns);
+		}
+		device_instance->queue_head = device_instance->queue_head->next_job;
+		if(device_instance->queue_head == NULL){
+			device_instance->queue_tail = NULL;
+			break;
+		}
+	}
+}
+
+/** The core finished the current operation of the head job: start its next
+ * one, or retire the job and start the next job.
+ * 
+ * @return the nr. of jobs that were completed
+ */
+int MME1536_JobAdvance(MME1536 * device_instance){
+	int done = 0;
+	MME1536_Job * job = device_instance->queue_head;
+	
+	while(job != NULL){
+		if(MME1536_JobIssue(device_instance, job)) break;
+		// retire the job
+		job->state = JOB_DONE;
+		if(STATS_ON(device_instance)){
+			MME1536_StatsRecord(device_instance, MME1536_CmdPartOf(&(job->list)), MME1536_StatsNow() - job->submitted_ns);
+		}
+		done++;
+		job = job->next_job;
+		device_instance->queue_head = job;
+	}
+	if(job == NULL){
+		device_instance->queue_tail = NULL;
+	}
+	MME1536_RearmInterrupt(device_instance);
+	
+	return done;
+}
+
+/** Record the modulus set by UpdateModulus() in a job that is queued with
+ * m set, with a copy of its R2 (see MME1536_JobIssue()).
+ */
+void MME1536_JobModulus(MME1536 * device_instance, MME1536_Job * job){
+	job->ctx = device_instance->ctx;
+	memcpy(job->R2, device_instance->R2, WORDS_TOT * sizeof(int));
+}
+
+/** Mark a job done with error -1 until it is queued, so that
+ * MME1536_Complete() returns for a job that a Submit function rejected.
+ */
+void MME1536_JobReject(MME1536_Job * job){
+	job->state = JOB_DONE;
+	job->error = -1;
+}
+
+/** Issue the next core operation of a job and keep track of its phase.
+ * 
+ * @return 1 if a core operation was started
+ *         0 if the job is done
+ */
+int MME1536_JobIssue(MME1536 * device_instance, MME1536_Job * job){
+	int first = job->next;
+	int i;
+	
+	// a job queued with m set runs under its modulus, whatever the jobs
+	// before it wrote
+	if((first == 0) && (job->ctx != NULL) && (device_instance->loaded_ctx != job->ctx)){
+		job->ctx->ops->set_operand(device_instance, job->ctx->m, MODULUS);
+		device_instance->loaded_ctx = job->ctx;
+	}
+	job->state = JOB_RUNNING;
+	if(!MME1536_CmdIssue(device_instance, &(job->list), &(job->next))){
+		if(job->list.error != 0) job->error = -1;
+		return 0;
+	}
+	
+	// find the operation that was started
+	for(i=first; i<job->next; i++){
+		if(job->list.cmd[i].type == CMD_AUTO){
+			job->phase = PHASE_AUTO;
+			break;
+		}
+		if(job->list.cmd[i].type == CMD_SINGLE){
+			if(job->phase == PHASE_AUTO) job->phase = PHASE_POSTCOMPUTE;
+			break;
+		}
+	}
+	
+	return 1;
+}
+
+/** Abort the head job after the core was reset: it is done with an error,
+ * the next job is started.
+ * 
+ * @return the nr. of jobs that were completed (including the aborted one)
+ */
+int MME1536_JobAbort(MME1536 * device_instance){
+	MME1536_Job * job = device_instance->queue_head;
+	
+	if(job == NULL) return 0;
+	job->state = JOB_DONE;
+	job->error = -1;
+	device_instance->queue_head = job->next_job;
+	if(device_instance->queue_head == NULL){
+		device_instance->queue_tail = NULL;
+		return 1;
+	}
+	
+	return 1 + MME1536_JobAdvance(device_instance);
+}
+
+/** Get the pipeline part for a modulus length.
+ * 
+ * @return LOW_PART, HIGH_PART or TOT_PIPELINE
+ *         0 for a wrong length
+ */
+int MME1536_PartOf(int n){
+	const MME1536_SizeOps * ops = MME1536_OpsOf(n);
+	
+	return (ops == NULL) ? 0 : ops->part;
+}
+
+/** Find the cached context of a modulus, or compute it in the least
+ * recently used entry. The context set by UpdateModulus() is never
+ * evicted.
+ */
+MME1536_MontCtx * MME1536_CtxLookup(MME1536 * device_instance, int * m, int n){
+	unsigned int hash = MME1536_ModulusHash(m, n);
+	MME1536_MontCtx * victim = NULL;
+	MME1536_MontCtx * ctx;
+	int i;
+	
+	for(i=0; i<CTX_CACHE_SIZE; i++){
+		ctx = &(device_instance->ctx_cache[i]);
+		if(ctx->valid && (ctx->hash == hash) && (ctx->n == n)
+		   && (memcmp(ctx->m, m, n / 8) == 0)){
+			device_instance->ctx_hits++;
+			ctx->last_used = ++device_instance->ctx_clock;
+			return ctx;
+		}
+		// the current context is never evicted: queued jobs with m set refer
+		// to it (see MME1536_JobModulus())
+		if(ctx == device_instance->ctx) continue;
+		if((victim == NULL) || (victim->valid && (!ctx->valid || (ctx->last_used < victim->last_used)))){
+			victim = ctx;
+		}
+	}
+	
+	// miss: compute the context
+	device_instance->ctx_misses++;
+	ctx = victim;
+	if(device_instance->loaded_ctx == ctx) device_instance->loaded_ctx = NULL;
+	
+	ctx->valid = 1;
+	ctx->hash = hash;
+	ctx->last_used = ++device_instance->ctx_clock;
+	ctx->n = n;
+	ctx->words = n / 32;
+	ctx->ops = MME1536_OpsOf(n);
+	ctx->part = ctx->ops->part;
+	memset(ctx->m, 0, sizeof(ctx->m));
+	memcpy(ctx->m, m, n / 8);
+	memset(ctx->R2, 0, sizeof(ctx->R2));
+	MME1536_ComputeR2(ctx->R2, m, n);
+	memset(ctx->R, 0, sizeof(ctx->R));
+	MME1536_ComputePow2(ctx->R, m, n, n);
+	
+	return ctx;
+}
+
+/** Compute g0^e0 * g1^e1 mod m for the modulus of a context. The modulus
+ * is only written if the core doesn't have it.
+ */
+int MME1536_MMECtx(MME1536 * device_instance, MME1536_MontCtx * ctx, int * result, int * g0, int * g1, int * e0, int * e1, int t){
+	MME1536_CmdList list;
+	
+	// queued jobs may change the modulus in the core
+	if(device_instance->queue_tail != NULL){
+		MME1536_Complete(device_instance, device_instance->queue_tail);
+	}
+	if(MME1536_ListMME(&list, ctx->R2, result, g0, g1, (device_instance->loaded_ctx == ctx) ? NULL : ctx->m, e0, e1, ctx->n, t) != 0){
+		return -1;
+	}
+	if(MME1536_CmdSubmit(device_instance, &list) != 0) return -1;
+	device_instance->loaded_ctx = ctx;
+	
+	return 0;
+}
+
+/** Write the modulus of the context set by UpdateModulus() to the core,
+ * unless it is there already. While jobs are queued it is left to them
+ * (see MME1536_JobIssue()) and to MME1536_CmdSubmit() once they are done.
+ */
+void MME1536_EnsureModulus(MME1536 * device_instance){
+	MME1536_MontCtx * ctx = device_instance->ctx;
+	
+	if((ctx == NULL) || (device_instance->loaded_ctx == ctx)) return;
+	if(device_instance->queue_head != NULL) return;
+	
+	ctx->ops->set_operand(device_instance, ctx->m, MODULUS);
+	device_instance->loaded_ctx = ctx;
+}
+
+/** Check that a pinned base belongs to the modulus that is set.
+ */
+int MME1536_PinnedCheck(MME1536 * device_instance, MME1536_Pinned * base){
+	if((device_instance->ctx == NULL) || (base->n != device_instance->n)
+	   || (base->hash != device_instance->ctx->hash)){
+		printf("[ERROR] MME1536: base was pinned for another modulus\n");
+		return -1;
+	}
+	return 0;
+}
+
+/** Check that a value is still in its operand: nothing was written there
+ * since it was put there.
+ */
+int MME1536_ValueResident(MME1536 * device_instance, MME1536_Value * value){
+	return (value->operand >= OPERAND_0) && (value->operand <= OPERAND_3)
+	       && (device_instance->holder[value->operand] == value);
+}
+
+/** Check that a value belongs to the modulus that is set and is either in
+ * its operand or has been read back to its data.
+ */
+int MME1536_ValueCheck(MME1536 * device_instance, MME1536_Value * value){
+	if(!value->valid || (device_instance->ctx == NULL) || (value->n != device_instance->n)
+	   || (value->hash != device_instance->ctx->hash)){
+		printf("[ERROR] MME1536: value is not set or belongs to another modulus\n");
+		return -1;
+	}
+	if((value->operand >= 0) && !MME1536_ValueResident(device_instance, value)){
+		printf("[ERROR] MME1536: value was overwritten in operand %d\n", value->operand);
+		value->valid = 0;
+		return -1;
+	}
+	return 0;
+}
+
+/** Get an operand outside the avoid mask (bit i: operand i) that holds no
+ * value.
+ * 
+ * @param evict is set to fall back to one that holds a value
+ * 
+ * @return the operand, or -1 when there is none
+ */
+int MME1536_ValueFree(MME1536 * device_instance, int avoid, int evict){
+	int operand;
+	
+	for(operand=OPERAND_0; operand<=OPERAND_3; operand++){
+		if(avoid & (1 << operand)) continue;
+		if(device_instance->holder[operand] == NULL) return operand;
+	}
+	if(!evict) return -1;
+	for(operand=OPERAND_0; operand<=OPERAND_3; operand++){
+		if(!(avoid & (1 << operand))) return operand;
+	}
+	return -1;
+}
+
+/** Add the steps to a command list that keep the value in an operand the
+ * list overwrites: it is moved on the core to an operand outside the
+ * avoid mask that holds no value, (v.R).R.R^(-1) = v.R, or else read back
+ * to its data. The operand and the one the value moves to are added to
+ * avoid.
+ */
+void MME1536_ValueRoom(MME1536 * device_instance, MME1536_CmdList * list, MME1536_ValuePlan * plan, int operand, int * avoid){
+	MME1536_Value * value = device_instance->holder[operand];
+	int to;
+	
+	*avoid |= 1 << operand;
+	if(value == NULL) return;
+	
+	to = MME1536_ValueFree(device_instance, *avoid, 0);
+	if(to >= 0){
+		MME1536_CmdLoad(list, device_instance->ctx->R, to, device_instance->n);
+		MME1536_CmdSingle(list, device_instance->part, to, operand, to);
+		*avoid |= 1 << to;
+	}
+	else{
+		MME1536_CmdRead(list, value->data, operand, device_instance->n);
+	}
+	plan->value[plan->count] = value;
+	plan->operand[plan->count++] = to;
+}
+
+/** Add the steps to a command list that put a value in an operand, when
+ * it was read back to its data, and add the operand to avoid.
+ * 
+ * @return the operand holding the value
+ */
+int MME1536_ValueUse(MME1536 * device_instance, MME1536_CmdList * list, MME1536_ValuePlan * plan, MME1536_Value * value, int * avoid){
+	int operand;
+	
+	if(MME1536_ValueResident(device_instance, value)){
+		*avoid |= 1 << value->operand;
+		return value->operand;
+	}
+	operand = MME1536_ValueFree(device_instance, *avoid, 1);
+	MME1536_ValueRoom(device_instance, list, plan, operand, avoid);
+	MME1536_CmdLoad(list, value->data, operand, device_instance->n);
+	plan->value[plan->count] = value;
+	plan->operand[plan->count++] = operand;
+	return operand;
+}
+
+/** Record that a value is in an operand, as written last.
+ */
+void MME1536_ValuePlace(MME1536 * device_instance, MME1536_Value * value, int operand){
+	if(MME1536_ValueResident(device_instance, value)) device_instance->holder[value->operand] = NULL;
+	device_instance->holder[operand] = value;
+	value->operand = operand;
+	value->hash = device_instance->ctx->hash;
+	value->n = device_instance->n;
+	value->valid = 1;
+}
+
+/** Record where the values are after a command list has been executed
+ * (see MME1536_ValueRoom()).
+ */
+void MME1536_ValueCommit(MME1536 * device_instance, MME1536_ValuePlan * plan){
+	MME1536_Value * value;
+	int i;
+	
+	for(i=0; i<plan->count; i++){
+		value = plan->value[i];
+		if(plan->operand[i] >= 0){
+			MME1536_ValuePlace(device_instance, value, plan->operand[i]);
+		}
+		else{
+			if(device_instance->holder[value->operand] == value) device_instance->holder[value->operand] = NULL;
+			value->operand = -1;
+		}
+	}
+}
+
+/** Record that the core writes regions of an operand: they may hold data
+ * and no longer hold the value the host wrote or a value kept there.
+ */
+void MME1536_Written(MME1536 * device_instance, int operand, int regions){
+	device_instance->holder[operand] = NULL;
+	device_instance->dirty[operand] |= regions;
+	if(regions & REGION_LOW) device_instance->res_n[operand][0] = 0;
+	if(regions & REGION_HIGH) device_instance->res_n[operand][1] = 0;
+}
+
+/** Get the operand words a pipeline part writes.
+ * 
+ * @return REGION_LOW, REGION_HIGH or both
+ */
+int MME1536_RegionOf(int p_sel){
+	return ((p_sel & LOW_PART) ? REGION_LOW : 0) | ((p_sel & HIGH_PART) ? REGION_HIGH : 0);
+}
+
+/** Re-enable the UIO interrupt after it has been handled.
+ */
+void MME1536_RearmInterrupt(MME1536 * device_instance){
+	int enable = 1;
+	if(device_instance->backend != NULL) return;
+	write(device_instance->ctrl_fd, &enable, sizeof(int));
+}
+
+/** Read the UIO interrupt counter without blocking.
+ * 
+ * @return 1 if an interrupt arrived since the last one that was handled
+ *         0 otherwise
+ */
+int MME1536_ReadInterrupts(MME1536 * device_instance, int * ints_passed){
+	int ints;
+	if(device_instance->backend != NULL){
+		*ints_passed = device_instance->backend->read_interrupts(device_instance);
+	}
+	else if(read(device_instance->ctrl_fd, &ints, sizeof(int)) == sizeof(int)){
+		*ints_passed = ints;
+	}
+	return (*ints_passed > device_instance->prev_tot_ints);
+}
+
+/** Set the deadline of a core operation that is started now from its
+ * wait budget (see MME1536_SetWaitBudget()).
+ */
+void MME1536_SetDeadline(MME1536 * device_instance, unsigned control){
+	static const int bits[4] = {BITS_TOT, BITS_LOW, BITS_HIGH, BITS_TOT};
+	long long mults = 1;
+	long long budget_us;
+	
+	// auto-run: a squaring and a multiplication per exponent bit
+	if(control & 0x00400000) mults = 2LL * 16 * device_instance->exp_entries;
+	budget_us = device_instance->tv.tv_sec * 1000000LL + device_instance->tv.tv_usec
+	          + mults * bits[control >> P_SEL_BITS] * device_instance->budget_ns_per_bit / 1000;
+	clock_gettime(CLOCK_MONOTONIC, &(device_instance->deadline));
+	MME1536_TimeAddUs(&(device_instance->deadline), (long)budget_us);
+}
+
+long MME1536_TimeLeftUs(struct timespec * deadline){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (deadline->tv_sec - now.tv_sec) * 1000000L
+	     + (deadline->tv_nsec - now.tv_nsec) / 1000L;
+}
+
+void MME1536_TimeAddUs(struct timespec * time, long us){
+	time->tv_sec += us / 1000000L;
+	time->tv_nsec += (us % 1000000L) * 1000L;
+	if(time->tv_nsec >= 1000000000L){
+		time->tv_sec++;
+		time->tv_nsec -= 1000000000L;
+	}
+}
+
+/** Set the start bit, hold it and clear it again.
+ * The read-back after the first write can only complete once the write has
+ * reached the core, so the start bit is guaranteed to be seen for at least
+ * start_hold further bus round trips before it is cleared.
+ */
+void MME1536_PulseStart(MME1536 * device_instance, unsigned control){
+	volatile unsigned * ctrl = (volatile unsigned *)(device_instance->ctrl_ptr);
+	int cycle;
+	
+	// operand and exponent writes must reach the core before the start bit
+	MME1536_DmaSync(device_instance);
+	MME1536_DataBarrier(device_instance);
+	MME1536_SetDeadline(device_instance, control);
+	device_instance->ctrl_shadow = control & 0xff7fffff;
+	if(device_instance->backend != NULL){
+		device_instance->backend->start(device_instance, control);
+		return;
+	}
+	// set start bit
+	*ctrl = control;
+	(void)*ctrl;
+	if(device_instance->start_hold == START_HOLD_USLEEP){
+		usleep(1);
+	}
+	else{
+		for(cycle=0; cycle<device_instance->start_hold; cycle++){
+			(void)*ctrl;
+		}
+	}
+	// clear start bit
+	*ctrl = control & 0xff7fffff;
+}
+
+/** Order the data memory accesses before the ones that follow (the start
+ * bit, reads of a result). A MAPPING_WC mapping buffers writes, so on ARM
+ * they are drained with dsb instead of only ordered with dmb.
+ */
+void MME1536_DataBarrier(MME1536 * device_instance){
+#if defined(__aarch64__) || (defined(__ARM_ARCH) && (__ARM_ARCH >= 7))
+	if(device_instance->mapping & MAPPING_WC){
+		__asm__ __volatile__("dsb sy" ::: "memory");
+		return;
+	}
+#else
+	(void)device_instance;
+#endif
+	__sync_synchronize();
+}
+
+/** Find the map of a UIO device that holds bytes bytes at the physical
+ * address addr (see UIO_SYSFS/uioX/maps/mapN).
+ * 
+ * @param map_addr, map_size are set to the page aligned start and the
+ *        length of the map as the kernel maps it
+ * 
+ * @return the index of the map, or -1 when there is none
+ */
+int MME1536_UioFindMap(const char * uio_dev, unsigned long addr, unsigned long bytes, unsigned long * map_addr, unsigned long * map_size){
+	const char * name = strrchr(uio_dev, '/');
+	char path[128];
+	unsigned long start, size;
+	FILE * file;
+	int map, found;
+	
+	name = (name == NULL) ? uio_dev : name + 1;
+	for(map=0; map<UIO_MAX_MAPS; map++){
+		snprintf(path, sizeof(path), UIO_SYSFS "/%s/maps/map%d/addr", name, map);
+		if((file = fopen(path, "r")) == NULL) break;
+		found = fscanf(file, "%lx", &start);
+		fclose(file);
+		snprintf(path, sizeof(path), UIO_SYSFS "/%s/maps/map%d/size", name, map);
+		if((file = fopen(path, "r")) == NULL) break;
+		found += fscanf(file, "%lx", &size);
+		fclose(file);
+		if(found != 2) break;
+		
+		// the kernel maps the map from the start of its first page
+		size += start & (PAGE_SIZE - 1);
+		start &= ~(unsigned long)(PAGE_SIZE - 1);
+		if((addr >= start) && (addr + bytes <= start + size)){
+			*map_addr = start;
+			*map_size = (size + PAGE_SIZE - 1) & ~(unsigned long)(PAGE_SIZE - 1);
+			return map;
+		}
+	}
+	return -1;
+}
+
+/** Set up the driver state of a handle whose memory and interrupt fd are
+ * in place (see MME1536_InitializeAt() and MME1536_InitializeBackend()).
+ * 
+ * @return 0 upon success
+ *         -1 upon failure
+ */
+int MME1536_InitState(MME1536 * device_instance){
+	/* Interrupt */
+	// set timeouts
+	device_instance->tv.tv_sec = TIMEOUT_S;
+	device_instance->tv.tv_usec = TIMEOUT_US;
+	device_instance->budget_ns_per_bit = DEFAULT_BUDGET_NS_PER_BIT;
+	clock_gettime(CLOCK_MONOTONIC, &(device_instance->deadline));
+	device_instance->wait_mode = DEFAULT_WAIT_MODE;
+	device_instance->spin_us = DEFAULT_SPIN_US;
+	device_instance->start_hold = DEFAULT_START_HOLD;
+	device_instance->queue_head = NULL;
+	device_instance->queue_tail = NULL;
+	// operand memory content is unknown, no values are kept
+	int operand;
+	for(operand=OPERAND_0; operand<=MODULUS; operand++){
+		device_instance->dirty[operand] = REGION_LOW | REGION_HIGH;
+		device_instance->res_n[operand][0] = 0;
+		device_instance->res_n[operand][1] = 0;
+		device_instance->holder[operand] = NULL;
+	}
+	device_instance->ctrl_shadow = *((volatile unsigned *)(device_instance->ctrl_ptr));
+	device_instance->split_pipeline = 0;
+	// no modulus yet
+	device_instance->n = 0;
+	device_instance->words = 0;
+	device_instance->part = 0;
+	device_instance->ops = NULL;
+	// initialise fd_set variable
+	FD_ZERO(&(device_instance->select_fd));
+	FD_SET(device_instance->ctrl_fd, &(device_instance->select_fd));
+	// exponent fifo
+	device_instance->fifo_depth = DEFAULT_FIFO_DEPTH;
+	device_instance->fifo_streaming = 0;
+	device_instance->stream_next = 0;
+	device_instance->stream_count = 0;
+	device_instance->stream_auto = 0;
+	device_instance->exp_entries = 0;
+	// instrumentation
+	device_instance->stats_enabled = DEFAULT_STATS;
+	device_instance->stats_phase = -1;
+	MME1536_ResetStats(device_instance);
+	// no DMA channel until MME1536_DmaAttach()
+	device_instance->dma_fd = -1;
+	device_instance->dma_busy_bytes = 0;
+	// pick the widest operand memory access the core accepts
+	MME1536_UseTransfer(device_instance, TRANSFER_32);
+	MME1536_SetTransferMode(device_instance, TRANSFER_AUTO);
+	// enable interrupt in the hardware
+	MME1536_EnableInterrupt(device_instance);
+	// Enable uio interrupt
+	int enable = 1;
+	if((device_instance->backend == NULL)
+	   && (write(device_instance->ctrl_fd, &enable, sizeof(int)) == ENOSYS)){
+		printf("[ERROR] MME1536: Initialize() -> no interrupt for this device!\n");
+		return -1;
+	};
+	// Read nr of ints until now
+	int ints = 0;
+	device_instance->prev_tot_ints = 0;
+	MME1536_ReadInterrupts(device_instance, &ints);
+	device_instance->prev_tot_ints = ints;
+	
+	// Reserve memory for the modulus cache
+	device_instance->ctx_cache = (MME1536_MontCtx *)calloc(CTX_CACHE_SIZE, sizeof(MME1536_MontCtx));
+	if(device_instance->ctx_cache == NULL){
+		printf("[ERROR] MME1536: Initialize() -> could not allocate memory for the modulus cache.\n");
+		return -1;
+	}
+	
+	// Reserve the job buffers
+	device_instance->arena.block = NULL;
+	if(MME1536_ArenaInit(device_instance, DEFAULT_ARENA_DEPTH, DEFAULT_ARENA_T) != 0){
+		free(device_instance->ctx_cache);
+		return -1;
+	}
+	device_instance->ctx = NULL;
+	device_instance->loaded_ctx = NULL;
+	device_instance->ctx_clock = 0;
+	device_instance->ctx_hits = 0;
+	device_instance->ctx_misses = 0;
+	
+	return 0;
+}
+
+/** Round a size up to a multiple of CACHE_LINE bytes.
+ */
+size_t MME1536_AlignLine(size_t bytes){
+	return (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+/** Free mask of an arena with all depth buffers free.
+ */
+unsigned long long MME1536_ArenaMask(int depth){
+	return (depth >= 64) ? ~0ULL : ((1ULL << depth) - 1);
+}
+
+/** Monotonic time (ns) for the instrumentation.
+ */
+unsigned long long MME1536_StatsNow(void){
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/** Count the time of the core operation in flight, whose interrupt has
+ * been seen, in its phase.
+ */
+void MME1536_StatsCoreDone(MME1536 * device_instance){
+	if(device_instance->stats_phase < 0) return;
+	device_instance->stats.phase_ns[device_instance->stats_phase] += MME1536_StatsNow() - device_instance->stats_start_ns;
+	device_instance->stats_phase = -1;
+}
+
+/** Count a finished operation of a pipeline part and its latency.
+ */
+void MME1536_StatsRecord(MME1536 * device_instance, int part, unsigned long long latency_ns){
+	MME1536_Stats * stats = &(device_instance->stats);
+	
+	if((part >= LOW_PART) && (part <= TOT_PIPELINE)) stats->ops[part - LOW_PART]++;
+	if((stats->latency_min_ns == 0) || (latency_ns < stats->latency_min_ns)) stats->latency_min_ns = latency_ns;
+	if(latency_ns > stats->latency_max_ns) stats->latency_max_ns = latency_ns;
+	stats->latency_sum_ns += latency_ns;
+	stats->latency_hist[MME1536_StatsBucket(latency_ns)]++;
+}
+
+/** Histogram bucket of a latency (see MME1536_StatsBucketValue()).
+ */
+int MME1536_StatsBucket(unsigned long long ns){
+	int e, bucket;
+	
+	if(ns < (1ULL << STATS_HIST_SUB_BITS)) return (int)ns;
+	e = 63 - __builtin_clzll(ns);
+	bucket = ((e - STATS_HIST_SUB_BITS + 1) << STATS_HIST_SUB_BITS)
+	       | (int)((ns >> (e - STATS_HIST_SUB_BITS)) & ((1 << STATS_HIST_SUB_BITS) - 1));
+	
+	return (bucket < STATS_HIST_BUCKETS) ? bucket : (STATS_HIST_BUCKETS - 1);
 }
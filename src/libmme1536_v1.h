@@ -35,6 +35,10 @@
 #define OPERAND_3	3
 #define MODULUS		4
 
+// operand regions (see MME1536_SetOperand())
+#define REGION_LOW	1 // words of the low pipeline part
+#define REGION_HIGH	2 // words of the high pipeline part
+
 // bit length of the pipeline parts
 #define BITS_LOW	512
 #define BITS_HIGH	1024
@@ -64,15 +68,108 @@
 #define X_OP_BITS	26
 #define Y_OP_BITS	24
 
-// timeouts
+// command list step types
+#define CMD_SINGLE	0 // single montgomery multiplication
+#define CMD_AUTO	1 // main computation loop (auto-run)
+#define CMD_LOAD	2 // write a host buffer to an operand
+#define CMD_EXPONENT	3 // write exponents to the exponent fifo
+#define CMD_READ	4 // read an operand into a host buffer
+
+// AXI CDMA registers and bits (see MME1536_DmaAttach())
+#define CDMA_CR_OFFSET	0x00 // control
+#define CDMA_SR_OFFSET	0x04 // status
+#define CDMA_SA_OFFSET	0x18 // source address
+#define CDMA_DA_OFFSET	0x20 // destination address
+#define CDMA_BTT_OFFSET	0x28 // bytes to transfer (starts the transfer)
+#define CDMA_CR_RESET	0x00000004
+#define CDMA_CR_KEYHOLE_WRITE	0x00000020 // fixed destination address (fifo)
+#define CDMA_SR_IDLE	0x00000002
+#define CDMA_SR_ERRORS	0x00000070 // internal, slave and decode error
+#define CDMA_TIMEOUT_US	10000
+
+// DMA staging buffer: an image of the core's data memory
+#define DMA_BUF_SIZE	(PAGE_SIZE*6)
+// transfers shorter than this (in words) are written by the cpu
+#define DMA_MIN_WORDS	16
+
+// nr. of moduli kept in the per-device modulus cache
+#define CTX_CACHE_SIZE	32
+
+// asynchronous job states
+#define JOB_IDLE	0
+#define JOB_QUEUED	1 // waiting for the core
+#define JOB_RUNNING	2 // using the core
+#define JOB_DONE	3 // result available
+
+// asynchronous job phases
+#define PHASE_PRECOMPUTE	0
+#define PHASE_AUTO	1
+#define PHASE_POSTCOMPUTE	2
+
+// instrumentation (see MME1536_SetStats()), compile with MME1536_NO_STATS
+// to leave it out of the driver
+#define DEFAULT_STATS	0 // off until enabled at runtime
+#define STATS_UPLOAD	0 // operand and exponent writes
+#define STATS_PRECOMPUTE	1 // core operations in front of the auto-run
+#define STATS_AUTO	2 // auto-run
+#define STATS_POSTCOMPUTE	3 // core operations behind the auto-run
+#define STATS_READBACK	4 // operand reads
+#define STATS_PHASES	5
+#define STATS_SIZES	3 // 512, 1024 and 1536 bits
+// latency histogram: 2^STATS_HIST_SUB_BITS buckets per power of two (ns)
+#define STATS_HIST_SUB_BITS	3
+#define STATS_HIST_BUCKETS	320
+
+// start bit pulse: nr. of control register read-backs (bus cycles) between
+// setting and clearing the start bit (see MME1536_SetStartHold())
+#define DEFAULT_START_HOLD	1
+#define START_HOLD_USLEEP	(-1) // legacy: usleep(1) between set and clear
+
+// wait budget of a core operation: a fixed part (interrupt latency,
+// scheduling) plus a part per operand bit of each multiplication, twice
+// the time of the core at 100 MHz
 #define TIMEOUT_S	0
-#define TIMEOUT_US	140000
+#define TIMEOUT_US	20000
+#define DEFAULT_BUDGET_NS_PER_BIT	20
+
+// interrupt wait modes (see MME1536_SetWaitMode())
+#define WAIT_SPIN	0 // poll the UIO counter until the interrupt arrives
+#define WAIT_BLOCK	1 // sleep in select() on the UIO fd
+#define WAIT_HYBRID	2 // spin for spin_us, then sleep
+#define DEFAULT_WAIT_MODE	WAIT_HYBRID
+#define DEFAULT_SPIN_US	50
+
+// exponent fifo (see MME1536_SetFifoStreaming())
+#define DEFAULT_FIFO_DEPTH	512 // nr. of entries, 2 per 32 exponent bits
+#define FIFO_POLL_MS	1 // top-up interval while streaming
+
+// alignment of exponent images (see MME1536_EncodeExponent())
+#define CACHE_LINE	64
+
+// job arena (see MME1536_ArenaInit())
+#define ARENA_MAX_DEPTH	64 // one bit per buffer in the free mask
+#define DEFAULT_ARENA_DEPTH	4
+#define DEFAULT_ARENA_T	1536 // exponent bits per buffer
+
+// operand memory transfer paths (see MME1536_SetTransferMode())
+#define TRANSFER_AUTO	(-1) // widest path that passes the probe
+#define TRANSFER_32	0 // one 32-bit access per word
+#define TRANSFER_64	1 // 64-bit accesses
+#define TRANSFER_NEON	2 // 128-bit NEON accesses (ARM builds with NEON only)
+
+// data memory mappings (see MME1536_InitializeOpt())
+#define MAPPING_DEVMEM	0 // /dev/mem at the data base address (needs root)
+#define MAPPING_UIO	1 // the map of the UIO device that holds the data memory
+#define MAPPING_WC	0x10 // flag: the data mapping may buffer and merge writes
+#define UIO_MAX_MAPS	5 // maps of a UIO device (MAX_UIO_MAPS of the kernel)
+#define UIO_SYSFS	"/sys/class/uio"
 
 /**
  * Software Reset Masks
  * -- SOFT_RESET : software reset
  */
 #define SOFT_RESET (0x0000000A)
+#define MME1536_RST_OFFSET (0x00000100)
 
 /**
  * Interrupt Controller Space Offsets
@@ -85,6 +182,12 @@
 #define MME1536_INTR_IPISR_OFFSET (MME1536_INTR_CNTRL_SPACE_OFFSET + 0x00000020)
 #define MME1536_INTR_IPIER_OFFSET (MME1536_INTR_CNTRL_SPACE_OFFSET + 0x00000028)
 
+/**
+ * IP Interrupt Status Register Masks (write 1 to clear)
+ * -- IPISR_FIFO_NOPUSH : a write to the exponent fifo was dropped (fifo full)
+ */
+#define IPISR_FIFO_NOPUSH (0x00000008UL)
+
 /**
  * Interrupt Controller Masks
  * -- INTR_TERR_MASK : transaction error
@@ -109,32 +212,90 @@
  */
 
 int MME1536_Initialize(MME1536 * device_instance, char * uio_dev);
+int MME1536_InitializeAt(MME1536 * device_instance, char * uio_dev, unsigned long data_base);
+int MME1536_InitializeOpt(MME1536 * device_instance, char * uio_dev, unsigned long data_base, int mapping);
+int MME1536_InitializeBackend(MME1536 * device_instance, const MME1536_Backend * backend, void * backend_data, void * data_ptr, void * ctrl_ptr, int fd);
 void MME1536_Clean(MME1536 * device_instance);
 
-void MME1536_MME(MME1536 * device_instance, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
-void MME1536_UpdateModulus(MME1536 * device_instance, int * m, int n);
-void MME1536_Multiply_m(MME1536 * device_instance, int * result, int * x, int * y);
-void MME1536_Exp_m(MME1536 * device_instance, int * result, int * g, int * e, int t);
-void MME1536_MME_m(MME1536 * device_instance, int * result, int * g0, int * g1, int * e0, int * e1, int t);
+int MME1536_MME(MME1536 * device_instance, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+int MME1536_UpdateModulus(MME1536 * device_instance, int * m, int n);
+int MME1536_Multiply_m(MME1536 * device_instance, int * result, int * x, int * y);
+int MME1536_Exp_m(MME1536 * device_instance, int * result, int * g, int * e, int t);
+int MME1536_PinBase_m(MME1536 * device_instance, MME1536_Pinned * base, int * g);
+int MME1536_ExpPinned_m(MME1536 * device_instance, int * result, MME1536_Pinned * base, int * e, int t);
+int MME1536_MMEPinned_m(MME1536 * device_instance, int * result, MME1536_Pinned * base0, MME1536_Pinned * base1, int * e0, int * e1, int t);
+int MME1536_FixedBaseInit_m(MME1536 * device_instance, MME1536_FixedBase * base, int * g, int t);
+int MME1536_ExpFixed_m(MME1536 * device_instance, int * result, MME1536_FixedBase * base, int * e, int t);
+int MME1536_ValueExp_m(MME1536 * device_instance, MME1536_Value * value, int * g, int * e, int t);
+int MME1536_ValueLoad_m(MME1536 * device_instance, MME1536_Value * value, int * x);
+int MME1536_ValueMultiply_m(MME1536 * device_instance, MME1536_Value * result, MME1536_Value * x, MME1536_Value * y);
+int MME1536_ValueRead_m(MME1536 * device_instance, int * result, MME1536_Value * value);
+void MME1536_ValueRelease(MME1536 * device_instance, MME1536_Value * value);
+int MME1536_ExpBatch_m(MME1536 * device_instance, int ** results, int ** bases, int ** exps, int count, int t);
+int MME1536_MME_m(MME1536 * device_instance, int * result, int * g0, int * g1, int * e0, int * e1, int t);
 
 void MME1536_StartSingle(MME1536 * device_instance, int p_sel, int destination, int x_op, int y_op);
 void MME1536_StartAuto(MME1536 * device_instance, int p_sel);
-void MME1536_WaitUntilReady(MME1536 * device_instance);
+int MME1536_WaitUntilReady(MME1536 * device_instance);
+int MME1536_SetWaitBudget(MME1536 * device_instance, long base_us, int ns_per_bit);
+int MME1536_ResetHardware(MME1536 * device_instance);
+int MME1536_SetWaitMode(MME1536 * device_instance, int mode, int spin_us);
 void MME1536_StartSingle_m(MME1536 * device_instance, int destination, int x_op, int y_op);
 void MME1536_StartAuto_m(MME1536 * device_instance);
+int MME1536_SetStartHold(MME1536 * device_instance, int cycles);
+int MME1536_SetTransferMode(MME1536 * device_instance, int mode);
+int MME1536_GetTransferMode(MME1536 * device_instance);
+int MME1536_DmaAttach(MME1536 * device_instance, char * dma_uio_dev, char * buffer_dev);
+void MME1536_DmaDetach(MME1536 * device_instance);
+
+void MME1536_CmdInit(MME1536_CmdList * list);
+int MME1536_CmdSingle(MME1536_CmdList * list, int p_sel, int destination, int x_op, int y_op);
+int MME1536_CmdAuto(MME1536_CmdList * list, int p_sel);
+int MME1536_CmdLoad(MME1536_CmdList * list, int * data, int operand, int length);
+int MME1536_CmdExponent(MME1536_CmdList * list, int * e0, int * e1, int t);
+int MME1536_CmdExponentImage(MME1536_CmdList * list, MME1536_ExpImage * image);
+int MME1536_CmdRead(MME1536_CmdList * list, int * data, int operand, int length);
+int MME1536_CmdSubmit(MME1536 * device_instance, MME1536_CmdList * list);
+int MME1536_CmdSubmitPair(MME1536 * device_instance, MME1536_CmdList * list0, MME1536_CmdList * list1);
+int MME1536_SetSplitPipeline(MME1536 * device_instance, int enable);
+int MME1536_MMEPair(MME1536 * device_instance, MME1536_Op * op0, MME1536_Op * op1);
+
+int MME1536_GetFd(MME1536 * device_instance);
+int MME1536_SubmitMME(MME1536 * device_instance, MME1536_Job * job, int * result, int * g0, int * g1, int * m, int * e0, int * e1, int n, int t);
+int MME1536_SubmitExp(MME1536 * device_instance, MME1536_Job * job, int * result, int * g, int * m, int * e, int n, int t);
+int MME1536_SubmitMultiply_m(MME1536 * device_instance, MME1536_Job * job, int * result, int * x, int * y);
+int MME1536_SubmitExp_m(MME1536 * device_instance, MME1536_Job * job, int * result, int * g, int * e, int t);
+int MME1536_SubmitMME_m(MME1536 * device_instance, MME1536_Job * job, int * result, int * g0, int * g1, int * e0, int * e1, int t);
+int MME1536_Poll(MME1536 * device_instance);
+int MME1536_Complete(MME1536 * device_instance, MME1536_Job * job);
+
+unsigned int MME1536_ModulusHash(int * m, int n);
+void MME1536_GetCacheStats(MME1536 * device_instance, unsigned long * hits, unsigned long * misses);
+
+int MME1536_SetStats(MME1536 * device_instance, int enable);
+void MME1536_GetStats(MME1536 * device_instance, MME1536_Stats * snapshot);
+void MME1536_ResetStats(MME1536 * device_instance);
+unsigned long long MME1536_StatsPercentile(MME1536_Stats * snapshot, double p);
+unsigned long long MME1536_StatsBucketValue(int bucket);
+
+int MME1536_ArenaInit(MME1536 * device_instance, int depth, int t);
+MME1536_JobBuf * MME1536_ArenaBorrow(MME1536 * device_instance);
+void MME1536_ArenaReturn(MME1536 * device_instance, MME1536_JobBuf * buf);
 
 void MME1536_PrintInfo(MME1536 * device_instance);
 void MME1536_PrintOperands(MME1536 * device_instance);
 
-void MME1536_SetExponent(MME1536 * device_instance, int * e0, int * e1, int t);
+int MME1536_SetExponent(MME1536 * device_instance, int * e0, int * e1, int t);
+MME1536_ExpImage * MME1536_EncodeExponent(int * e0, int * e1, int t);
+int MME1536_EncodeExponentInto(MME1536_ExpImage * image, int * e0, int * e1, int t);
+void MME1536_FreeExponent(MME1536_ExpImage * image);
+int MME1536_SetExponentImage(MME1536 * device_instance, MME1536_ExpImage * image);
+int MME1536_SetFifoStreaming(MME1536 * device_instance, int enable, int depth);
+int MME1536_PollInterval(MME1536 * device_instance);
 int MME1536_SetOperand(MME1536 * device_instance, int * operand_data, int operand, int length);
 int MME1536_GetOperand(MME1536 * device_instance, int * operand_data, int operand, int length);
 int MME1536_SetOperand_m(MME1536 * device_instance, int * operand_data, int operand);
 int MME1536_GetOperand_m(MME1536 * device_instance, int * operand_data, int operand);
-/** @todo
- *     1) implement MME1536_ResetHardware() ?
- *     2) max fifo size -> error checking
- */
 
 #endif /*_LIBMME1536_*/
 
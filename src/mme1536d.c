@@ -0,0 +1,93 @@
+/** Broker daemon for the mme1536 library: owns the mod_sim_exp hardware
+ *  core and runs the jobs of the processes connected to its socket
+ *  (libmme1536_shm.c), so several programs can share the core.
+ *
+ *  Every client gets D job slots; the broker takes up to SHM_QUANTUM jobs
+ *  from each client in turn and keeps at most SHM_INFLIGHT jobs on the
+ *  core. SIGINT or SIGTERM stops the broker once the jobs on the core are
+ *  done. With the emu option the broker runs on the software model of the
+ *  core (libmme1536_emu.c).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "libmme1536_v1.h"
+#include "libmme1536_emu.h"
+#include "libmme1536_shm.h"
+
+// large: one job per slot of every client
+static MME1536_Broker broker;
+
+void handle_stop(int signal){
+	(void)signal;
+	atomic_store(&(broker.stop), 1);
+}
+
+void printUsage(){
+	printf("\nUsage: mme1536d [S] [D] [emu]\n S:\tpath of the socket (default %s)\n D:\tthe nr. of job slots per client (default %d, at most %d)\n emu:\trun on the software model of the core\n", SHM_SOCKET_PATH, SHM_DEPTH, SHM_MAX_DEPTH);
+}
+
+/***********************************************************************
+ * Main                                                                *
+ **********************************************************************/
+
+int main(int argc, char *argv[]){
+	char * path = SHM_SOCKET_PATH;
+	int depth = SHM_DEPTH;
+	int emu = 0;
+	int ret;
+	struct sigaction action;
+
+	/* Check arguments. */
+	if((argc >= 2) && (strcmp(argv[argc - 1], "emu") == 0)){
+		emu = 1;
+		argc--;
+	}
+	if(argc > 3){
+		printUsage();
+		return 1;
+	}
+	if(argc >= 2) path = argv[1];
+	if(argc == 3){
+		depth = atoi(argv[2]);
+		if((depth < 1) || (depth > SHM_MAX_DEPTH)){
+			printUsage();
+			return 1;
+		}
+	}
+
+	/* Hardware config */
+	MME1536 mme_hw;
+	MME1536_Emu mme_emu;
+	if(emu){
+		if(MME1536_EmuInitialize(&mme_hw, &mme_emu, NULL) != 0){
+			return 1;
+		}
+	}
+	else if(MME1536_Initialize(&mme_hw, DEFAULT_UIO_DEV) != 0){
+		return 1;
+	}
+
+	/* Broker */
+	if(MME1536_BrokerStart(&broker, &mme_hw, path) != 0){
+		MME1536_Clean(&mme_hw);
+		return 1;
+	}
+	MME1536_BrokerLimits(&broker, depth, SHM_QUANTUM, SHM_INFLIGHT);
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = handle_stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	printf("[INFO] mme1536d: listening on %s (%d slots per client)\n", path, depth);
+	ret = MME1536_BrokerRun(&broker);
+
+	/* Cleanup */
+	MME1536_BrokerStop(&broker);
+	MME1536_Clean(&mme_hw);
+
+	return (ret == 0) ? 0 : 1;
+}